@@ -1,3 +1,8 @@
+-- Canali del deck, fissati a compile time (default 5 + 5):
+--   premake5 vs2022 --deck-sliders=16 --deck-buttons=16
+newoption { trigger = "deck-sliders", value = "N", description = "Numero di slider del deck (default 5)" }
+newoption { trigger = "deck-buttons", value = "N", description = "Numero di bottoni del deck, max 64 (default 5)" }
+
 workspace "Controller-Deck"
    architecture "x64"
    configurations { "Debug", "Release", "Dist" }
@@ -12,6 +17,12 @@ workspace "Controller-Deck"
       defines { "_HAS_EXCEPTIONS=1", "FMT_USE_EXCEPTIONS=1" }  -- ✅ forza eccezioni anche per fmt
    filter {}
 
+   -- ✅ Stesso numero di canali in tutti i progetti (DeckState è condiviso)
+   defines {
+      "CONTROLLER_DECK_SLIDERS=" .. (_OPTIONS["deck-sliders"] or "5"),
+      "CONTROLLER_DECK_BUTTONS=" .. (_OPTIONS["deck-buttons"] or "5")
+   }
+
 OutputDir = "%{cfg.system}-%{cfg.architecture}/%{cfg.buildcfg}"
 
 group "Core"
@@ -20,3 +31,12 @@ group ""
 
 include "Controller-Deck-App/Build-App.lua"
 includedirs { "ThirdParty/cpp-httplib" }
+
+group "Tools"
+   include "Controller-Deck-Bench/Build-Bench.lua"
+   -- l'emulatore usa pseudo-terminali POSIX: solo Linux
+   if os.istarget("linux") then
+      include "Controller-Deck-Emulator/Build-Emulator.lua"
+   end
+group ""
+
@@ -3,6 +3,7 @@
 #include <fmt/format.h>
 #include <regex>
 #include <cstring>
+#include <cstdint>
 #include "utils/Log.hpp"
 
 using Json = nlohmann::json;
@@ -149,12 +150,17 @@ void ApiServer::installRoutes() {
         setCORSHeaders(res);
         });
 
-    // GET /state  (supporta ?verbose=1)
+    // GET /state  (supporta ?verbose=1 e ?device=<id>)
     m_srv->Get("/state", [this](const httplib::Request& req, httplib::Response& res) {
         try {
             const bool verbose = (req.has_param("verbose") && req.get_param_value("verbose") == "1");
             nlohmann::json out;
-            if (verbose && m_cbs.getStateJsonVerbose) out = m_cbs.getStateJsonVerbose();
+            if (req.has_param("device")) {
+                if (!m_cbs.getDeviceStateJson) { fail(res, 500, "not_available"); setCORSHeaders(res); return; }
+                out = m_cbs.getDeviceStateJson(req.get_param_value("device"));
+                if (out.is_null()) { fail(res, 404, "unknown_device"); setCORSHeaders(res); return; }
+            }
+            else if (verbose && m_cbs.getStateJsonVerbose) out = m_cbs.getStateJsonVerbose();
             else if (m_cbs.getStateJson)             out = m_cbs.getStateJson();
             else { fail(res, 500, "not_available"); setCORSHeaders(res); return; }
 
@@ -165,6 +171,42 @@ void ApiServer::installRoutes() {
         setCORSHeaders(res);
     });
 
+    // GET /state/history?channel=<slider>&from=<ms>&to=<ms>&maxPoints=<n>[&source=raw|filtered][&device=<id>]
+    // Tempi in ms sul clock dello storico ("now" nella risposta); negativi = relativi ad adesso.
+    // Default: ultimi 10 s, 500 punti, valori filtrati, primo device.
+    m_srv->Get("/state/history", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!m_cbs.getHistoryJson) { fail(res, 500, "not_available"); setCORSHeaders(res); return; }
+        if (!req.has_param("channel")) { fail(res, 400, "missing_channel"); setCORSHeaders(res); return; }
+
+        auto intParam = [&req](const char* name, int64_t def, int64_t& out) {
+            if (!req.has_param(name)) { out = def; return true; }
+            try {
+                size_t pos = 0;
+                const std::string v = req.get_param_value(name);
+                out = std::stoll(v, &pos);
+                return pos == v.size();
+            }
+            catch (...) { return false; }
+        };
+        int64_t channel = 0, from = 0, to = 0, maxPoints = 0;
+        if (!intParam("channel", 0, channel) || !intParam("from", -10000, from) ||
+            !intParam("to", INT64_MAX, to) || !intParam("maxPoints", 500, maxPoints) ||
+            maxPoints < 1 || maxPoints > 5000 || channel < 0 || channel > 255) {
+            fail(res, 400, "bad_param"); setCORSHeaders(res); return;
+        }
+        std::string err;
+        try {
+            auto out = m_cbs.getHistoryJson(req.get_param_value("device"), static_cast<int>(channel),
+                                            req.get_param_value("source"), from, to, static_cast<int>(maxPoints), err);
+            if (out.is_null()) fail(res, err == "unknown_device" ? 404 : 400, err.empty() ? "bad_request" : err);
+            else ok(res, out);
+        }
+        catch (const std::exception& e) {
+            fail(res, 500, e.what());
+        }
+        setCORSHeaders(res);
+        });
+
     // GET /layout
     m_srv->Get("/layout", [this](const httplib::Request&, httplib::Response& res) {
         if (!m_cbs.getLayoutJson) { fail(res, 404, "not_supported"); setCORSHeaders(res); return; }
@@ -239,6 +281,14 @@ void ApiServer::installRoutes() {
         setCORSHeaders(res);
         });
 
+    // GET /metrics/latency  (?reset=1 azzera gli istogrammi dopo la lettura)
+    m_srv->Get("/metrics/latency", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!m_cbs.getLatencyJson) { fail(res, 500, "not_available"); setCORSHeaders(res); return; }
+        const bool reset = (req.has_param("reset") && req.get_param_value("reset") == "1");
+        ok(res, m_cbs.getLatencyJson(reset));
+        setCORSHeaders(res);
+        });
+
     // GET /serial/ports
     m_srv->Get("/serial/ports", [this](const httplib::Request&, httplib::Response& res) {
         if (!m_cbs.listSerialPorts) { fail(res, 500, "not_available"); setCORSHeaders(res); return; }
@@ -256,10 +306,68 @@ void ApiServer::installRoutes() {
             auto j = Json::parse(req.body);
             std::string port = j.value("port", "");
             unsigned baud = j.value("baud", 115200u);
+            std::string device = j.value("device", "");
             if (port.empty()) { fail(res, 400, "missing_port"); setCORSHeaders(res); return; }
             std::string err;
-            if (!m_cbs.selectSerialPort(port, baud, err)) { fail(res, 400, err.empty() ? "select_failed" : err); }
-            else { ok(res, Json{ {"selected", port}, {"baud", baud} }); }
+            if (!m_cbs.selectSerialPort(port, baud, device, err)) { fail(res, err == "unknown_device" ? 404 : 400, err.empty() ? "select_failed" : err); }
+            else { ok(res, Json{ {"selected", port}, {"baud", baud}, {"device", device} }); }
+        }
+        catch (...) {
+            fail(res, 400, "bad_json");
+        }
+        setCORSHeaders(res);
+        });
+
+    // POST /serial/capture/start   { "path": "deck.cdcap", "device": "<id>" }
+    // path: solo nome di file, nella cartella captures accanto a config.json; mai sovrascritto
+    m_srv->Post("/serial/capture/start", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!m_cbs.startSerialCapture) { fail(res, 500, "not_available"); setCORSHeaders(res); return; }
+        try {
+            auto j = Json::parse(req.body);
+            std::string path = j.value("path", "");
+            std::string device = j.value("device", "");
+            if (path.empty()) { fail(res, 400, "missing_path"); setCORSHeaders(res); return; }
+            std::string err;
+            if (!m_cbs.startSerialCapture(device, path, err)) { fail(res, err == "unknown_device" ? 404 : err == "file_exists" ? 409 : 400, err.empty() ? "capture_failed" : err); }
+            else { ok(res, Json{ {"capturing", true}, {"path", path}, {"device", device} }); }
+        }
+        catch (...) {
+            fail(res, 400, "bad_json");
+        }
+        setCORSHeaders(res);
+        });
+
+    // POST /serial/capture/stop   { "device": "<id>" } (body opzionale: default primo device)
+    m_srv->Post("/serial/capture/stop", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!m_cbs.stopSerialCapture) { fail(res, 500, "not_available"); setCORSHeaders(res); return; }
+
+        std::string device;
+        if (!req.body.empty()) {
+            try { device = Json::parse(req.body).value("device", ""); }
+            catch (...) { fail(res, 400, "bad_json"); setCORSHeaders(res); return; }
+        }
+
+        std::string err;
+        auto out = m_cbs.stopSerialCapture(device, err);
+        if (out.is_null()) fail(res, err == "unknown_device" ? 404 : 409, err.empty() ? "not_capturing" : err);
+        else ok(res, out);
+        setCORSHeaders(res);
+        });
+
+    // POST /serial/replay   { "path": "deck.cdcap", "speed": 1, "device": "<id>" }
+    // speed: 1 = tempo reale, N = N volte più veloce, 0 = senza attese. Sostituisce la porta del device.
+    m_srv->Post("/serial/replay", [this](const httplib::Request& req, httplib::Response& res) {
+        if (!m_cbs.replaySerialCapture) { fail(res, 500, "not_available"); setCORSHeaders(res); return; }
+        try {
+            auto j = Json::parse(req.body);
+            std::string path = j.value("path", "");
+            std::string device = j.value("device", "");
+            double speed = j.value("speed", 1.0);
+            if (path.empty()) { fail(res, 400, "missing_path"); setCORSHeaders(res); return; }
+            if (!(speed >= 0.0)) { fail(res, 400, "bad_speed"); setCORSHeaders(res); return; }
+            std::string err;
+            if (!m_cbs.replaySerialCapture(device, path, speed, err)) { fail(res, err == "unknown_device" ? 404 : 400, err.empty() ? "replay_failed" : err); }
+            else { ok(res, Json{ {"replaying", true}, {"path", path}, {"speed", speed}, {"device", device} }); }
         }
         catch (...) {
             fail(res, 400, "bad_json");
@@ -267,13 +375,19 @@ void ApiServer::installRoutes() {
         setCORSHeaders(res);
         });
 
-    // POST /serial/close
-    m_srv->Post("/serial/close", [this](const httplib::Request&, httplib::Response& res) {
+    // POST /serial/close   { "device": "<id>" } (body opzionale: default primo device)
+    m_srv->Post("/serial/close", [this](const httplib::Request& req, httplib::Response& res) {
         if (!m_cbs.closeSerialPort) { fail(res, 500, "not_available"); setCORSHeaders(res); return; }
 
+        std::string device;
+        if (!req.body.empty()) {
+            try { device = Json::parse(req.body).value("device", ""); }
+            catch (...) { fail(res, 400, "bad_json"); setCORSHeaders(res); return; }
+        }
+
         std::string err;
         try {
-            if (m_cbs.closeSerialPort(err)) {
+            if (m_cbs.closeSerialPort(device, err)) {
                 ok(res, Json{ {"closed", true}, {"message", "Connessione seriale chiusa; in attesa di nuova selezione"} });
             }
             else {
@@ -407,6 +521,8 @@ void ApiServer::installRoutes() {
         ok(res, Json{ {"routes", Json::array({
             "/health", "/version", "/config", "/state", "/layout",
             "/events/state", "/serial/ports", "/serial/select", "/serial/close",
+            "/serial/capture/start (POST)", "/serial/capture/stop (POST)", "/serial/replay (POST)",
+            "/metrics/latency", "/state/history",
             "/audio/devices", "/audio/processes",
             "/control/shutdown (POST)", "/shutdown (POST)",
             "/audio/device/select (POST)", "/audio/device/volume (POST)",
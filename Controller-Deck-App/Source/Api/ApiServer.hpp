@@ -9,6 +9,7 @@
 #include <deque>
 #include <condition_variable>
 #include <chrono>
+#include <cstdint>
 
 // Assicurati che in premake ci sia: includedirs { "ThirdParty/cpp-httplib" }
 #include <../ThirdParty/cpp-httplib/httplib.h>
@@ -20,6 +21,7 @@ public:
     struct Callbacks {
         // Letture
         std::function<Json()> getStateJson;
+        std::function<Json(const std::string& device)> getDeviceStateJson;   // null se device sconosciuto
         std::function<Json()> getConfigJson;
         std::function<Json()> getVersionJson;
 
@@ -29,16 +31,26 @@ public:
 
         // Seriale
         std::function<std::vector<std::string>()> listSerialPorts;
-        std::function<bool(const std::string& port, unsigned baud, std::string& err)> selectSerialPort;
+        // device vuoto = primo device della config
+        std::function<bool(const std::string& port, unsigned baud, const std::string& device, std::string& err)> selectSerialPort;
 
         // chiusura seriale
-        std::function<bool(std::string& err)> closeSerialPort;
+        std::function<bool(const std::string& device, std::string& err)> closeSerialPort;
+
+        // cattura/replay della seriale (device vuoto = primo device)
+        std::function<bool(const std::string& device, const std::string& path, std::string& err)> startSerialCapture;
+        std::function<Json(const std::string& device, std::string& err)> stopSerialCapture;   // null se nessuna cattura
+        std::function<bool(const std::string& device, const std::string& path, double speed, std::string& err)> replaySerialCapture;
 
         // processi/dispositivi aufio info
         std::function<nlohmann::json()> getAudioDevicesJson;
 		std::function<nlohmann::json()> getAudioProcessesJson;
         
         std::function<nlohmann::json()> getSerialStatusJson;
+        std::function<nlohmann::json(bool /*reset*/)> getLatencyJson;  // /metrics/latency
+        // /state/history: null + err se device/canale/sorgente non validi
+        std::function<nlohmann::json(const std::string& /*device*/, int /*channel*/, const std::string& /*source*/,
+                                     int64_t /*fromMs*/, int64_t /*toMs*/, int /*maxPoints*/, std::string& /*err*/)> getHistoryJson;
         std::function<nlohmann::json()> getLayoutJson;               // /layout
         std::function<nlohmann::json()> getStateJsonVerbose;         // /state?verbose=1
         std::function<bool(nlohmann::json&, int /*timeoutMs*/)> popNextStateEvent; // SSE
@@ -7,14 +7,22 @@
 ApiServer::Callbacks ApiWiring::MakeCallbacks(MainApp& app) {
     ApiServer::Callbacks cbs;
     cbs.getStateJson = [&app]() { return app.getStateJson(); };
+    cbs.getDeviceStateJson = [&app](const std::string& device) { return app.getDeviceStateJson(device); };
     cbs.getConfigJson = [&app]() { return app.getConfigJson(); };
     cbs.validateConfigJson = [&app](const nlohmann::json& j, std::string& err) { return app.validateConfigJson(j, err); };
     cbs.setConfigJsonStrict = [&app](const nlohmann::json& j, std::string& err) { return app.setConfigJsonStrict(j, err); };
     cbs.listSerialPorts = [&app]() { return app.listSerialPorts(); };
-    cbs.selectSerialPort = [&app](const std::string& port, unsigned baud, std::string& err) {
-        return app.selectSerialPort(port, baud, err);
+    cbs.selectSerialPort = [&app](const std::string& port, unsigned baud, const std::string& device, std::string& err) {
+        return app.selectSerialPort(port, baud, device, err);
+        };
+    cbs.closeSerialPort = [&app](const std::string& device, std::string& err) { return app.closeSerialPort(device, err); };
+    cbs.startSerialCapture = [&app](const std::string& device, const std::string& path, std::string& err) {
+        return app.startSerialCapture(device, path, err);
+        };
+    cbs.stopSerialCapture = [&app](const std::string& device, std::string& err) { return app.stopSerialCapture(device, err); };
+    cbs.replaySerialCapture = [&app](const std::string& device, const std::string& path, double speed, std::string& err) {
+        return app.replaySerialCapture(device, path, speed, err);
         };
-    cbs.closeSerialPort = [&app](std::string& err) { return app.closeSerialPort(err); };
     cbs.getAudioDevicesJson = []() { return AudioDiscovery::EnumerateDevicesJson(); };
     cbs.getAudioProcessesJson = [&app]() {
         return AudioDiscovery::EnumerateProcessesJson([&app](DWORD pid) { return app.isProcessFullscreen(pid); });
@@ -26,6 +34,11 @@ ApiServer::Callbacks ApiWiring::MakeCallbacks(MainApp& app) {
         return app.popNextStateEventBlocking(out, std::chrono::milliseconds(timeoutMs));
         };
     cbs.getSerialStatusJson = [&app]() { return app.getSerialStatusJson(); };
+    cbs.getLatencyJson = [&app](bool reset) { return app.getLatencyJson(reset); };
+    cbs.getHistoryJson = [&app](const std::string& device, int channel, const std::string& source,
+                                int64_t from, int64_t to, int maxPoints, std::string& err) {
+        return app.getHistoryJson(device, channel, source, from, to, maxPoints, err);
+        };
 
     cbs.requestShutdown = [&app]() { app.requestShutdown(); }; 
     cbs.selectAudioDeviceById = [&app](const std::string& id, std::string& err) {
@@ -4,11 +4,15 @@
 #include <vector>
 #include <optional>
 #include "Core/Actions/Hotkey.hpp"
+#include "Core/Audio/AppTargetSet.hpp"
+#include "Core/Audio/VolumeCurve.hpp"
+#include "Core/DeckState.hpp"
+#include "Core/Serial/FaderFilterChain.hpp"   // FilterChainConfig
 
 // Target di uno slider
 struct SliderTarget {
     bool isMaster = false;                 // true -> controlla master volume
-    std::vector<std::string> exes;         // altrimenti elenco exe (lower-case)
+    AppTargetSet apps;                     // altrimenti insieme di exe (lower-case), applicato in una passata
 };
 
 // Tipi di azione per i bottoni (in ordine di esecuzione)
@@ -28,13 +32,54 @@ struct ButtonAction {
     unsigned       delayMs = 0; // valido per Delay
 };
 
-struct AppConfig {
+// Press di un bottone mentre la sua macro precedente è ancora in corso
+enum class MacroPolicy {
+    Queue,                // parte quando finisce la precedente (default: come l'esecuzione in linea)
+    Restart,              // annulla la precedente (e quelle in coda) e riparte da capo
+    Ignore                // scarta il press
+};
+
+// Mapping di un singolo deck
+struct DeckMapping {
+    // SLIDERS (DeckState::kSliders canali)
+    std::array<std::optional<SliderTarget>, DeckState::kSliders> sliderMap;
+    // curva conteggi -> volume per slider, compilata dal blocco "curve" (default lineare)
+    std::array<VolumeLut, DeckState::kSliders> sliderCurve;
+
+    // BUTTONS (DeckState::kButtons canali) — lista ordinata di azioni
+    std::array<std::vector<ButtonAction>, DeckState::kButtons> buttonActions;
+    std::array<MacroPolicy, DeckState::kButtons> buttonPolicy{};   // "policy" del bottone (forma oggetto)
+};
+
+// Un deck collegato: porta seriale + mapping nel proprio namespace
+struct DeviceConfig {
+    std::string id = "default";            // usato da /state, SSE, /serial/*
     std::string port = "auto";
     unsigned baud = 115200;
+    unsigned debounceMs = 5;               // serial.debounce_ms: finestra di debounce dei bottoni (0 = off)
+    DeckMapping mapping;
+
+    // Catena di filtri dei fader (blocchi opzionali "filters" e "smoothing";
+    // default: smoothing EMA deadband 2 / alpha 0.20, poi min_delta 10 conteggi)
+    FilterChainConfig filters{};
+};
+
+struct AppConfig {
+    // Almeno un device. Il formato "legacy" (serial + mapping in radice)
+    // produce un solo device con id "default".
+    std::vector<DeviceConfig> devices;
+
+    // Blocco opzionale "audio" in radice, comune a tutti i deck
+    double audioMaxRateHz = 60.0;          // audio.max_rate_hz: scritture di volume/s per target (0 = nessun limite)
 
-    // SLIDERS (5 canali)
-    std::array<std::optional<SliderTarget>, 5> sliderMap;
+    static constexpr size_t kMaxDevices = 64;
 
-    // BUTTONS (5 canali) — lista ordinata di azioni
-    std::array<std::vector<ButtonAction>, 5> buttonActions;
+    const DeviceConfig* find(const std::string& id) const {
+        for (const auto& d : devices) if (d.id == id) return &d;
+        return nullptr;
+    }
+    DeviceConfig* find(const std::string& id) {
+        for (auto& d : devices) if (d.id == id) return &d;
+        return nullptr;
+    }
 };
@@ -19,21 +19,23 @@ static bool MediaNameToChord(const std::string& nameLower, HotkeyChord& out) {
     return false;
 }
 
-static bool parseSliderValue(AppConfig& cfg, std::string& outErr, size_t i, const json& v) {
+static bool parseSliderValue(DeckMapping& cfg, std::string& outErr, size_t i, const json& v) {
     SliderTarget tgt;
     if (v.is_string()) {
         std::string s = toLower(v.get<std::string>());
         if (s == "master_volume") { tgt.isMaster = true; cfg.sliderMap[i] = tgt; }
-        else { tgt.isMaster = false; tgt.exes.push_back(std::move(s)); cfg.sliderMap[i] = tgt; }
+        else { tgt.isMaster = false; tgt.apps = AppTargetSet({ std::move(s) }); cfg.sliderMap[i] = tgt; }
         return true;
     }
     else if (v.is_array()) {
         tgt.isMaster = false;
+        std::vector<std::string> exes;
         for (auto& e : v) {
             if (!e.is_string()) { outErr = "sliders[" + std::to_string(i) + "] contiene elementi non stringa."; return false; }
-            tgt.exes.push_back(toLower(e.get<std::string>()));
+            exes.push_back(toLower(e.get<std::string>()));
         }
-        if (tgt.exes.empty()) { outErr = "sliders[" + std::to_string(i) + "] array vuoto."; return false; }
+        if (exes.empty()) { outErr = "sliders[" + std::to_string(i) + "] array vuoto."; return false; }
+        tgt.apps = AppTargetSet(exes);
         cfg.sliderMap[i] = tgt;
         return true;
     }
@@ -44,7 +46,7 @@ static bool parseSliderValue(AppConfig& cfg, std::string& outErr, size_t i, cons
     return false;
 }
 
-static bool pushButtonAction(AppConfig& cfg, std::string& outErr, size_t i, const std::string& sRaw) {
+static bool pushButtonAction(DeckMapping& cfg, std::string& outErr, size_t i, const std::string& sRaw) {
     std::string s = toLower(sRaw);
 
     // toggle_mute (master o app)
@@ -110,7 +112,7 @@ static bool pushButtonAction(AppConfig& cfg, std::string& outErr, size_t i, cons
     return false;
 }
 
-static bool parseButtonValue(AppConfig& cfg, std::string& outErr, size_t i, const json& b) {
+static bool parseButtonValue(DeckMapping& cfg, std::string& outErr, size_t i, const json& b) {
     if (b.is_null()) return true;
     if (b.is_string()) {
         return pushButtonAction(cfg, outErr, i, b.get<std::string>());
@@ -123,47 +125,314 @@ static bool parseButtonValue(AppConfig& cfg, std::string& outErr, size_t i, cons
         }
         return true;
     }
-    outErr = "buttons[" + std::to_string(i) + "] deve essere stringa, array o null.";
+    // forma oggetto: { "actions": <stringa|array>, "policy": "queue"|"restart"|"ignore" }
+    if (b.is_object()) {
+        const std::string key = "buttons[" + std::to_string(i) + "]";
+        if (!b.contains("actions") || !(b["actions"].is_string() || b["actions"].is_array())) { outErr = key + ".actions mancante o non stringa/array."; return false; }
+        if (!parseButtonValue(cfg, outErr, i, b["actions"])) return false;
+        if (b.contains("policy")) {
+            const std::string p = b["policy"].is_string() ? toLower(b["policy"].get<std::string>()) : std::string();
+            if (p == "queue") cfg.buttonPolicy[i] = MacroPolicy::Queue;
+            else if (p == "restart") cfg.buttonPolicy[i] = MacroPolicy::Restart;
+            else if (p == "ignore") cfg.buttonPolicy[i] = MacroPolicy::Ignore;
+            else { outErr = key + ".policy deve essere 'queue', 'restart' o 'ignore'."; return false; }
+        }
+        return true;
+    }
+    outErr = "buttons[" + std::to_string(i) + "] deve essere stringa, array, oggetto o null.";
     return false;
 }
 
+// Parametri di smoothing di un oggetto ("smoothing" o un suo "sliders[i]"):
+// solo le chiavi presenti sovrascrivono p. key = prefisso per i messaggi d'errore.
+static bool parseSmoothingParams(FaderSmoothingParams& p, std::string& outErr, const json& o, const std::string& key) {
+    if (o.contains("mode")) {
+        const std::string m = o["mode"].is_string() ? toLower(o["mode"].get<std::string>()) : std::string();
+        if (m == "ema") p.mode = SmoothingMode::Ema;
+        else if (m == "one_euro") p.mode = SmoothingMode::OneEuro;
+        else { outErr = "'" + key + "mode' deve essere 'ema' o 'one_euro'."; return false; }
+    }
+    if (o.contains("deadband")) {
+        if (!o["deadband"].is_number_unsigned()) { outErr = "'" + key + "deadband' deve essere un intero >= 0."; return false; }
+        p.deadband_counts = o["deadband"].get<int>();
+    }
+
+    // numero in [lo, hi] (hi escluso se openHi); lo escluso se openLo
+    auto number = [&](const char* name, float& dst, float lo, float hi, bool openLo) {
+        if (!o.contains(name)) return true;
+        const auto& v = o[name];
+        const double d = v.is_number() ? v.get<double>() : -1.0;
+        if (!v.is_number() || d < lo || (openLo && d == lo) || d > hi) {
+            outErr = "'" + key + name + "' fuori range (" + (openLo ? "> " : ">= ") + fmt::format("{}", lo) + ", <= " + fmt::format("{}", hi) + ").";
+            return false;
+        }
+        dst = static_cast<float>(d);
+        return true;
+    };
+    return number("alpha", p.alpha, 0.f, 1.f, false)
+        && number("min_cutoff", p.min_cutoff, 0.f, 1000.f, true)
+        && number("beta", p.beta, 0.f, 1000.f, false)
+        && number("d_cutoff", p.d_cutoff, 0.f, 1000.f, true);
+}
+
+// Blocco opzionale "smoothing": valori comuni a tutti i fader + override per fader in "sliders"
+static bool parseSmoothing(DeviceConfig& dev, std::string& outErr, const json& j, const std::string& key) {
+    if (!j.contains("smoothing")) return true;
+    const auto& sm = j["smoothing"];
+    const std::string sk = key + "smoothing.";
+    if (!sm.is_object()) { outErr = "'" + key + "smoothing' deve essere un oggetto."; return false; }
+
+    FaderSmoothingParams common{};
+    if (!parseSmoothingParams(common, outErr, sm, sk)) return false;
+    dev.filters.smoothing.fill(common);
+
+    if (!sm.contains("sliders")) return true;
+    const auto& per = sm["sliders"];
+    if (!per.is_array()) { outErr = "'" + sk + "sliders' deve essere un array."; return false; }
+    if (per.size() > DeckState::kSliders) { outErr = "'" + sk + "sliders' può contenere al massimo " + std::to_string(DeckState::kSliders) + " elementi."; return false; }
+    for (size_t i = 0; i < per.size(); ++i) {
+        if (per[i].is_null()) continue; // usa i valori comuni
+        const std::string ik = sk + "sliders[" + std::to_string(i) + "].";
+        if (!per[i].is_object()) { outErr = "'" + ik.substr(0, ik.size() - 1) + "' deve essere un oggetto o null."; return false; }
+        if (!parseSmoothingParams(dev.filters.smoothing[i], outErr, per[i], ik)) return false;
+    }
+    return true;
+}
+
+// Parametri di una curva ("curve" o un suo "sliders[i]"): stringa = solo il tipo,
+// oggetto = solo le chiavi presenti sovrascrivono c. key = prefisso per i messaggi d'errore.
+static bool parseCurveParams(VolumeCurveConfig& c, std::string& outErr, const json& o, const std::string& key) {
+    const bool shorthand = o.is_string();
+    if (shorthand || o.contains("type")) {
+        const json& t = shorthand ? o : o["type"];
+        const std::string type = t.is_string() ? toLower(t.get<std::string>()) : std::string();
+        if (type == "linear") c.kind = VolumeCurveKind::Linear;
+        else if (type == "db" || type == "log") c.kind = VolumeCurveKind::Db;
+        else if (type == "audio_taper") c.kind = VolumeCurveKind::AudioTaper;
+        else if (type == "points") c.kind = VolumeCurveKind::Points;
+        else { outErr = "'" + key + "type' deve essere 'linear', 'db', 'audio_taper' o 'points'."; return false; }
+        if (shorthand) return true;
+    }
+    if (o.contains("range_db")) {
+        const auto& v = o["range_db"];
+        if (!v.is_number() || v.get<double>() <= 0.0 || v.get<double>() > 120.0) { outErr = "'" + key + "range_db' fuori range (> 0, <= 120)."; return false; }
+        c.rangeDb = v.get<float>();
+    }
+    if (o.contains("points")) {
+        const auto& pts = o["points"];
+        const std::string msg = "'" + key + "points' deve essere un array di almeno 2 coppie [corsa, volume] in 0..1 con corsa crescente.";
+        if (!pts.is_array() || pts.size() < 2) { outErr = msg; return false; }
+        c.points.clear();
+        for (const auto& p : pts) {
+            if (!p.is_array() || p.size() != 2 || !p[0].is_number() || !p[1].is_number()) { outErr = msg; return false; }
+            const float x = p[0].get<float>(), y = p[1].get<float>();
+            if (x < 0.f || x > 1.f || y < 0.f || y > 1.f || (!c.points.empty() && x <= c.points.back().first)) { outErr = msg; return false; }
+            c.points.emplace_back(x, y);
+        }
+    }
+    auto counts = [&](const char* name, int& dst) {
+        if (!o.contains(name)) return true;
+        const auto& v = o[name];
+        if (!v.is_number_unsigned() || v.get<unsigned>() > 1023) { outErr = "'" + key + name + "' deve essere un intero tra 0 e 1023."; return false; }
+        dst = v.get<int>();
+        return true;
+    };
+    if (!counts("min", c.minCounts) || !counts("max", c.maxCounts)) return false;
+    if (o.contains("invert")) {
+        if (!o["invert"].is_boolean()) { outErr = "'" + key + "invert' deve essere true o false."; return false; }
+        c.invert = o["invert"].get<bool>();
+    }
+    return true;
+}
+
+// Curva completa dopo gli override: coerenza tra chiavi che possono arrivare da livelli diversi
+static bool checkCurve(const VolumeCurveConfig& c, std::string& outErr, const std::string& key) {
+    if (c.minCounts >= c.maxCounts) { outErr = "'" + key + "min' deve essere minore di '" + key + "max'."; return false; }
+    if (c.kind == VolumeCurveKind::Points && c.points.empty()) { outErr = "'" + key + "points' mancante per una curva 'points'."; return false; }
+    return true;
+}
+
+// Blocco opzionale "curve": curva comune a tutti gli slider + override per slider in "sliders".
+// Ogni curva è compilata qui nella sua tabella (VolumeLut): il main loop non fa calcoli.
+static bool parseCurves(DeviceConfig& dev, std::string& outErr, const json& j, const std::string& key) {
+    if (!j.contains("curve")) return true;
+    const auto& cv = j["curve"];
+    const std::string ck = key + "curve.";
+    if (!cv.is_object() && !cv.is_string()) { outErr = "'" + key + "curve' deve essere una stringa o un oggetto."; return false; }
+
+    VolumeCurveConfig common{};
+    if (!parseCurveParams(common, outErr, cv, ck) || !checkCurve(common, outErr, ck)) return false;
+    std::array<VolumeCurveConfig, DeckState::kSliders> curves;
+    curves.fill(common);
+
+    if (cv.is_object() && cv.contains("sliders")) {
+        const auto& per = cv["sliders"];
+        if (!per.is_array()) { outErr = "'" + ck + "sliders' deve essere un array."; return false; }
+        if (per.size() > DeckState::kSliders) { outErr = "'" + ck + "sliders' può contenere al massimo " + std::to_string(DeckState::kSliders) + " elementi."; return false; }
+        for (size_t i = 0; i < per.size(); ++i) {
+            if (per[i].is_null()) continue; // usa la curva comune
+            const std::string ik = ck + "sliders[" + std::to_string(i) + "].";
+            if (!per[i].is_object() && !per[i].is_string()) { outErr = "'" + ik.substr(0, ik.size() - 1) + "' deve essere una stringa, un oggetto o null."; return false; }
+            if (!parseCurveParams(curves[i], outErr, per[i], ik) || !checkCurve(curves[i], outErr, ik)) return false;
+        }
+    }
+
+    for (size_t i = 0; i < DeckState::kSliders; ++i) dev.mapping.sliderCurve[i] = VolumeLut(curves[i]);
+    return true;
+}
+
+// Blocco opzionale "filters": stadi della catena in ordine. Ogni stadio è
+// "smooth" (parametri dal blocco "smoothing"), "min_delta" (soglia di default)
+// oppure un oggetto { "type", "counts" } con counts intero o array per fader.
+static bool parseFilters(DeviceConfig& dev, std::string& outErr, const json& j, const std::string& key) {
+    if (!j.contains("filters")) return true;
+    const auto& fl = j["filters"];
+    const std::string fk = key + "filters";
+    if (!fl.is_array()) { outErr = "'" + fk + "' deve essere un array."; return false; }
+    if (fl.size() > FilterChainConfig::kMaxStages) { outErr = "'" + fk + "' può contenere al massimo " + std::to_string(FilterChainConfig::kMaxStages) + " stadi."; return false; }
+
+    auto& stages = dev.filters.stages;
+    stages.clear();
+    bool hasSmooth = false;
+    for (size_t i = 0; i < fl.size(); ++i) {
+        const std::string ik = fk + "[" + std::to_string(i) + "]";
+        const auto& f = fl[i];
+        if (!f.is_string() && !(f.is_object() && f.contains("type") && f["type"].is_string())) {
+            outErr = "'" + ik + "' deve essere un nome di stadio o un oggetto con 'type'."; return false;
+        }
+
+        FilterStageConfig st{};
+        const std::string type = toLower(f.is_string() ? f.get<std::string>() : f["type"].get<std::string>());
+        if (type == "smooth") {
+            if (hasSmooth) { outErr = "'" + ik + "': lo stadio 'smooth' può comparire una sola volta."; return false; }
+            hasSmooth = true;
+            st.kind = FilterStageKind::Smooth;
+        }
+        else if (type == "min_delta") {
+            st.kind = FilterStageKind::MinDelta;
+            st.counts.fill(kDefaultMinDeltaCounts);
+        }
+        else { outErr = "'" + ik + ".type' deve essere 'smooth' o 'min_delta'."; return false; }
+
+        if (f.is_object() && f.contains("counts")) {
+            if (st.kind != FilterStageKind::MinDelta) { outErr = "'" + ik + ".counts' vale solo per 'min_delta'."; return false; }
+            const auto& c = f["counts"];
+            auto count = [&](const json& v, int& dst) {
+                if (!v.is_number_unsigned() || v.get<unsigned>() > 1023) { outErr = "'" + ik + ".counts' deve essere un intero tra 0 e 1023 o un array di interi."; return false; }
+                dst = v.get<int>();
+                return true;
+            };
+            if (c.is_array()) {
+                if (c.size() > DeckState::kSliders) { outErr = "'" + ik + ".counts' può contenere al massimo " + std::to_string(DeckState::kSliders) + " elementi."; return false; }
+                for (size_t k = 0; k < c.size(); ++k) if (!c[k].is_null() && !count(c[k], st.counts[k])) return false;
+            }
+            else {
+                int v = 0;
+                if (!count(c, v)) return false;
+                st.counts.fill(v);
+            }
+        }
+        stages.push_back(st);
+    }
+    return true;
+}
+
+// Blocchi "serial" + "mapping" di un device. key = prefisso delle chiavi nei
+// messaggi d'errore ("" per il formato legacy, "devices[N]." altrimenti).
+static bool parseDevice(DeviceConfig& dev, std::string& outErr, const json& j, const std::string& key) {
+    // serial
+    if (!j.contains("serial") || !j["serial"].is_object()) { outErr = "Chiave '" + key + "serial' mancante o non oggetto."; return false; }
+    auto s = j["serial"];
+    if (!s.contains("port") || !s["port"].is_string()) { outErr = "Chiave '" + key + "serial.port' mancante o non stringa."; return false; }
+    if (!s.contains("baud") || !s["baud"].is_number_unsigned()) { outErr = "Chiave '" + key + "serial.baud' mancante o non intero positivo."; return false; }
+    dev.port = s["port"].get<std::string>();
+    dev.baud = s["baud"].get<unsigned>();
+    if (s.contains("debounce_ms")) {
+        if (!s["debounce_ms"].is_number_unsigned() || s["debounce_ms"].get<unsigned>() > 100) { outErr = "'" + key + "serial.debounce_ms' deve essere un intero tra 0 e 100."; return false; }
+        dev.debounceMs = s["debounce_ms"].get<unsigned>();
+    }
+
+    // mapping
+    if (!j.contains("mapping") || !j["mapping"].is_object()) { outErr = "Chiave '" + key + "mapping' mancante o non oggetto."; return false; }
+    auto m = j["mapping"];
+    auto& map = dev.mapping;
+
+    // gli errori dei singoli canali riportano "sliders[i]"/"buttons[i]": aggiunge il device
+    auto withKey = [&](bool ok) { if (!ok && !key.empty()) outErr = key + outErr; return ok; };
+
+    if (!m.contains("sliders") || !m["sliders"].is_array()) { outErr = "Chiave '" + key + "mapping.sliders' mancante o non array."; return false; }
+    if (m["sliders"].size() > DeckState::kSliders) { outErr = "'" + key + "mapping.sliders' può contenere al massimo " + std::to_string(DeckState::kSliders) + " elementi."; return false; }
+    for (size_t i = 0; i < m["sliders"].size(); ++i) if (!withKey(parseSliderValue(map, outErr, i, m["sliders"][i]))) return false;
+
+    if (!m.contains("buttons") || !m["buttons"].is_array()) { outErr = "Chiave '" + key + "mapping.buttons' mancante o non array."; return false; }
+    if (m["buttons"].size() > DeckState::kButtons) { outErr = "'" + key + "mapping.buttons' può contenere al massimo " + std::to_string(DeckState::kButtons) + " elementi."; return false; }
+    for (size_t i = 0; i < m["buttons"].size(); ++i) if (!withKey(parseButtonValue(map, outErr, i, m["buttons"][i]))) return false;
+
+    // almeno un mapping presente
+    bool any = false, anyBtn = false;
+    for (auto& sopt : map.sliderMap) if (sopt.has_value()) { any = true; break; }
+    for (auto& acts : map.buttonActions) if (!acts.empty()) { anyBtn = true; break; }
+    if (!any && !anyBtn) { outErr = "Nessun mapping configurato" + (key.empty() ? std::string() : " in " + key.substr(0, key.size() - 1)) + " (sliders e buttons sono tutti null)."; return false; }
+
+    return parseSmoothing(dev, outErr, j, key) && parseFilters(dev, outErr, j, key) && parseCurves(dev, outErr, j, key);
+}
+
+// Blocco opzionale "audio" (in radice, comune a tutti i deck)
+static bool parseAudio(AppConfig& cfg, std::string& outErr, const json& j) {
+    if (!j.contains("audio")) return true;
+    const auto& a = j["audio"];
+    if (!a.is_object()) { outErr = "'audio' deve essere un oggetto."; return false; }
+    if (a.contains("max_rate_hz")) {
+        const auto& v = a["max_rate_hz"];
+        if (!v.is_number() || v.get<double>() < 0.0 || v.get<double>() > 1000.0) { outErr = "'audio.max_rate_hz' fuori range (>= 0, <= 1000)."; return false; }
+        cfg.audioMaxRateHz = v.get<double>();
+    }
+    return true;
+}
+
 bool LoadConfigStrict(AppConfig& cfg, std::string& outErr, const std::string& configPath) {
     cfg = {};
-    for (auto& s : cfg.sliderMap) s.reset();
-    for (auto& v : cfg.buttonActions) v.clear();
 
     try {
         std::ifstream f(configPath);
         if (!f) { outErr = "Impossibile aprire il file: " + configPath; return false; }
 
         json j; f >> j; // può lanciare
+        if (!parseAudio(cfg, outErr, j)) return false;
 
-        // serial
-        if (!j.contains("serial") || !j["serial"].is_object()) { outErr = "Chiave 'serial' mancante o non oggetto."; return false; }
-        auto s = j["serial"];
-        if (!s.contains("port") || !s["port"].is_string()) { outErr = "Chiave 'serial.port' mancante o non stringa."; return false; }
-        if (!s.contains("baud") || !s["baud"].is_number_unsigned()) { outErr = "Chiave 'serial.baud' mancante o non intero positivo."; return false; }
-        cfg.port = s["port"].get<std::string>();
-        cfg.baud = s["baud"].get<unsigned>();
-
-        // mapping
-        if (!j.contains("mapping") || !j["mapping"].is_object()) { outErr = "Chiave 'mapping' mancante o non oggetto."; return false; }
-        auto m = j["mapping"];
+        // Formato legacy: un solo deck con "serial" + "mapping" in radice
+        if (!j.contains("devices")) {
+            DeviceConfig dev;
+            if (!parseDevice(dev, outErr, j, "")) return false;
+            cfg.devices.push_back(std::move(dev));
+            return true;
+        }
 
-        if (!m.contains("sliders") || !m["sliders"].is_array()) { outErr = "Chiave 'mapping.sliders' mancante o non array."; return false; }
-        if (m["sliders"].size() > 5) { outErr = "'mapping.sliders' può contenere al massimo 5 elementi."; return false; }
-        for (size_t i = 0; i < m["sliders"].size(); ++i) if (!parseSliderValue(cfg, outErr, i, m["sliders"][i])) return false;
+        // Multi-deck: "devices": [ { "id", "serial", "mapping" }, ... ]
+        if (!j["devices"].is_array() || j["devices"].empty()) { outErr = "Chiave 'devices' deve essere un array non vuoto."; return false; }
+        if (j["devices"].size() > AppConfig::kMaxDevices) { outErr = "'devices' può contenere al massimo " + std::to_string(AppConfig::kMaxDevices) + " elementi."; return false; }
 
-        if (!m.contains("buttons") || !m["buttons"].is_array()) { outErr = "Chiave 'mapping.buttons' mancante o non array."; return false; }
-        if (m["buttons"].size() > 5) { outErr = "'mapping.buttons' può contenere al massimo 5 elementi."; return false; }
-        for (size_t i = 0; i < m["buttons"].size(); ++i) if (!parseButtonValue(cfg, outErr, i, m["buttons"][i])) return false;
+        for (size_t i = 0; i < j["devices"].size(); ++i) {
+            const auto& d = j["devices"][i];
+            const std::string key = "devices[" + std::to_string(i) + "].";
+            if (!d.is_object()) { outErr = "'" + key.substr(0, key.size() - 1) + "' deve essere un oggetto."; return false; }
+            if (!d.contains("id") || !d["id"].is_string() || d["id"].get<std::string>().empty()) { outErr = "Chiave '" + key + "id' mancante o non stringa."; return false; }
 
-        // almeno un mapping presente
-        bool any = false, anyBtn = false;
-        for (auto& sopt : cfg.sliderMap) if (sopt.has_value()) { any = true; break; }
-        for (int i = 0; i < 5; ++i) if (!cfg.buttonActions[i].empty()) { anyBtn = true; break; }
-        if (!any && !anyBtn) { outErr = "Nessun mapping configurato (sliders e buttons sono tutti null)."; return false; }
+            DeviceConfig dev;
+            dev.id = d["id"].get<std::string>();
+            if (cfg.find(dev.id)) { outErr = "Id device duplicato: '" + dev.id + "'"; return false; }
+            if (!parseDevice(dev, outErr, d, key)) return false;
+            cfg.devices.push_back(std::move(dev));
+        }
 
+        // "auto" sceglie una porta sola: con più deck ognuno deve avere la sua
+        for (size_t a = 0; a < cfg.devices.size(); ++a) {
+            const auto& da = cfg.devices[a];
+            if (cfg.devices.size() > 1 && da.port == "auto") { outErr = "serial.port 'auto' ammesso solo con un singolo device ('" + da.id + "')."; return false; }
+            for (size_t b = a + 1; b < cfg.devices.size(); ++b) {
+                if (toLower(da.port) == toLower(cfg.devices[b].port)) { outErr = "Porta " + da.port + " assegnata a più device."; return false; }
+            }
+        }
         return true;
     }
     catch (const std::exception& ex) {
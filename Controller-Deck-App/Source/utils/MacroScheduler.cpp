@@ -0,0 +1,150 @@
+#include "utils/MacroScheduler.hpp"
+#include <algorithm>
+
+MacroScheduler::MacroScheduler(Runner run) : m_run(std::move(run)) {}
+
+MacroScheduler::~MacroScheduler() {
+    stop();
+}
+
+void MacroScheduler::start() {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    if (m_thread.joinable()) return;
+    m_stop = false;
+    m_thread = std::thread([this] { loop(); });
+}
+
+void MacroScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_stop = true;
+        for (auto& [key, ch] : m_channels) drop(ch);
+        m_channels.clear();
+        m_timers = {};
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void MacroScheduler::drop(Channel& ch) {
+    m_stats.cancelled += ch.queued.size() + (ch.running ? 1 : 0);
+    ch.running.reset();
+    ch.queued.clear();
+}
+
+void MacroScheduler::launch(const Key& key, Channel& ch, Instance inst, Clock::time_point at) {
+    const uint64_t id = inst.id;
+    ch.running = std::move(inst);
+    ++m_stats.started;
+    m_timers.push(Timer{ at, id, key });
+}
+
+bool MacroScheduler::press(const std::string& device, uint16_t button, const std::vector<ButtonAction>& actions, MacroPolicy policy) {
+    if (actions.empty()) return false;
+    auto shared = std::make_shared<const std::vector<ButtonAction>>(actions);   // fuori dal lock
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        if (m_stop) return false;
+        ++m_stats.pressed;
+
+        Key key{ device, button };
+        Channel& ch = m_channels[key];
+        Instance inst{ m_nextId++, std::move(shared), 0 };
+
+        if (ch.running) {
+            switch (policy) {
+            case MacroPolicy::Ignore:
+                ++m_stats.ignored;
+                return false;
+            case MacroPolicy::Restart:
+                drop(ch);
+                break;
+            default:
+                if (ch.queued.size() >= kMaxQueued) { ++m_stats.ignored; return false; }
+                ch.queued.push_back(std::move(inst));
+                m_stats.queuePeak = std::max<uint64_t>(m_stats.queuePeak, ch.queued.size());
+                return true;
+            }
+        }
+
+        const auto now = Clock::now();
+        launch(key, ch, std::move(inst), now);
+        wake = m_timers.top().due == now;   // la nuova scadenza è la prima: il thread deve ricalcolare l'attesa
+    }
+    if (wake) m_cv.notify_one();
+    return true;
+}
+
+void MacroScheduler::cancel(const std::string& device, uint16_t button) {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    auto it = m_channels.find(Key{ device, button });
+    if (it != m_channels.end()) drop(it->second);   // i timer rimasti scadono a vuoto
+}
+
+void MacroScheduler::cancel(const std::string& device) {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    for (auto it = m_channels.lower_bound(Key{ device, 0 }); it != m_channels.end() && it->first.first == device; ++it)
+        drop(it->second);
+}
+
+size_t MacroScheduler::active() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    size_t n = 0;
+    for (const auto& [key, ch] : m_channels) if (ch.running) ++n;
+    return n;
+}
+
+MacroStats MacroScheduler::stats() const {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_stats;
+}
+
+void MacroScheduler::loop() {
+    std::unique_lock<std::mutex> lk(m_mtx);
+    while (!m_stop) {
+        if (m_timers.empty()) { m_cv.wait(lk); continue; }
+        if (Clock::now() < m_timers.top().due) { m_cv.wait_until(lk, m_timers.top().due); continue; }
+
+        const Timer t = m_timers.top();
+        m_timers.pop();
+
+        auto it = m_channels.find(t.key);
+        if (it == m_channels.end() || !it->second.running || it->second.running->id != t.id) continue;   // annullata
+
+        // Gruppo di azioni fino al prossimo delay (escluso)
+        Instance& inst = *it->second.running;
+        const Actions acts = inst.actions;
+        const size_t from = inst.next;
+        size_t to = from;
+        while (to < acts->size() && (*acts)[to].kind != BtnActKind::Delay) ++to;
+        const unsigned delayMs = to < acts->size() ? (*acts)[to].delayMs : 0;
+        inst.next = std::min(to + 1, acts->size());
+
+        // Fuori dal lock: SendInput e comandi audio non bloccano press() dal main loop
+        lk.unlock();
+        for (size_t i = from; i < to; ++i) m_run((*acts)[i]);
+        lk.lock();
+
+        // Nel frattempo l'istanza può essere stata annullata o sostituita (restart)
+        it = m_channels.find(t.key);
+        if (it == m_channels.end() || !it->second.running || it->second.running->id != t.id) continue;
+        Channel& ch = it->second;
+
+        // Il delay parte da quando il gruppo è finito, come il vecchio Sleep in linea
+        const auto now = Clock::now();
+        if (to < acts->size()) {   // anche un delay finale tiene occupato il bottone
+            m_timers.push(Timer{ now + std::chrono::milliseconds(delayMs), t.id, t.key });
+            continue;
+        }
+
+        ++m_stats.completed;
+        ch.running.reset();
+        if (!ch.queued.empty()) {
+            Instance next = std::move(ch.queued.front());
+            ch.queued.pop_front();
+            launch(t.key, ch, std::move(next), now);
+        }
+    }
+}
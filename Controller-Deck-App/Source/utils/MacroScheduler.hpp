@@ -0,0 +1,102 @@
+#pragma once
+#include "utils/Config.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Contatori dello scheduler (snapshot)
+struct MacroStats {
+    uint64_t pressed = 0;      // press ricevuti (con almeno un'azione)
+    uint64_t started = 0;      // istanze partite (subito o dalla coda)
+    uint64_t completed = 0;    // istanze arrivate all'ultima azione
+    uint64_t cancelled = 0;    // istanze annullate (restart, cancel, stop), anche se ancora in coda
+    uint64_t ignored = 0;      // press scartati: policy ignore o coda del bottone piena
+    uint64_t queuePeak = 0;    // massimo di istanze in attesa su un bottone
+};
+
+// Esecuzione asincrona delle liste di azioni dei bottoni. Ogni press diventa
+// un'istanza indipendente della macro del bottone: le azioni fino al prossimo
+// delay girano sul thread dello scheduler, il delay diventa una scadenza in una
+// coda ordinata (min-heap) e il thread dorme fino alla più vicina. Il main loop
+// si limita a press(): i fader continuano a girare mentre le macro suonano.
+// Un bottone ha al più un'istanza in corso; un nuovo press segue la MacroPolicy
+// del bottone. Bottoni diversi (e deck diversi) procedono in parallelo.
+// Tutti i metodi sono thread-safe.
+class MacroScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    // Esegue una singola azione (mai Delay); chiamato solo dal thread dello scheduler
+    using Runner = std::function<void(const ButtonAction&)>;
+
+    static constexpr size_t kMaxQueued = 16;   // istanze in attesa per bottone (policy queue)
+
+    explicit MacroScheduler(Runner run);
+    ~MacroScheduler();   // stop()
+
+    MacroScheduler(const MacroScheduler&) = delete;
+    MacroScheduler& operator=(const MacroScheduler&) = delete;
+
+    void start();
+    // Annulla tutte le istanze e attende il thread. Idempotente.
+    void stop();
+
+    // Nuova istanza delle azioni di un bottone (copiate: la config può cambiare
+    // mentre la macro è in corso). false se il press è stato scartato.
+    bool press(const std::string& device, uint16_t button, const std::vector<ButtonAction>& actions, MacroPolicy policy);
+
+    // Annulla l'istanza in corso e quelle in coda: di un bottone o di tutto il deck.
+    // Un gruppo di azioni già in esecuzione finisce; il delay successivo non scade più.
+    void cancel(const std::string& device, uint16_t button);
+    void cancel(const std::string& device);
+
+    size_t active() const;     // bottoni con un'istanza in corso
+    MacroStats stats() const;
+
+private:
+    using Key = std::pair<std::string, uint16_t>;   // (deck, bottone)
+    using Actions = std::shared_ptr<const std::vector<ButtonAction>>;
+
+    struct Instance {
+        uint64_t id = 0;
+        Actions  actions;
+        size_t   next = 0;     // prossima azione da eseguire
+    };
+    struct Channel {
+        std::optional<Instance> running;
+        std::deque<Instance>    queued;
+    };
+    struct Timer {
+        Clock::time_point due;
+        uint64_t id = 0;       // istanza: se non è più quella in corso, il timer è scaduto a vuoto
+        Key key;
+        bool operator>(const Timer& o) const { return due != o.due ? due > o.due : id > o.id; }
+    };
+
+    void loop();
+    // Con m_mtx preso
+    void launch(const Key& key, Channel& ch, Instance inst, Clock::time_point at);
+    void drop(Channel& ch);
+
+    Runner m_run;
+
+    mutable std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::map<Key, Channel> m_channels;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> m_timers;
+    uint64_t m_nextId = 1;
+    bool m_stop = false;
+    MacroStats m_stats;
+
+    std::thread m_thread;
+};
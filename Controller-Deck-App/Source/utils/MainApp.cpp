@@ -9,6 +9,8 @@
 #include <fmt/core.h>
 #include <Windows.h>
 
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <vector>
 #include <cstdio>                     // std::remove
@@ -17,6 +19,45 @@
 
 using Json = nlohmann::json;
 
+namespace {
+    // Tutti gli slider a 0: probabilmente il deck non ha ancora inviato nulla
+    bool IsLikelyUninitialized(const DeckState& s) {
+        for (int v : s.sliders) if (v != 0) return false;
+        return true;
+    }
+
+    Json DeckStateJson(const DeckState& s) {
+        return Json{ {"sliders", s.sliders}, {"buttons", s.buttons} };
+    }
+
+    // Le catture via API stanno in "captures" accanto a config.json: il nome arriva da
+    // una richiesta HTTP (anche da pagine web, CORS aperto), quindi solo un nome di file
+    // fatto di [A-Za-z0-9._-], che non inizia con '.' e non finisce con '.'.
+    std::string CapturesDir(const std::string& configPath) {
+        const size_t slash = configPath.find_last_of("/\\");
+        return (slash == std::string::npos ? std::string() : configPath.substr(0, slash + 1)) + "captures";
+    }
+
+    // Nomi riservati di Windows: aprono il device qualunque sia l'estensione ("nul.cdcap").
+    bool IsDosDeviceName(const std::string& name) {
+        std::string base = name.substr(0, name.find('.'));
+        for (char& c : base) if (c >= 'a' && c <= 'z') c = char(c - 'a' + 'A');
+        if (base == "CON" || base == "PRN" || base == "AUX" || base == "NUL" || base == "CONIN$" || base == "CONOUT$")
+            return true;
+        return base.size() == 4 && (base.starts_with("COM") || base.starts_with("LPT")) && base[3] >= '1' && base[3] <= '9';
+    }
+
+    bool CaptureFilePath(const std::string& configPath, const std::string& name, std::string& out, std::string& err) {
+        bool ok = !name.empty() && name.size() <= 128 && name.front() != '.' && name.back() != '.' &&
+            !IsDosDeviceName(name);
+        for (char c : name)
+            ok = ok && ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '.' || c == '_' || c == '-');
+        if (!ok) { err = "bad_path"; return false; }
+        out = CapturesDir(configPath) + "/" + name;
+        return true;
+    }
+}
+
 // -----------------------------------------------------------------------------
 // Helpers generali
 // -----------------------------------------------------------------------------
@@ -45,6 +86,16 @@ std::vector<std::string> MainApp::listSerialPorts() {
 // -----------------------------------------------------------------------------
 MainApp::MainApp(std::string configPath)
     : m_configPath(std::move(configPath)) {
+    // Attacco/stacco dei deck verso il FE (thread di IO: solo publish, niente attese)
+    m_serial.setOnLink([this](const std::string& id, SerialLinkState st) {
+        publishStateChange(Json{
+            {"type", "serial"},
+            {"device", id},
+            {"state", SerialLinkStateName(st)},
+            {"connected", st == SerialLinkState::Connected},
+            {"timestamp", NowIsoUtc()}
+            });
+        });
 }
 
 // -----------------------------------------------------------------------------
@@ -95,37 +146,35 @@ bool MainApp::isProcessFullscreen(unsigned long pid) const {
     return MainApp::IsProcessLikelyFullscreen(pid);
 }
 
-bool MainApp::initControllersOrDie(const std::string& port, unsigned baud) {
-    // Seriale (ora via SerialService)
-    {
+std::vector<std::string> MainApp::configuredDeviceIds() {
+    std::lock_guard<std::mutex> lock(m_cfgMtx);
+    std::vector<std::string> ids;
+    for (const auto& d : m_cfg.devices) ids.push_back(d.id);
+    return ids;
+}
+
+bool MainApp::initControllersOrDie() {
+    // Seriali: un reader per deck, tutti sullo stesso thread di IO (SerialService)
+    for (const auto& dev : m_cfg.devices) {
+        const std::string port = (dev.port == "auto") ? pickPortAuto() : dev.port;
         std::string err;
-        if (!m_serial.open(port, baud, &err)) {
-            fmt::print("Seriale {} @ {} non avviata: {}.\n", port, baud, err);
+        if (!m_serial.open(dev.id, port, dev.baud, &err)) {
+            fmt::print("Seriale {} ({}) @ {} non avviata: {}.\n", port, dev.id, dev.baud, err);
             WaitForEnterAndExit(4);
             return false;
         }
+        fmt::print("Seriale {} ({}) @ {} in apertura.\n", port, dev.id, dev.baud);
     }
-    fmt::print("Seriale {} @ {} avviata.\n", port, baud);
 
-    // Audio master
-    if (!m_master.init()) {
-        fmt::print("Audio master init fallita.\n");
-        WaitForEnterAndExit(4);
+    // Audio: master + sessioni (obbligatori), endpoint per id (opzionale)
+    std::string audioErr;
+    if (!m_audio->init(audioErr)) {
+        const bool master = audioErr == "master_init_failed";
+        fmt::print("Audio {} init fallita.\n", master ? "master" : "session");
+        WaitForEnterAndExit(master ? 4 : 5);
         return false;
     }
 
-    // Audio sessions
-    if (!m_sessions.init()) {
-        fmt::print("Audio session init fallita.\n");
-        WaitForEnterAndExit(5);
-        return false;
-    }
-
-    // Controller endpoint device specifico (default device)
-    if (!m_deviceCtrl.init()) {
-        fmt::print("Audio endpoint controller init fallita.\n");
-    }
-
     return true;
 }
 
@@ -134,24 +183,146 @@ bool MainApp::initControllersOrDie(const std::string& port, unsigned baud) {
 // -----------------------------------------------------------------------------
 Json MainApp::getSerialStatusJson() {
     // Nota: la porta/baud “correnti” sono in m_cfg (protetti da m_cfgMtx)
-    const bool connected = m_serial.isConnected();
-
-    std::string port;
-    unsigned baud = 0;
+    struct Entry { std::string id, port; unsigned baud; };
+    std::vector<Entry> devs;
     {   // sezione protetta per leggere la config persistita
         std::lock_guard<std::mutex> lock(m_cfgMtx);
-        port = m_cfg.port;
-        baud = m_cfg.baud;
+        for (const auto& d : m_cfg.devices) devs.push_back({ d.id, d.port, d.baud });
     }
 
-    Json out = { {"connected", connected} };
-    if (connected) {
-        out["port"] = port;
-        out["baud"] = baud;
+    Json list = Json::array();
+    for (const auto& d : devs) {
+        const SerialStats st = m_serial.stats(d.id);
+        const bool connected = (st.link == SerialLinkState::Connected);
+        Json out = { {"id", d.id}, {"connected", connected}, {"link", SerialLinkStateName(st.link)}, {"reconnects", st.reconnects} };
+        if (connected) {
+            out["port"] = d.port;
+            out["baud"] = d.baud;
+            out["protocol"] = DeckProtocolName(st.protocol);
+            out["stats"] = {
+                {"frames",       st.frames},
+                {"parse_errors", st.parseErrors},
+                {"crc_errors",   st.crcErrors},
+                {"seq_gaps",     st.seqGaps},
+                {"coalesced",    st.coalesced},
+                {"backlog_peak", st.backlogPeak},
+                {"edge_drops",   st.edgeDrops}
+            };
+        }
+
+        // Catena di filtri: per stadio, campioni entrati, uscite cambiate e cambi soppressi
+        // (totali e per slider). "out" dell'ultimo stadio = aggiornamenti di volume.
+        Json filters = Json::array();
+        for (const auto& f : m_serial.filterStats(d.id)) {
+            uint64_t in = 0, changed = 0, suppressed = 0;
+            Json sliders = Json::array();
+            for (size_t i = 0; i < DeckState::kSliders; ++i) {
+                in += f.in[i];
+                changed += f.out[i];
+                suppressed += f.suppressed[i];
+                sliders.push_back({ {"in", f.in[i]}, {"out", f.out[i]}, {"suppressed", f.suppressed[i]} });
+            }
+            filters.push_back({ {"stage", FilterStageName(f.kind)}, {"in", in}, {"out", changed}, {"suppressed", suppressed}, {"sliders", std::move(sliders)} });
+        }
+        out["filters"] = std::move(filters);
+
+        // Cattura su file in corso e replay al posto della porta
+        const auto cap = m_serial.captureStatus(d.id);
+        if (cap.active) out["capture"] = { {"path", cap.path}, {"bytes", cap.bytes}, {"frames", cap.frames}, {"dropped", cap.dropped} };
+        out["replaying"] = m_serial.isReplaying(d.id);
+        list.push_back(std::move(out));
     }
+
+    // In radice il primo device (compatibile con il FE a deck singolo)
+    Json out = list.empty() ? Json{ {"connected", false} } : list[0];
+    out["devices"] = list;
     return out;
 }
 
+Json MainApp::getHistoryJson(const std::string& device, int channel, const std::string& source,
+                             int64_t fromMs, int64_t toMs, int maxPoints, std::string& err) {
+    std::string id = device;
+    if (id.empty()) {
+        const auto ids = configuredDeviceIds();
+        if (ids.empty()) { err = "unknown_device"; return nullptr; }
+        id = ids.front();
+    }
+    if (channel < 0 || static_cast<size_t>(channel) >= DeckState::kSliders) { err = "bad_channel"; return nullptr; }
+
+    SampleHistory::Source src;
+    if (source.empty() || source == "filtered") src = SampleHistory::Source::Filtered;
+    else if (source == "raw")                  src = SampleHistory::Source::Raw;
+    else { err = "bad_source"; return nullptr; }
+
+    HistorySeries s;
+    uint32_t now = 0;
+    if (!m_serial.queryHistory(id, static_cast<size_t>(channel), src, fromMs, toMs, static_cast<size_t>(maxPoints), s, now)) {
+        err = "unknown_device";
+        return nullptr;
+    }
+    return Json{
+        {"device",    id},
+        {"channel",   channel},
+        {"source",    src == SampleHistory::Source::Raw ? "raw" : "filtered"},
+        {"now",       now},
+        {"from",      s.fromMs},
+        {"to",        s.toMs},
+        {"bucket_ms", s.bucketMs},
+        {"samples",   s.samples},
+        {"t",         s.t},
+        {"min",       s.min},
+        {"max",       s.max},
+        {"last",      s.last}
+    };
+}
+
+Json MainApp::getLatencyJson(bool reset) {
+    auto stage = [](LatencyHistogram& h) {
+        const auto s = h.snapshot();
+        auto us = [](uint64_t ns) { return static_cast<double>(ns) / 1000.0; };
+        return Json{
+            {"count",    s.count},
+            {"mean_us",  s.meanNs / 1000.0},
+            {"p50_us",   us(s.p50Ns)},
+            {"p90_us",   us(s.p90Ns)},
+            {"p99_us",   us(s.p99Ns)},
+            {"p999_us",  us(s.p999Ns)},
+            {"max_us",   us(s.maxNs)}
+        };
+    };
+
+    Json devices = Json::object();
+    std::lock_guard<std::mutex> lk(m_decksMtx);
+    for (auto& d : m_decks) {
+        auto& lat = d->mapper.latency();
+        devices[d->id] = {
+            {"read_to_parse", stage(lat.readToParse)},
+            {"parse_to_loop", stage(lat.parseToLoop)},
+            {"loop_to_audio", stage(lat.loopToAudio)}
+        };
+        if (reset) {
+            lat.readToParse.reset();
+            lat.parseToLoop.reset();
+            lat.loopToAudio.reset();
+        }
+    }
+
+    // worker audio: comune a tutti i deck
+    const auto ws = m_audio->stats();
+    Json audio = {
+        {"queue_to_audio", stage(m_audio->queueToAudio())},
+        {"submitted", ws.submitted},
+        {"coalesced", ws.coalesced},
+        {"applied",   ws.applied},
+        {"failed",    ws.failed},
+        {"queue_peak", ws.queuePeak},
+        {"throttled", ws.throttled},
+        {"trailing",  ws.trailing}
+    };
+    if (reset) m_audio->queueToAudio().reset();
+    return Json{ {"devices", devices}, {"audio", audio} };
+}
+
 nlohmann::json MainApp::getStateJson(bool verbose) const {
     Json base = const_cast<MainApp*>(this)->getStateJson();
     if (!verbose) return base;
@@ -159,6 +330,7 @@ nlohmann::json MainApp::getStateJson(bool verbose) const {
     Json out = {
         {"buttons",   base["buttons"]},
         {"sliders",   base["sliders"]},
+        {"devices",   base["devices"]},
         {"timestamp", NowIsoUtc()},
         {"meta",      { {"source","controller-deck"}, {"verbose",true} }},
         {"layout",    getLayoutJson()},
@@ -168,11 +340,22 @@ nlohmann::json MainApp::getStateJson(bool verbose) const {
 }
 
 nlohmann::json MainApp::getStateJson() {
-    DeckState s = m_serial.readState();
-    return nlohmann::json{
-        {"sliders", { s.sliders[0], s.sliders[1], s.sliders[2], s.sliders[3], s.sliders[4] }},
-        {"buttons", { s.buttons[0], s.buttons[1], s.buttons[2], s.buttons[3], s.buttons[4] }}
-    };
+    const auto ids = configuredDeviceIds();
+    Json devices = Json::object();
+    for (const auto& id : ids) {
+        devices[id] = DeckStateJson(m_serial.readState(id));
+    }
+
+    // In radice il primo device (compatibile con il FE a deck singolo)
+    Json out = ids.empty() ? Json{ {"sliders", Json::array()}, {"buttons", Json::array()} } : devices[ids.front()];
+    out["devices"] = devices;
+    return out;
+}
+
+nlohmann::json MainApp::getDeviceStateJson(const std::string& id) {
+    const auto ids = configuredDeviceIds();
+    if (std::find(ids.begin(), ids.end(), id) == ids.end()) return nullptr;
+    return DeckStateJson(m_serial.readState(id));
 }
 
 Json MainApp::getConfigJson() {
@@ -225,29 +408,52 @@ bool MainApp::setConfigJsonStrict(const Json& j, std::string& err) {
         std::lock_guard<std::mutex> lock(m_cfgMtx);
         m_cfg = newCfg;
     }
+    m_cfgGen.fetch_add(1, std::memory_order_release);
+
+    // Seriali: chiude i deck tolti dalla config, apre quelli nuovi e riapre
+    // quelli a cui è cambiata porta o baud
+    for (const auto& id : m_serial.deviceIds()) {
+        if (!newCfg.find(id)) { std::string e; (void)m_serial.close(id, &e); }
+    }
+    for (const auto& dev : newCfg.devices) {
+        if (dev.port == "auto") continue;
+        // già supervisionato (anche se in riconnessione) sulla stessa porta: lo lascia fare
+        const bool active = m_serial.stats(dev.id).link != SerialLinkState::Stopped;
+        if (active && m_serial.port(dev.id) == dev.port && m_serial.baud(dev.id) == dev.baud) continue;
+        std::string e;
+        if (!m_serial.open(dev.id, dev.port, dev.baud, &e))
+            fmt::print("Seriale {} ({}) non avviata: {}\n", dev.port, dev.id, e);
+    }
 
     // Pre-applica i volumi secondo il nuovo mapping solo se abbiamo dati validi
-    if (m_serial.isConnected()) {
-        auto isLikelyUninitialized = [](const DeckState& s) {
-            for (int i = 0; i < 5; ++i) if (s.sliders[i] != 0) return false;
-            return true;
-            };
-        DeckState cur = m_serial.readState();
-        if (!isLikelyUninitialized(cur)) {
-            m_mapper.preapply(m_cfg, m_master, m_sessions, cur);
+    for (const auto& dev : newCfg.devices) {
+        if (!m_serial.isConnected(dev.id)) continue;
+        DeckState cur = m_serial.readState(dev.id);
+        if (!IsLikelyUninitialized(cur)) {
+            MappingExecutor::preapply(dev.mapping, *m_audio, cur);
         }
     }
+    m_serial.wake(); // il main loop riallinea i deck alla nuova config
     return true;
 }
 
-bool MainApp::selectSerialPort(const std::string& newPort, unsigned baud, std::string& err) {
-    if (!m_serial.open(newPort, baud, &err)) return false;
+bool MainApp::selectSerialPort(const std::string& newPort, unsigned baud, const std::string& device, std::string& err) {
+    std::string id = device;
+    {
+        std::lock_guard<std::mutex> ck(m_cfgMtx);
+        if (id.empty() && !m_cfg.devices.empty()) id = m_cfg.devices.front().id;
+        if (!m_cfg.find(id)) { err = "unknown_device"; return false; }
+    }
+
+    if (!m_serial.open(id, newPort, baud, &err)) return false;
 
     // aggiorna config (RAM + persistenza)
     {
         std::lock_guard<std::mutex> ck(m_cfgMtx);
-        m_cfg.port = newPort;
-        m_cfg.baud = baud;
+        if (auto* dev = m_cfg.find(id)) {
+            dev->port = newPort;
+            dev->baud = baud;
+        }
 
         try {
             nlohmann::json j;
@@ -255,13 +461,24 @@ bool MainApp::selectSerialPort(const std::string& newPort, unsigned baud, std::s
                 std::ifstream fin(m_configPath, std::ios::binary);
                 if (fin) fin >> j; else j = nlohmann::json::object();
             }
-            if (!j.contains("serial") || !j["serial"].is_object())
-                j["serial"] = nlohmann::json::object();
-            j["serial"]["port"] = newPort;
-            j["serial"]["baud"] = baud;
 
-            std::ofstream fout(m_configPath, std::ios::binary | std::ios::trunc);
-            fout << j.dump(2);
+            // Formato multi-deck: aggiorna il device giusto; legacy: "serial" in radice
+            nlohmann::json* target = &j;
+            if (j.contains("devices") && j["devices"].is_array()) {
+                target = nullptr;
+                for (auto& d : j["devices"]) {
+                    if (d.is_object() && d.value("id", "") == id) { target = &d; break; }
+                }
+            }
+            if (target) {
+                if (!target->contains("serial") || !(*target)["serial"].is_object())
+                    (*target)["serial"] = nlohmann::json::object();
+                (*target)["serial"]["port"] = newPort;
+                (*target)["serial"]["baud"] = baud;
+
+                std::ofstream fout(m_configPath, std::ios::binary | std::ios::trunc);
+                fout << j.dump(2);
+            }
         }
         catch (...) {
             // non fatale
@@ -270,14 +487,52 @@ bool MainApp::selectSerialPort(const std::string& newPort, unsigned baud, std::s
     return true;
 }
 
-bool MainApp::closeSerialPort(std::string& err) {
-    return m_serial.close(&err);
+bool MainApp::closeSerialPort(const std::string& device, std::string& err) {
+    std::string id = device;
+    if (id.empty()) {
+        const auto ids = configuredDeviceIds();
+        if (!ids.empty()) id = ids.front();
+    }
+    return m_serial.close(id, &err);
+}
+
+bool MainApp::resolveDeviceId(std::string& id, std::string& err) {
+    std::lock_guard<std::mutex> ck(m_cfgMtx);
+    if (id.empty() && !m_cfg.devices.empty()) id = m_cfg.devices.front().id;
+    if (!m_cfg.find(id)) { err = "unknown_device"; return false; }
+    return true;
+}
+
+bool MainApp::startSerialCapture(const std::string& device, const std::string& name, std::string& err) {
+    std::string id = device;
+    if (!resolveDeviceId(id, err)) return false;
+    std::string path;
+    if (!CaptureFilePath(m_configPath, name, path, err)) return false;
+    std::error_code ec;
+    std::filesystem::create_directories(CapturesDir(m_configPath), ec);   // se fallisce lo dice open()
+    return m_serial.startCapture(id, path, &err);
+}
+
+Json MainApp::stopSerialCapture(const std::string& device, std::string& err) {
+    std::string id = device;
+    if (!resolveDeviceId(id, err)) return nullptr;
+    const auto st = m_serial.stopCapture(id);
+    if (st.path.empty()) { err = "not_capturing"; return nullptr; }
+    return Json{ {"device", id}, {"path", st.path}, {"bytes", st.bytes}, {"frames", st.frames}, {"dropped", st.dropped} };
+}
+
+bool MainApp::replaySerialCapture(const std::string& device, const std::string& name, double speed, std::string& err) {
+    std::string id = device;
+    if (!resolveDeviceId(id, err)) return false;
+    std::string path;
+    if (!CaptureFilePath(m_configPath, name, path, err)) return false;
+    return m_serial.replay(id, path, speed, &err);
 }
 
 // Layout di esempio (compatibile con il FE attuale)
 Json MainApp::getLayoutJson() const {
     Json controls = Json::array();
-    for (int i = 0; i < 5; ++i) {
+    for (int i = 0; i < static_cast<int>(DeckState::kButtons); ++i) {
         controls.push_back({
             {"id",    fmt::format("btn_{:02d}", i + 1)},
             {"type",  "button"},
@@ -291,7 +546,7 @@ Json MainApp::getLayoutJson() const {
             });
     }
     Json sliders = Json::array();
-    for (int i = 0; i < 5; ++i) {
+    for (int i = 0; i < static_cast<int>(DeckState::kSliders); ++i) {
         sliders.push_back({
             {"id",    fmt::format("slider_{:02d}", i + 1)},
             {"type",  "slider"},
@@ -331,52 +586,134 @@ bool MainApp::popNextStateEventBlocking(Json& out, std::chrono::milliseconds tim
 void MainApp::requestShutdown() {
     // segnale di uscita (consumato nel loop main)
     m_shouldExit.store(true, std::memory_order_relaxed);
+    m_serial.wake(); // il main loop può essere in attesa senza timeout
 }
 
 // -----------------------------------------------------------------------------
 // API lato audio device
 // -----------------------------------------------------------------------------
 bool MainApp::selectAudioDeviceById(const std::string& idUtf8, std::string& err) {
-    // Converte UTF-8 -> UTF-16
-    int len = MultiByteToWideChar(CP_UTF8, 0, idUtf8.c_str(), -1, nullptr, 0);
-    if (len <= 1) { err = "bad_device_id"; return false; }
-    std::wstring wid(len - 1, L'\0');
-    MultiByteToWideChar(CP_UTF8, 0, idUtf8.c_str(), -1, wid.data(), len);
-
-    std::wstring werr;
-    if (!m_deviceCtrl.setActiveEndpointById(wid, werr)) {
-        err = "select_failed";
+    std::string e;
+    if (!m_audio->selectEndpoint(idUtf8, e)) {
+        err = (e == "bad_device_id") ? e : "select_failed";
         return false;
     }
     return true;
 }
 
 bool MainApp::setAudioDeviceVolume(float scalar01, std::string& err) {
-    std::wstring werr;
-    if (!m_deviceCtrl.setVolumeScalar(scalar01, werr)) {
+    std::string e;
+    if (!m_audio->setEndpointVolume(scalar01, e)) {
         err = "set_volume_failed";
         return false;
     }
     return true;
 }
 
+// -----------------------------------------------------------------------------
+// Deck: stato per-device del main loop
+// -----------------------------------------------------------------------------
+void MainApp::syncDecks(const AppConfig& cfg) {
+    for (auto& d : m_decks) d->mapping = nullptr;
+
+    for (const auto& dev : cfg.devices) {
+        DeckRuntime* rt = nullptr;
+        for (auto& d : m_decks) if (d->id == dev.id) { rt = d.get(); break; }
+
+        if (!rt) {
+            auto fresh = std::make_unique<DeckRuntime>();
+            fresh->id = dev.id;
+            rt = fresh.get();
+            std::lock_guard<std::mutex> lk(m_decksMtx);
+            m_decks.push_back(std::move(fresh));
+        }
+        rt->mapping = &dev.mapping;
+
+        // catena di filtri dei fader dalla config: passa al thread di IO del deck
+        // (un cambio di modo dello smoothing fa ripartire solo quel fader)
+        m_serial.setFilters(dev.id, dev.filters);
+        m_serial.setDebounce(dev.id, std::chrono::milliseconds(dev.debounceMs));
+    }
+
+    // deck tolti dalla config: le loro macro non proseguono
+    for (auto& d : m_decks) if (!d->mapping) m_macros.cancel(d->id);
+}
+
+void MainApp::processDeck(DeckRuntime& d) {
+    if (!d.index) d.index = m_serial.indexOf(d.id);
+    if (!d.index) return;
+
+    // Bottoni: ogni fronte in coda, nell'ordine di arrivo (anche i tap più brevi di un giro)
+    m_serial.drainButtonEdges(*d.index, [&](const ButtonEdge& e) {
+        publishStateChange(Json{
+            {"type","button"},
+            {"device", d.id},
+            {"id",   fmt::format("btn_{:02d}", e.button + 1)},
+            {"pressed", e.pressed},
+            {"prev",    !e.pressed},
+            {"timestamp", NowIsoUtc()}
+            });
+        MappingExecutor::applyButtonEdge(*d.mapping, m_macros, d.id, e);
+        });
+
+    if (!m_serial.isConnected(*d.index)) return;
+
+    uint64_t ver = 0;
+    DeckState cur = m_serial.readState(*d.index, ver);
+    const auto pickedAt = std::chrono::steady_clock::now();
+
+    // Nessun nuovo campione: il giro darebbe lo stesso output
+    if (ver == d.lastVersion) return;
+    d.lastVersion = ver;
+
+    DeckState& prev = d.prev;
+
+    // --- Pubblica eventi per il FE ---
+    // Sliders
+    for (size_t i = 0; i < DeckState::kSliders; ++i) {
+        if (cur.sliders[i] != prev.sliders[i]) {
+            publishStateChange(Json{
+                {"type","slider"},
+                {"device", d.id},
+                {"id",   fmt::format("slider_{:02d}", i + 1)},
+                {"value", cur.sliders[i]},
+                {"prev",  prev.sliders[i]},
+                {"timestamp", NowIsoUtc()}
+                });
+        }
+    }
+    // Applica mapping (aggiorna anche prev)
+    d.mapper.applyChanges(*d.mapping, *m_audio, cur, prev, pickedAt);
+}
+
 // -----------------------------------------------------------------------------
 // run() — ciclo di vita principale dell'app
 // -----------------------------------------------------------------------------
 int MainApp::run() {
     if (!loadConfigStrictOrDie()) return 2;
-
-    std::string port = (m_cfg.port == "auto") ? pickPortAuto() : m_cfg.port;
-    if (!initControllersOrDie(port, m_cfg.baud)) return 4;
+    if (!initControllersOrDie()) return 4;
+    m_macros.start();
 
 #if !defined(_DEBUG)
     // In Release, se il target è ConsoleApp, nascondi la console
     FreeConsole();
 #endif
 
-    // smoothing dei fader (parametri iniziali)
-    m_smoother.reset();
-    m_smoother.setParamsAll(FaderSmoothingParams{ /*deadband*/ 2, /*alpha*/ 0.20f });
+    // Copia locale della config per il main loop: ricopiata quando cambia m_cfgGen
+    AppConfig cfg;
+    uint64_t cfgGen = ~0ull;
+    auto refreshConfig = [&] {
+        const uint64_t g = m_cfgGen.load(std::memory_order_acquire);
+        if (g == cfgGen) return;
+        cfgGen = g;
+        {
+            std::lock_guard<std::mutex> lock(m_cfgMtx);
+            cfg = m_cfg;
+        }
+        syncDecks(cfg);
+        m_audio->setMaxRate(cfg.audioMaxRateHz);
+    };
+    refreshConfig();
 
     // Callbacks REST (wiring separato)
     ApiServer::Callbacks cbs = ApiWiring::MakeCallbacks(*this);
@@ -394,23 +731,22 @@ int MainApp::run() {
 
     fmt::print("REST su http://127.0.0.1:8765  |  Premi ESC per uscire.\n");
 
-    auto isLikelyUninitialized = [](const DeckState& s) {
-        for (int i = 0; i < 5; ++i) if (s.sliders[i] != 0) return false;
+    // Attendi (max ~800 ms) un primo campione non-zero da ogni deck; altrimenti niente preapply
+    auto allReady = [&] {
+        for (const auto& d : m_decks) if (IsLikelyUninitialized(m_serial.readState(d->id))) return false;
         return true;
         };
-
-    // Attendi (max ~800 ms) un primo campione non-zero; altrimenti niente preapply
-    DeckState first = m_serial.readState();
-    m_smoother.apply(first);
     DWORD start = GetTickCount();
-    while (isLikelyUninitialized(first) && (GetTickCount() - start) < 800) {
-        Sleep(10);
-        first = m_serial.readState();
+    while (!allReady() && (GetTickCount() - start) < 800) {
+        m_serial.waitForChange(800 - static_cast<int64_t>(GetTickCount() - start));
     }
 
-    DeckState prev = first;
-    if (!isLikelyUninitialized(first)) {
-        m_mapper.preapply(m_cfg, m_master, m_sessions, first);
+    for (auto& d : m_decks) {
+        const DeckState first = m_serial.readState(d->id);   // già filtrato dal thread di IO
+        d->prev = first;
+        if (d->mapping && !IsLikelyUninitialized(first)) {
+            MappingExecutor::preapply(*d->mapping, *m_audio, first);
+        }
     }
 
     // Loop principale
@@ -430,51 +766,31 @@ int MainApp::run() {
         }
 #endif
 
-        if (m_serial.isConnected()) {
-            DeckState cur = m_serial.readState();
-            m_smoother.apply(cur);
-
-            // --- Pubblica eventi per il FE ---
-            // Sliders
-            for (int i = 0; i < 5; ++i) {
-                if (cur.sliders[i] != prev.sliders[i]) {
-                    publishStateChange(Json{
-                        {"type","slider"},
-                        {"id",   fmt::format("slider_{:02d}", i + 1)},
-                        {"value", cur.sliders[i]},
-                        {"prev",  prev.sliders[i]},
-                        {"timestamp", NowIsoUtc()}
-                        });
-                }
-            }
-            // Buttons
-            for (int i = 0; i < 5; ++i) {
-                if (cur.buttons[i] != prev.buttons[i]) {
-                    publishStateChange(Json{
-                        {"type","button"},
-                        {"id",   fmt::format("btn_{:02d}", i + 1)},
-                        {"pressed", cur.buttons[i] != 0},
-                        {"prev",    prev.buttons[i] != 0},
-                        {"timestamp", NowIsoUtc()}
-                        });
-                }
-            }
+        refreshConfig();
 
-            // Applica mapping e aggiorna prev
-            m_mapper.applyChanges(m_cfg, m_master, m_sessions, cur, prev);
-            prev = cur;
+        // Un giro su tutti i deck: quelli senza nuovi campioni costano una load atomica
+        for (auto& d : m_decks) {
+            if (!d->mapping) continue; // tolto dalla config
+            processDeck(*d);
         }
 
-        Sleep(10); // throttling minimo
+        // Attende il prossimo stato da una qualsiasi seriale (notify dagli store):
+        // lo smoothing converge nel thread di IO a ogni campione, quindi a riposo
+        // il main loop dorme senza timeout.
+        int64_t timeoutMs = ChangeSignal::kInfinite;
+#ifdef _DEBUG
+        if (timeoutMs < 0) timeoutMs = 50; // ESC viene letto per polling
+#endif
+        m_serial.waitForChange(timeoutMs);
     }
 
     // Teardown ordinato
     if (m_api) { m_api->stop(); m_api.reset(); }
     if (tray) { tray->stop(); tray.reset(); }
 
-    m_sessions.shutdown();
-    m_master.shutdown();
-    std::string _; (void)m_serial.close(&_); // opzionale: garantisce chiusura immediata
+    m_macros.stop();     // prima dell'audio: nessuna azione dopo lo shutdown
+    m_audio->shutdown();
+    m_serial.closeAll(); // opzionale: garantisce chiusura immediata
 
     return 0;
 }
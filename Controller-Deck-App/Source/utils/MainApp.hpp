@@ -5,12 +5,12 @@
 #include <nlohmann/json.hpp>
 #include <chrono>
 #include <atomic>
+#include <optional>
+#include <vector>
 #include "utils/Config.hpp"
 #include "utils/MappingExecutor.hpp"
-#include "Core/Audio/AudioController.hpp"
-#include "Core/Audio/AudioSessionController.hpp"
-#include "Core/Serial/InputSmoother.hpp"
-#include "Core/Audio/AudioEndpointController.hpp"
+#include "Core/Audio/AudioWorker.hpp"
+#include "Core/Audio/WasapiAudioBackend.hpp"
 #include "api/ApiServer.hpp"
 
 // Nuovo: servizi estratti
@@ -22,19 +22,32 @@ public:
     explicit MainApp(std::string configPath = "Source/config.json");
     int run();
 
-    // ---- API (invariata) ----
+    // ---- API ----
+    // Con più deck i campi in radice si riferiscono al primo device della config,
+    // gli altri sono sotto "devices" (id -> stato).
     nlohmann::json getStateJson();                                      // /state
+    nlohmann::json getDeviceStateJson(const std::string& id);           // /state?device=<id> (null se sconosciuto)
     nlohmann::json getConfigJson();                                     // /config (GET)
     bool validateConfigJson(const nlohmann::json& j, std::string& err); // /config/validate (PUT)
     bool setConfigJsonStrict(const nlohmann::json& j, std::string& err);// /config (PUT)
-    bool selectSerialPort(const std::string& port, unsigned baud, std::string& err); // /serial/select (POST)
-    bool closeSerialPort(std::string& err);                              // /serial/close (POST)
+    // device vuoto = primo device della config
+    bool selectSerialPort(const std::string& port, unsigned baud, const std::string& device, std::string& err); // /serial/select (POST)
+    bool closeSerialPort(const std::string& device, std::string& err);                                          // /serial/close (POST)
+    // name: solo nome di file, risolto in "captures" accanto alla config (err "bad_path" altrimenti)
+    bool startSerialCapture(const std::string& device, const std::string& name, std::string& err);              // /serial/capture/start (POST)
+    nlohmann::json stopSerialCapture(const std::string& device, std::string& err);                              // /serial/capture/stop (POST), null se nessuna cattura
+    bool replaySerialCapture(const std::string& device, const std::string& name, double speed, std::string& err); // /serial/replay (POST)
     std::vector<std::string> listSerialPorts();
     void requestShutdown();
 
     bool isProcessFullscreen(unsigned long pid) const;
 
     nlohmann::json getSerialStatusJson();
+    nlohmann::json getLatencyJson(bool reset);                        // /metrics/latency
+    // /state/history: serie decimata (min/max/last) di uno slider. device vuoto = primo device.
+    // from/to in ms sul clock dello storico, negativi = relativi ad adesso. null + err se non valida.
+    nlohmann::json getHistoryJson(const std::string& device, int channel, const std::string& source,
+                                  int64_t fromMs, int64_t toMs, int maxPoints, std::string& err);
     [[nodiscard]] nlohmann::json getLayoutJson() const;
     [[nodiscard]] nlohmann::json getStateJson(bool verbose) const; // /state?verbose=1
 
@@ -49,22 +62,46 @@ public:
 private:
     // ---- setup di base ----
     bool loadConfigStrictOrDie();
-    bool initControllersOrDie(const std::string& port, unsigned baud);
+    bool initControllersOrDie();
     std::string pickPortAuto();
-    InputSmoother  m_smoother;
+    std::vector<std::string> configuredDeviceIds();
+    bool resolveDeviceId(std::string& id, std::string& err);   // vuoto = primo device della config
+
+    // Stato per-deck del main loop: mapping di slider e bottoni. Smoothing e
+    // debounce girano nel thread di IO: lo store contiene già lo stato filtrato
+    // e i fronti dei bottoni arrivano dalla ButtonEdgeQueue del deck.
+    // Creato e aggiornato solo dal main loop; mai rimosso, così i thread REST
+    // possono leggerne le metriche sotto m_decksMtx.
+    struct DeckRuntime {
+        std::string          id;
+        std::optional<size_t> index;                // indice in SerialService (quando registrato)
+        const DeckMapping*   mapping = nullptr;     // nella config del main loop; null = rimosso
+        MappingExecutor      mapper;
+        DeckState            prev{};
+        uint64_t             lastVersion = ~0ull;   // versione dello store già elaborata
+    };
+    void syncDecks(const AppConfig& cfg);           // solo main loop
+    void processDeck(DeckRuntime& d);               // fronti dei bottoni in coda + slider se lo store ha una nuova versione
 
     // ---- stato app ----
     std::string m_configPath;
     AppConfig   m_cfg;
 
     std::atomic<bool> m_shouldExit{ false };
+    std::atomic<uint64_t> m_cfgGen{ 0 };   // incrementato a ogni nuova config (il main loop la ricopia)
+
+    // Event bus estratto (prima di m_serial: gli eventi di collegamento arrivano fino alla sua distruzione)
+    EventBus m_events;
 
     // componenti runtime
-    SerialService          m_serial;    // << prima era SerialController* + mutex
-    AudioController        m_master;
-    AudioSessionController m_sessions;
-    MappingExecutor        m_mapper{ 0.01f };
-    AudioEndpointController m_deviceCtrl;
+    SerialService          m_serial;    // N deck su un solo thread di IO
+    // master, sessioni, endpoint: tutte le chiamate (main loop e REST) passano dal thread del worker
+    std::unique_ptr<AudioWorker> m_audio = std::make_unique<AudioWorker>(std::make_unique<WasapiAudioBackend>());
+    // macro dei bottoni: delay su un thread proprio, le azioni audio passano da m_audio
+    MacroScheduler m_macros{ [this](const ButtonAction& a) { MappingExecutor::runAction(a, *m_audio); } };
+
+    std::vector<std::unique_ptr<DeckRuntime>> m_decks;
+    std::mutex m_decksMtx;
 
     // API
     std::unique_ptr<ApiServer> m_api;
@@ -72,9 +109,6 @@ private:
     // sync config
     std::mutex m_cfgMtx;
 
-    // Event bus estratto
-    EventBus m_events;
-
     // Helpers
     static std::string NowIsoUtc();
     static bool IsProcessLikelyFullscreen(unsigned long pid);
@@ -1,72 +1,85 @@
 ﻿#include "utils/MappingExecutor.hpp"
+#ifdef _WIN32
 #include "Core/Actions/TextInput.hpp"
-#include <cmath>
-#include <windows.h> // Sleep
+#endif
 
-void MappingExecutor::preapply(const AppConfig& cfg, AudioController& master, AudioSessionController& sessions, const DeckState& initial) {
-    for (int i = 0; i < 5; ++i) {
+void MappingExecutor::preapply(const DeckMapping& cfg, AudioBackend& audio, const DeckState& initial) {
+    for (size_t i = 0; i < DeckState::kSliders; ++i) {
         if (!cfg.sliderMap[i].has_value()) continue;
         const auto& tgt = *cfg.sliderMap[i];
-        float v01 = initial.sliders[i] / 1023.0f;
+        float v01 = cfg.sliderCurve[i][initial.sliders[i]];
 
         if (tgt.isMaster) {
-            master.setMasterVolume(v01);
+            audio.setMasterVolume(v01);
         }
         else {
-            for (const auto& exe : tgt.exes) {
-                sessions.setAppVolume(exe, v01);
-            }
+            audio.setAppsVolume(tgt.apps, v01);   // tutti gli exe in una passata sulle sessioni
         }
     }
 }
 
-void MappingExecutor::applyChanges(const AppConfig& cfg, AudioController& master, AudioSessionController& sessions, const DeckState& s, DeckState& prev) {
+void MappingExecutor::recordLatency(const DeckState& s, std::chrono::steady_clock::time_point pickedAt) {
+    const auto done = std::chrono::steady_clock::now();
+    m_latency.loopToAudio.record(done - pickedAt);
+
+    // read->parse e parse->loop una sola volta per campione: un giro ripetuto
+    // sullo stesso stato pubblicato non è nuova latenza di ingresso
+    if (s.parsedAt == std::chrono::steady_clock::time_point{} || s.parsedAt == m_lastParsedAt) return;
+    m_lastParsedAt = s.parsedAt;
+    m_latency.readToParse.record(s.parsedAt - s.readAt);
+    m_latency.parseToLoop.record(pickedAt - s.parsedAt);
+}
+
+void MappingExecutor::applyChanges(const DeckMapping& cfg, AudioBackend& audio, const DeckState& s, DeckState& prev,
+    std::chrono::steady_clock::time_point pickedAt) {
+    bool volumeApplied = false;
+
     // SLIDERS → volume
-    for (int i = 0; i < 5; ++i) {
+    for (size_t i = 0; i < DeckState::kSliders; ++i) {
         if (!cfg.sliderMap[i].has_value()) continue;
 
-        float v01 = s.sliders[i] / 1023.0f;
-        float p01 = prev.sliders[i] / 1023.0f;
-        if (std::abs(v01 - p01) < m_sliderDeltaThreshold) continue;
+        if (s.sliders[i] == prev.sliders[i]) continue;
+        float v01 = cfg.sliderCurve[i][s.sliders[i]];
 
         const auto& tgt = *cfg.sliderMap[i];
         if (tgt.isMaster) {
-            master.setMasterVolume(v01);
+            audio.setMasterVolume(v01);
         }
         else {
-            for (const auto& exe : tgt.exes) {
-                sessions.setAppVolume(exe, v01);
-            }
-        }
-    }
-
-    // BUTTONS → azioni (in ordine) sul rising edge
-    for (int i = 0; i < 5; ++i) {
-        bool was = prev.buttons[i];
-        bool now = s.buttons[i];
-        if (!was && now) {
-            for (const auto& act : cfg.buttonActions[i]) {
-                switch (act.kind) {
-                case BtnActKind::ToggleMuteMaster:
-                    master.toggleMasterMute();
-                    break;
-                case BtnActKind::ToggleMuteApp:
-                    sessions.toggleAppMute(act.payload);
-                    break;
-                case BtnActKind::Hotkey:
-                case BtnActKind::Media:
-                    SendHotkeyTap(act.chord);
-                    break;
-                case BtnActKind::Text:
-                    SendTextUTF8(act.payload);
-                    break;
-                case BtnActKind::Delay:
-                    Sleep(act.delayMs);
-                    break;
-                }
-            }
+            audio.setAppsVolume(tgt.apps, v01);   // tutti gli exe in una passata sulle sessioni
         }
+        volumeApplied = true;
     }
+    if (volumeApplied) recordLatency(s, pickedAt);
 
     prev = s; // aggiorna "prev" a fine ciclo
-}
\ No newline at end of file
+}
+
+void MappingExecutor::applyButtonEdge(const DeckMapping& cfg, MacroScheduler& macros, const std::string& device, const ButtonEdge& e) {
+    if (!e.pressed || e.button >= DeckState::kButtons) return;
+    if (cfg.buttonActions[e.button].empty()) return;
+
+    macros.press(device, e.button, cfg.buttonActions[e.button], cfg.buttonPolicy[e.button]);
+}
+
+void MappingExecutor::runAction(const ButtonAction& act, AudioBackend& audio) {
+    switch (act.kind) {
+    case BtnActKind::ToggleMuteMaster:
+        audio.toggleMasterMute();
+        break;
+    case BtnActKind::ToggleMuteApp:
+        audio.toggleAppMute(act.payload);
+        break;
+#ifdef _WIN32
+    case BtnActKind::Hotkey:
+    case BtnActKind::Media:
+        SendHotkeyTap(act.chord);
+        break;
+    case BtnActKind::Text:
+        SendTextUTF8(act.payload);
+        break;
+#endif
+    default:
+        break;
+    }
+}
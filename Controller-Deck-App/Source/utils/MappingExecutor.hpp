@@ -1,23 +1,47 @@
 ﻿#pragma once
 #include "utils/Config.hpp"
+#include "utils/MacroScheduler.hpp"
 #include "Core/DeckState.hpp"
-#include "Core/Audio/AudioController.hpp"
-#include "Core/Audio/AudioSessionController.hpp"
+#include "Core/ButtonEdgeQueue.hpp"
+#include "Core/Audio/AudioBackend.hpp"
+#include "Core/Metrics/LatencyHistogram.hpp"
+#include <chrono>
 
-// Applica i mapping di slider/bottoni ai controller audio
+// Latenze per stadio dei campioni che hanno prodotto una chiamata di volume
+struct MappingLatency {
+    LatencyHistogram readToParse;   // read seriale completata -> frame parsato
+    LatencyHistogram parseToLoop;   // frame parsato -> prelevato dal main loop
+    LatencyHistogram loopToAudio;   // prelevato dal main loop -> comandi audio accodati (AudioWorker)
+};
+
+// Applica i mapping di slider/bottoni al backend audio (WASAPI nell'app, mock nei bench)
 class MappingExecutor {
 public:
-    // soglie in percentuale (0..1)
-    explicit MappingExecutor(float sliderDeltaThreshold = 0.01f)
-        : m_sliderDeltaThreshold(sliderDeltaThreshold) {
-    }
-
     // Applica lo stato iniziale
-    void preapply(const AppConfig& cfg, AudioController& master, AudioSessionController& sessions, const DeckState& initial);
+    static void preapply(const DeckMapping& cfg, AudioBackend& audio, const DeckState& initial);
+
+    // Applica gli slider cambiati rispetto a prev, poi prev = current. Nessuna soglia
+    // qui: i valori arrivano già dalla catena di filtri (FaderFilterChain, stadio min_delta).
+    // Conteggi -> volume: un accesso alla curva compilata dello slider (cfg.sliderCurve).
+    // pickedAt = istante in cui il main loop ha letto lo stato (per le latenze).
+    void applyChanges(const DeckMapping& cfg, AudioBackend& audio, const DeckState& current, DeckState& prev,
+        std::chrono::steady_clock::time_point pickedAt = std::chrono::steady_clock::now());
 
-    // Applica differenze (usa prev per edge detection e delta slider)
-    void applyChanges(const AppConfig& cfg, AudioController& master, AudioSessionController& sessions, const DeckState& current, DeckState& prev);
+    // Su un fronte di press consegna le azioni del bottone allo scheduler come nuova
+    // istanza della macro (i release non hanno azioni): i delay non fermano il main loop.
+    // I fronti arrivano dalla ButtonEdgeQueue del deck: uno per ogni press fisico.
+    static void applyButtonEdge(const DeckMapping& cfg, MacroScheduler& macros, const std::string& device, const ButtonEdge& e);
+
+    // Una singola azione di bottone (il Runner dello scheduler). Delay è dello scheduler.
+    // Hotkey e testo esistono solo su Windows; altrove restano le azioni audio.
+    static void runAction(const ButtonAction& act, AudioBackend& audio);
+
+    // Istogrammi lock-free: letti/azzerati dai thread REST
+    MappingLatency& latency() { return m_latency; }
 
 private:
-    float m_sliderDeltaThreshold;
+    void recordLatency(const DeckState& s, std::chrono::steady_clock::time_point pickedAt);
+
+    MappingLatency m_latency;
+    std::chrono::steady_clock::time_point m_lastParsedAt{}; // ultimo campione già conteggiato
 };
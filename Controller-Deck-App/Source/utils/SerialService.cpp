@@ -1,33 +1,174 @@
 ﻿#include "utils/SerialService.hpp"
+#include <algorithm>
+#include <fmt/core.h>
+
+SerialService::SerialService(size_t ioThreads)
+    : m_io(ioThreads) {
+}
 
 SerialService::~SerialService() {
-    std::string dummy;
-    (void)close(&dummy);
+    closeAll();
+    m_io.stop();
+}
+
+SerialService::Device* SerialService::find(const std::string& id) const {
+    const size_t n = m_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) if (m_devices[i]->id == id) return m_devices[i].get();
+    return nullptr;
 }
 
-bool SerialService::open(const std::string& port, unsigned baud, std::string* outErr) {
+SerialService::Device* SerialService::findOrAdd(const std::string& id) {
+    const size_t n = m_count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < n; ++i) if (m_devices[i]->id == id) return m_devices[i].get();
+    if (n == kMaxDevices) return nullptr;
+
+    auto dev = std::make_unique<Device>();
+    dev->id = id;
+    dev->store.setNotifier(&m_changed);
+    dev->edges.setNotifier(&m_changed);
+    m_devices[n] = std::move(dev);
+    m_count.store(n + 1, std::memory_order_release);
+    return m_devices[n].get();
+}
+
+std::unique_ptr<SerialController> SerialService::makeController(Device* dev, const std::string& port, unsigned baud) {
+    auto ctl = std::make_unique<SerialController>(m_io.context(), port, baud, dev->store);
+    ctl->setOnLink([this, dev](SerialLinkState st) {
+        const bool up = (st == SerialLinkState::Connected);
+        dev->connected.store(up, std::memory_order_release);
+        if (m_onLink) m_onLink(dev->id, st);
+        m_changed.notify();   // il main loop vede subito attacco/stacco
+        });
+    ctl->setFilters(dev->filters);
+    ctl->setDebounce(dev->debounce);
+    ctl->setEdgeQueue(&dev->edges);
+    ctl->setHistory(&dev->history);
+    ctl->setCapture(dev->capture);
+    return ctl;
+}
+
+void SerialService::stopDevice(Device* dev) {
+    if (dev->replayThread.joinable()) {
+        dev->replayCancel.store(true, std::memory_order_relaxed);
+        dev->replayThread.join();
+    }
+    if (dev->serial) { dev->serial->stop(); dev->serial.reset(); }
+}
+
+bool SerialService::open(const std::string& id, const std::string& port, unsigned baud, std::string* outErr) {
     std::lock_guard<std::mutex> lk(m_mx);
+    Device* dev = findOrAdd(id);
+    if (!dev) { if (outErr) *outErr = "too_many_devices"; return false; }
+
     try {
-        if (m_serial) { m_serial->stop(); m_serial.reset(); }
-        m_serial = std::make_unique<SerialController>(port, baud);
-        m_serial->start();
-        m_port = port;
-        m_baud = baud;
+        stopDevice(dev);
+
+        // Nessun reader attivo: si riparte da uno stato vuoto, come un device appena collegato
+        dev->store.set(DeckState{});
+        dev->serial = makeController(dev, port, baud);
+        dev->serial->start();
+        dev->port = port;
+        dev->baud = baud;
         return true;
     }
     catch (...) {
         if (outErr) *outErr = "open_failed";
-        m_serial.reset();
+        dev->serial.reset();
+        dev->store.set(DeckState{});
         return false;
     }
 }
 
-bool SerialService::close(std::string* outErr) {
+bool SerialService::setFilters(const std::string& id, const FilterChainConfig& cfg) {
+    std::lock_guard<std::mutex> lk(m_mx);
+    Device* dev = findOrAdd(id);
+    if (!dev) return false;
+    dev->filters = cfg;
+    if (dev->serial) dev->serial->setFilters(cfg);
+    return true;
+}
+
+bool SerialService::setDebounce(const std::string& id, std::chrono::microseconds window) {
+    std::lock_guard<std::mutex> lk(m_mx);
+    Device* dev = findOrAdd(id);
+    if (!dev) return false;
+    dev->debounce = window;
+    if (dev->serial) dev->serial->setDebounce(window);
+    return true;
+}
+
+bool SerialService::startCapture(const std::string& id, const std::string& path, std::string* outErr) {
+    std::lock_guard<std::mutex> lk(m_mx);
+    Device* dev = find(id);
+    if (!dev) { if (outErr) *outErr = "unknown_device"; return false; }
+
+    auto w = std::make_shared<SerialCaptureWriter>();
+    std::string err;
+    if (!w->open(path, err)) { if (outErr) *outErr = err; return false; }
+    dev->capture = w;
+    if (dev->serial) dev->serial->setCapture(std::move(w));
+    return true;
+}
+
+SerialCaptureStatus SerialService::stopCapture(const std::string& id) {
+    std::lock_guard<std::mutex> lk(m_mx);
+    Device* dev = find(id);
+    if (!dev || !dev->capture) return {};
+    // lo stato si legge prima: il file viene chiuso dal thread di IO quando rilascia la cattura
+    SerialCaptureStatus st{ false, dev->capture->path(), dev->capture->bytes(), dev->capture->frames(), dev->capture->dropped() };
+    dev->capture.reset();
+    if (dev->serial) dev->serial->setCapture(nullptr);
+    return st;
+}
+
+SerialCaptureStatus SerialService::captureStatus(const std::string& id) const {
+    std::lock_guard<std::mutex> lk(m_mx);
+    const Device* dev = find(id);
+    if (!dev || !dev->capture) return {};
+    return { true, dev->capture->path(), dev->capture->bytes(), dev->capture->frames(), dev->capture->dropped() };
+}
+
+bool SerialService::replay(const std::string& id, const std::string& path, double speed, std::string* outErr) {
     std::lock_guard<std::mutex> lk(m_mx);
-    if (!m_serial) { if (outErr) *outErr = "not_connected"; return false; }
+    Device* dev = find(id);
+    if (!dev) { if (outErr) *outErr = "unknown_device"; return false; }
+
+    auto cap = std::make_unique<SerialCaptureReader>();
+    std::string err;
+    if (!cap->open(path, err)) { if (outErr) *outErr = err; return false; }
+
+    stopDevice(dev);
+    dev->store.set(DeckState{});
+    dev->serial = makeController(dev, "replay:" + path, 0);
+    dev->port = "replay:" + path;
+    dev->baud = 0;
+
+    dev->replayCancel.store(false, std::memory_order_relaxed);
+    dev->replaying.store(true, std::memory_order_release);
+    SerialController* ctl = dev->serial.get();   // vive finché il thread non è stato atteso (stopDevice)
+    dev->replayThread = std::thread([dev, ctl, cap = std::move(cap), speed] {
+        const ReplayStats rs = ctl->replay(*cap, speed, &dev->replayCancel);
+        dev->replaying.store(false, std::memory_order_release);
+        fmt::print("Replay {}: {} frame da {} read, {:.2f} s di cattura in {:.2f} s ({:.0f} frame/s){}\n",
+            dev->id, rs.frames, rs.reads, rs.capturedSec, rs.elapsedSec,
+            rs.elapsedSec > 0 ? static_cast<double>(rs.frames) / rs.elapsedSec : 0.0,
+            rs.completed ? "" : " - interrotto");
+        });
+    return true;
+}
+
+bool SerialService::isReplaying(const std::string& id) const {
+    const Device* dev = find(id);
+    return dev && dev->replaying.load(std::memory_order_acquire);
+}
+
+bool SerialService::close(const std::string& id, std::string* outErr) {
+    std::lock_guard<std::mutex> lk(m_mx);
+    Device* dev = find(id);
+    if (!dev || !dev->serial) { if (outErr) *outErr = "not_connected"; return false; }
     try {
-        m_serial->stop();
-        m_serial.reset();
+        stopDevice(dev);   // notifica Stopped: connected torna false
+        dev->store.set(DeckState{});
         return true;
     }
     catch (...) {
@@ -36,15 +177,82 @@ bool SerialService::close(std::string* outErr) {
     }
 }
 
-bool SerialService::isConnected() const {
+void SerialService::closeAll() {
+    for (const auto& id : deviceIds()) {
+        std::string dummy;
+        (void)close(id, &dummy);
+    }
+}
+
+std::vector<std::string> SerialService::deviceIds() const {
+    std::vector<std::string> out;
+    const size_t n = m_count.load(std::memory_order_acquire);
+    out.reserve(n);
+    for (size_t i = 0; i < n; ++i) out.push_back(m_devices[i]->id);
+    return out;
+}
+
+std::optional<size_t> SerialService::indexOf(const std::string& id) const {
+    const size_t n = m_count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) if (m_devices[i]->id == id) return i;
+    return std::nullopt;
+}
+
+bool SerialService::isConnected(size_t index) const {
+    if (index >= m_count.load(std::memory_order_acquire)) return false;
+    return m_devices[index]->connected.load(std::memory_order_acquire);
+}
+
+DeckState SerialService::readState(size_t index, uint64_t& version) const {
+    if (index >= m_count.load(std::memory_order_acquire)) { version = 0; return DeckState{}; }
+    return m_devices[index]->store.get(version);
+}
+
+bool SerialService::isConnected(const std::string& id) const {
+    const Device* dev = find(id);
+    return dev && dev->connected.load(std::memory_order_acquire);
+}
+
+DeckState SerialService::readState(const std::string& id) const {
+    const Device* dev = find(id);
+    return dev ? dev->store.get() : DeckState{};
+}
+
+SerialStats SerialService::stats(const std::string& id) const {
     std::lock_guard<std::mutex> lk(m_mx);
-    return (bool)m_serial;
+    const Device* dev = find(id);
+    return (dev && dev->serial) ? dev->serial->stats() : SerialStats{};
 }
 
-DeckState SerialService::readState() const {
+std::vector<FilterStageStats> SerialService::filterStats(const std::string& id) const {
     std::lock_guard<std::mutex> lk(m_mx);
-    return m_serial ? m_serial->store().get() : DeckState{};
+    const Device* dev = find(id);
+    return (dev && dev->serial) ? dev->serial->filterStats() : std::vector<FilterStageStats>{};
 }
 
-std::string SerialService::port() const { std::lock_guard<std::mutex> lk(m_mx); return m_port; }
-unsigned SerialService::baud() const { std::lock_guard<std::mutex> lk(m_mx); return m_baud; }
+bool SerialService::queryHistory(const std::string& id, size_t channel, SampleHistory::Source src,
+                                 int64_t fromMs, int64_t toMs, size_t maxPoints,
+                                 HistorySeries& out, uint32_t& nowMs) const {
+    const Device* dev = find(id);   // lock-free: lo storico vive quanto il device
+    if (!dev) return false;
+    nowMs = dev->history.nowMs();
+    // negativo = relativo a adesso (es. -10000 = ultimi 10 s)
+    const auto resolve = [nowMs](int64_t ms) {
+        if (ms < 0) ms += nowMs;
+        return static_cast<uint32_t>(std::clamp<int64_t>(ms, 0, UINT32_MAX));
+    };
+    // oltre "adesso" non ci sono campioni: la serie si ferma lì
+    return dev->history.query(channel, src, std::min(resolve(fromMs), nowMs), std::min(resolve(toMs), nowMs), maxPoints, out);
+}
+
+std::string SerialService::port(const std::string& id) const {
+    std::lock_guard<std::mutex> lk(m_mx);
+    const Device* dev = find(id);
+    return dev ? dev->port : std::string();
+}
+
+unsigned SerialService::baud(const std::string& id) const {
+    std::lock_guard<std::mutex> lk(m_mx);
+    const Device* dev = find(id);
+    return dev ? dev->baud : 0;
+}
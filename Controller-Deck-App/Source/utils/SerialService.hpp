@@ -1,32 +1,160 @@
 ﻿#pragma once
 #include "Core/Serial/SerialController.hpp"
+#include "Core/Serial/SerialIoPool.hpp"
 #include "Core/DeckState.hpp"
+#include "Core/ChangeSignal.hpp"
+#include "Core/ButtonEdgeQueue.hpp"
+#include "Core/Metrics/SampleHistory.hpp"
+#include "utils/Config.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <mutex>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
+// Stato della cattura seriale di un device (snapshot)
+struct SerialCaptureStatus {
+    bool        active = false;
+    std::string path;
+    uint64_t    bytes = 0;
+    uint64_t    frames = 0;
+    uint64_t    dropped = 0;
+};
+
+// Gestisce N deck seriali identificati da un id.
+// - Tutti i reader condividono un SerialIoPool (1 thread di default): il numero
+//   di thread non cresce con il numero di device.
+// - Ogni device ha il proprio DeckStateStore e la propria ButtonEdgeQueue; tutti
+//   notificano lo stesso ChangeSignal, così il main loop attende un solo oggetto.
+// - I device registrati non vengono mai rimossi (close ferma solo la lettura):
+//   indici e store restano validi e le letture di stato sono lock-free.
+// - Un device aperto resta supervisionato: se si stacca, SerialController lo
+//   ritenta in background e isConnected riporta lo stato reale del collegamento.
+// - Cattura e replay: la seriale di un device può essere registrata su file; un
+//   replay prende il posto della porta e alimenta store, coda dei fronti e storico
+//   del device come la porta reale, quindi arriva fino al mapping dei volumi.
 class SerialService {
 public:
+    static constexpr size_t kMaxDevices = AppConfig::kMaxDevices;
+
+    // Cambio di stato del collegamento di un device (thread di IO o chiamante di close)
+    using LinkCallback = std::function<void(const std::string& id, SerialLinkState)>;
+
+    explicit SerialService(size_t ioThreads = 1);
     ~SerialService();
 
-    // Apre (o riapre) la seriale in modo atomico.
-    // outErr (opzionale) riceve "open_failed" in caso di eccezioni.
-    bool open(const std::string& port, unsigned baud, std::string* outErr = nullptr);
+    // Da impostare prima del primo open()
+    void setOnLink(LinkCallback cb) { m_onLink = std::move(cb); }
+
+    // Avvia (o riavvia) la seriale del device id, registrandolo se nuovo.
+    // Non attende l'apertura: se la porta non c'è, il device resta in
+    // "reconnecting" finché compare. outErr (opzionale) riceve "open_failed" o "too_many_devices".
+    bool open(const std::string& id, const std::string& port, unsigned baud, std::string* outErr = nullptr);
+
+    // Catena di filtri dei fader del device (registrandolo se nuovo): gira nel
+    // thread di IO su ogni campione, lo store riceve lo stato già filtrato.
+    // Resta valida anche per le riaperture successive.
+    bool setFilters(const std::string& id, const FilterChainConfig& cfg);
+    // Finestra di debounce dei bottoni del device (registrandolo se nuovo), come sopra
+    bool setDebounce(const std::string& id, std::chrono::microseconds window);
+
+    // Registra la seriale del device in un nuovo file path (se esiste già la cattura
+    // viene rifiutata) finché non si chiama stopCapture; resta attiva anche attraverso
+    // riaperture e riconnessioni.
+    // outErr: "unknown_device", "file_exists", "cannot_create_file", "cannot_map_file".
+    bool startCapture(const std::string& id, const std::string& path, std::string* outErr = nullptr);
+    // Ferma la cattura (il file viene chiuso dal thread di IO) e ne ritorna lo stato finale
+    SerialCaptureStatus stopCapture(const std::string& id);
+    [[nodiscard]] SerialCaptureStatus captureStatus(const std::string& id) const;
+
+    // Sostituisce la porta del device con il replay della cattura path, su un thread
+    // dedicato. speed: 1 = tempo reale, N = N volte più veloce, 0 = senza attese.
+    // open/close del device interrompono il replay.
+    // outErr: "unknown_device", "cannot_open_file", "bad_capture".
+    bool replay(const std::string& id, const std::string& path, double speed, std::string* outErr = nullptr);
+    [[nodiscard]] bool isReplaying(const std::string& id) const;
 
-    // Chiude la seriale. Se non aperta, ritorna false e imposta outErr="not_connected".
-    bool close(std::string* outErr = nullptr);
+    // Chiude la seriale del device. Se non aperta, ritorna false e imposta outErr="not_connected".
+    bool close(const std::string& id, std::string* outErr = nullptr);
+    void closeAll();
 
-    // Stato thread-safe
-    [[nodiscard]] bool isConnected() const;
-    [[nodiscard]] DeckState readState() const;
+    // Device registrati (in ordine di registrazione) e lookup id -> indice stabile
+    [[nodiscard]] std::vector<std::string> deviceIds() const;
+    [[nodiscard]] std::optional<size_t> indexOf(const std::string& id) const;
 
-    // Ultima configurazione nota (utile per /serial/status)
-    [[nodiscard]] std::string port() const;
-    [[nodiscard]] unsigned baud() const;
+    // Stato thread-safe e lock-free per indice (vedi indexOf) o per id.
+    // Un id sconosciuto risulta non connesso con stato vuoto.
+    [[nodiscard]] bool isConnected(size_t index) const;
+    [[nodiscard]] DeckState readState(size_t index, uint64_t& version) const;
+    // Consuma i fronti dei bottoni in coda (in ordine): fn(const ButtonEdge&).
+    // Un solo consumatore per device (il main loop).
+    template <class Fn>
+    size_t drainButtonEdges(size_t index, Fn&& fn) {
+        if (index >= m_count.load(std::memory_order_acquire)) return 0;
+        return m_devices[index]->edges.drain(std::forward<Fn>(fn));
+    }
+    [[nodiscard]] bool isConnected(const std::string& id) const;
+    [[nodiscard]] DeckState readState(const std::string& id) const;
+
+    [[nodiscard]] SerialStats stats(const std::string& id) const;   // protocollo rilevato + contatori errori
+    [[nodiscard]] std::vector<FilterStageStats> filterStats(const std::string& id) const;   // contatori per stadio
+
+    // Storico dei fader del device (grezzo e filtrato), lock-free: vedi SampleHistory::query.
+    // from/to negativi = relativi ad adesso, entrambi limitati ad adesso.
+    // false se il device o il canale non esistono. nowMs = "adesso" sul clock dello storico.
+    [[nodiscard]] bool queryHistory(const std::string& id, size_t channel, SampleHistory::Source src,
+                                    int64_t fromMs, int64_t toMs, size_t maxPoints,
+                                    HistorySeries& out, uint32_t& nowMs) const;
+
+    // Ultima configurazione nota del device (utile per /serial/status)
+    [[nodiscard]] std::string port(const std::string& id) const;
+    [[nodiscard]] unsigned baud(const std::string& id) const;
+
+    // Attende un nuovo stato da uno qualsiasi dei device (o wake()) fino a
+    // timeoutMs; -1 = senza limite. Pensata per un solo consumatore (il main loop).
+    bool waitForChange(int64_t timeoutMs = ChangeSignal::kInfinite) { return m_changed.waitFor(timeoutMs); }
+    void wake() { m_changed.notify(); }   // sveglia chi è in waitForChange (es. shutdown)
+    [[nodiscard]] uint64_t wakeups() const { return m_changed.wakeups(); }
 
 private:
-    mutable std::mutex m_mx;
-    std::unique_ptr<SerialController> m_serial;
-    std::string m_port;
-    unsigned m_baud{ 0 };
+    struct Device {
+        std::string    id;                       // immutabile dopo la registrazione
+        DeckStateStore store;                    // scrittore: thread di IO
+        ButtonEdgeQueue edges;                   // produttore: thread di IO, consumatore: main loop
+        SampleHistory  history;                  // scrittore: thread di IO, lettori: REST
+        std::atomic<bool> connected{ false };    // link Connected (scritto dalla LinkCallback)
+        std::unique_ptr<SerialController> serial; // protetti da m_mx
+        std::string    port;
+        unsigned       baud{ 0 };
+        FilterChainConfig filters{};
+        std::chrono::microseconds debounce{ 0 };
+        std::shared_ptr<SerialCaptureWriter> capture;   // cattura attiva (m_mx)
+
+        // replay: il controller è serial (mai avviato), alimentato da questo thread
+        std::thread       replayThread;
+        std::atomic<bool> replayCancel{ false };
+        std::atomic<bool> replaying{ false };
+    };
+
+    Device* find(const std::string& id) const;         // lock-free
+    Device* findOrAdd(const std::string& id);          // con m_mx tenuto
+    // Con m_mx tenuto: controller collegato a store, coda, storico, filtri e cattura del device
+    std::unique_ptr<SerialController> makeController(Device* dev, const std::string& port, unsigned baud);
+    void stopDevice(Device* dev);                      // con m_mx tenuto: ferma replay e controller
+
+    mutable std::mutex m_mx;                 // serializza open/close/stats e la config dei device
+    LinkCallback   m_onLink;
+    ChangeSignal   m_changed;                // notificato dagli store a ogni pubblicazione
+    SerialIoPool   m_io;
+
+    // Registro append-only: lo slot i è scritto prima di pubblicare m_count > i
+    std::array<std::unique_ptr<Device>, kMaxDevices> m_devices;
+    std::atomic<size_t> m_count{ 0 };
 };
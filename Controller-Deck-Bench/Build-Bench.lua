@@ -0,0 +1,62 @@
+project "Controller-Deck-Bench"
+    kind "ConsoleApp"              -- micro-benchmark della pipeline (Windows + Linux)
+    language "C++"
+    cppdialect "C++20"
+    characterset "Unicode"
+    staticruntime "off"
+
+    exceptionhandling "On"
+    defines { "_HAS_EXCEPTIONS=1", "FMT_USE_EXCEPTIONS=1", "ASIO_STANDALONE" }
+
+    targetdir ("../Binaries/" .. OutputDir .. "/%{prj.name}")
+    objdir    ("../Binaries/Intermediates/" .. OutputDir .. "/%{prj.name}")
+
+    files {
+        "Source/**.h",
+        "Source/**.hpp",
+        "Source/**.cpp",
+        "../Controller-Deck-App/Source/utils/MappingExecutor.cpp",  -- mapping su AudioBackend (mock)
+        "../Controller-Deck-App/Source/utils/MacroScheduler.cpp"    -- macro dei bottoni
+    }
+
+    includedirs {
+        "Source",
+        "../Controller-Deck-Core/Source",  -- include Core
+        "../Controller-Deck-App/Source"    -- MappingExecutor, MacroScheduler + Config
+    }
+
+    links {
+        "Controller-Deck-Core"
+    }
+
+    filter "system:windows"
+        systemversion "latest"
+        defines { "_WIN32_WINNT=0x0A00", "WIN32_LEAN_AND_MEAN", "NOMINMAX" }
+        buildoptions { "/utf-8" }
+        links { "setupapi", "ws2_32", "mswsock", "advapi32" }
+    filter {}
+
+    filter "system:linux"
+        links { "fmt", "pthread" }
+    filter {}
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        runtime "Debug"
+        symbols "On"
+    filter {}
+
+    -- i numeri hanno senso solo con le ottimizzazioni attive
+    filter "configurations:Release"
+        defines { "RELEASE" }
+        runtime "Release"
+        optimize "Full"
+        symbols "On"
+    filter {}
+
+    filter "configurations:Dist"
+        defines { "DIST" }
+        runtime "Release"
+        optimize "Full"
+        symbols "Off"
+    filter {}
@@ -0,0 +1,58 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <fmt/core.h>
+
+// Mini-harness per i benchmark: ogni file registra i propri casi con BENCH_CASE
+// e main() li esegue tutti (o solo quelli che contengono il filtro passato).
+namespace Bench {
+
+    using Fn = void(*)();
+
+    struct Case {
+        const char* name;
+        Fn fn;
+    };
+
+    inline std::vector<Case>& Registry() {
+        static std::vector<Case> r;
+        return r;
+    }
+
+    struct Registrar {
+        Registrar(const char* name, Fn fn) { Registry().push_back({ name, fn }); }
+    };
+
+    // Impedisce al compilatore di eliminare il risultato calcolato
+    template <class T>
+    inline void DoNotOptimize(const T& v) {
+        static volatile const void* sink;
+        sink = &v;
+        (void)sink;
+    }
+
+    // Cronometro monotono in nanosecondi
+    class Timer {
+    public:
+        Timer() : m_start(std::chrono::steady_clock::now()) {}
+        double elapsedNs() const {
+            return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_start).count();
+        }
+    private:
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    // Riga di report uniforme: nome, ns/op e op/s
+    inline void Report(const std::string& label, double totalNs, uint64_t ops) {
+        const double nsPerOp = ops ? totalNs / (double)ops : 0.0;
+        const double opsPerSec = totalNs > 0 ? (double)ops * 1e9 / totalNs : 0.0;
+        fmt::print("  {:<40} {:>10.1f} ns/op  {:>14.0f} op/s\n", label, nsPerOp, opsPerSec);
+    }
+}
+
+#define BENCH_CASE(name) \
+    static void name(); \
+    static Bench::Registrar name##_registrar{ #name, &name }; \
+    static void name()
@@ -0,0 +1,109 @@
+#include "Bench.hpp"
+#include "Core/Metrics/SampleHistory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+// Costo di /state/history sullo storico pieno (32768 campioni, ~32 s a 1 kHz).
+// Prima: ring di campioni AoS (tempo + int per canale) sotto mutex, copiato per
+// intero e poi decimato. Dopo: SampleHistory::query, che cerca l'intervallo per
+// bisezione e decima leggendo in place un solo canale a 16 bit.
+// Verifica che le due serie coincidano e misura anche push() per campione.
+
+namespace {
+
+    struct AosSample {
+        SampleHistory::Clock::time_point at;
+        std::array<int, SampleHistory::kChannels> raw, filtered;
+    };
+
+    class AosHistory {
+    public:
+        AosHistory() : m_ring(SampleHistory::kCapacity) {}
+
+        void push(SampleHistory::Clock::time_point at, const std::array<int, SampleHistory::kChannels>& raw,
+                  const std::array<int, SampleHistory::kChannels>& filtered) {
+            std::lock_guard<std::mutex> lk(m_mx);
+            m_ring[m_head++ % m_ring.size()] = AosSample{ at, raw, filtered };
+        }
+
+        void query(const SampleHistory& clock, uint32_t from, uint32_t to, size_t maxPoints, HistorySeries& out) const {
+            std::vector<AosSample> copy;
+            {
+                std::lock_guard<std::mutex> lk(m_mx);
+                const size_t n = std::min(m_head, m_ring.size());
+                copy.reserve(n);
+                for (size_t i = m_head - n; i < m_head; ++i) copy.push_back(m_ring[i % m_ring.size()]);
+            }
+            const uint64_t width = (uint64_t{ to } - from + maxPoints) / maxPoints;
+            out = HistorySeries{};
+            uint64_t bucket = UINT64_MAX;
+            for (const auto& c : copy) {
+                const uint32_t t = clock.toMs(c.at);
+                if (t < from || t > to) continue;
+                const uint16_t v = static_cast<uint16_t>(c.filtered[0]);
+                const uint64_t b = (t - from) / width;
+                if (b != bucket) {
+                    out.t.push_back(t); out.min.push_back(v); out.max.push_back(v); out.last.push_back(v);
+                    bucket = b;
+                }
+                out.t.back() = t;
+                out.min.back() = std::min(out.min.back(), v);
+                out.max.back() = std::max(out.max.back(), v);
+                out.last.back() = v;
+                ++out.samples;
+            }
+        }
+
+    private:
+        mutable std::mutex m_mx;
+        std::vector<AosSample> m_ring;
+        size_t m_head = 0;
+    };
+}
+
+BENCH_CASE(HistoryQuery) {
+    SampleHistory h;
+    AosHistory ref;
+    const auto base = SampleHistory::Clock::now();
+
+    std::array<int, SampleHistory::kChannels> raw{}, filtered{};
+    auto fill = [&](auto& dst) {
+        for (size_t i = 0; i < SampleHistory::kCapacity; ++i) {
+            for (size_t k = 0; k < raw.size(); ++k) {
+                raw[k] = static_cast<int>((i * (k + 1) * 7) % 1024);
+                filtered[k] = raw[k] & ~7;
+            }
+            dst.push(base + std::chrono::milliseconds(i), raw, filtered);   // 1 kHz
+        }
+    };
+    Bench::Timer tp0;
+    fill(ref);
+    const double nsPushRef = tp0.elapsedNs();
+    Bench::Timer tp1;
+    fill(h);
+    const double nsPush = tp1.elapsedNs();
+    Bench::Report("push AoS sotto mutex (riferimento)", nsPushRef, SampleHistory::kCapacity);
+    Bench::Report("push SoA 16 bit (SampleHistory)", nsPush, SampleHistory::kCapacity);
+
+    const uint32_t to = h.toMs(base + std::chrono::milliseconds(SampleHistory::kCapacity));
+    const uint32_t from = to - 30000;
+    constexpr int kIters = 200;
+
+    HistorySeries a, b;
+    Bench::Timer t0;
+    for (int i = 0; i < kIters; ++i) { ref.query(h, from, to, 500, a); Bench::DoNotOptimize(a); }
+    const double nsCopy = t0.elapsedNs();
+
+    Bench::Timer t1;
+    for (int i = 0; i < kIters; ++i) { h.query(0, SampleHistory::Source::Filtered, from, to, 500, b); Bench::DoNotOptimize(b); }
+    const double nsQuery = t1.elapsedNs();
+
+    Bench::Report("30 s -> 500 punti, copia + decimazione", nsCopy, kIters);
+    Bench::Report("30 s -> 500 punti, query in place", nsQuery, kIters);
+    if (a.t != b.t || a.min != b.min || a.max != b.max || a.last != b.last || a.samples != b.samples)
+        fmt::print("  ATTENZIONE: serie diverse ({} vs {} punti, {} vs {} campioni)\n", a.t.size(), b.t.size(), a.samples, b.samples);
+}
@@ -0,0 +1,121 @@
+#include "Bench.hpp"
+#include "Core/Audio/MockAudioBackend.hpp"
+#include "utils/MacroScheduler.hpp"
+#include "utils/MappingExecutor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Main loop con una macro in corso: la macro di config.json (4 lettere separate
+// da delay:40) premuta mentre i fader continuano a pubblicare stati. Prima il
+// delay era uno Sleep in linea (giro del press >= 120 ms, fader fermi); ora il
+// giro del press costa un accodamento e i delay scadono sul thread di
+// MacroScheduler. Misura il giro peggiore del main loop, il ritardo dei delay
+// rispetto al previsto e, per policy, cosa succede a 5 press ravvicinati.
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    ButtonAction Act(BtnActKind kind, const char* payload = "", unsigned delayMs = 0) {
+        ButtonAction a;
+        a.kind = kind;
+        a.payload = payload;
+        a.delayMs = delayMs;
+        return a;
+    }
+
+    // Runner che registra l'istante di ogni azione eseguita
+    struct Recorder {
+        std::mutex mtx;
+        std::vector<Clock::time_point> at;
+        void operator()(const ButtonAction&) { std::lock_guard<std::mutex> lk(mtx); at.push_back(Clock::now()); }
+        size_t count() { std::lock_guard<std::mutex> lk(mtx); return at.size(); }
+    };
+
+    bool WaitIdle(MacroScheduler& s, std::chrono::milliseconds timeout) {
+        const auto end = Clock::now() + timeout;
+        while (s.active() > 0) {
+            if (Clock::now() > end) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+}
+
+BENCH_CASE(MacroNonBlocking) {
+    const std::vector<ButtonAction> macro = {
+        Act(BtnActKind::Text, "c"), Act(BtnActKind::Delay, "", 40),
+        Act(BtnActKind::Text, "i"), Act(BtnActKind::Delay, "", 40),
+        Act(BtnActKind::Text, "a"), Act(BtnActKind::Delay, "", 40),
+        Act(BtnActKind::Text, "o")
+    };
+    unsigned totalDelayMs = 0;
+    for (const auto& a : macro) totalDelayMs += a.delayMs;
+
+    DeckMapping mapping;
+    for (size_t k = 0; k < DeckState::kSliders; ++k) mapping.sliderMap[k] = SliderTarget{ true, {} };
+    mapping.buttonActions[0] = macro;
+
+    Recorder rec;
+    MacroScheduler sched([&](const ButtonAction& a) { rec(a); });
+    sched.start();
+
+    // ~200 ms di fader a 1 kHz con un press al primo giro
+    MockAudioBackend audio;
+    MappingExecutor mapper;
+    DeckState prev{}, cur{};
+    double worstNs = 0, pressNs = 0;
+    const auto t0 = Clock::now();
+    Bench::Timer total;
+    for (int i = 0; i < 200; ++i) {
+        cur.sliders[i % DeckState::kSliders] = (i * 7) % 1024;
+        Bench::Timer t;
+        if (i == 0) MappingExecutor::applyButtonEdge(mapping, sched, "bench", ButtonEdge{ 0, true, {} });
+        mapper.applyChanges(mapping, audio, cur, prev);
+        const double ns = t.elapsedNs();
+        if (i == 0) pressNs = ns;
+        worstNs = std::max(worstNs, ns);
+        std::this_thread::sleep_until(t0 + std::chrono::milliseconds(i + 1));
+    }
+    const double loopNs = total.elapsedNs();
+    if (!WaitIdle(sched, std::chrono::seconds(1))) fmt::print("  ATTENZIONE: la macro non è terminata\n");
+
+    fmt::print("  prima: giro del press >= {} ms (Sleep in linea), fader fermi per tutta la macro\n", totalDelayMs);
+    fmt::print("  dopo:  giro del press {:.1f} us, giro peggiore {:.1f} us, 200 giri in {:.1f} ms\n",
+        pressNs / 1000.0, worstNs / 1000.0, loopNs / 1e6);
+
+    // ritardo di ogni gruppo rispetto alla somma dei delay che lo precedono
+    if (rec.count() == 4) {
+        double lateMax = 0;
+        for (size_t g = 1; g < 4; ++g) {
+            const double ms = std::chrono::duration<double, std::milli>(rec.at[g] - rec.at[0]).count();
+            lateMax = std::max(lateMax, ms - 40.0 * g);
+        }
+        fmt::print("  macro in {:.1f} ms (attesi {} ms), ritardo massimo di un delay {:.2f} ms\n",
+            std::chrono::duration<double, std::milli>(rec.at[3] - rec.at[0]).count(), totalDelayMs, lateMax);
+    }
+    else fmt::print("  ATTENZIONE: eseguite {} azioni su 4\n", rec.count());
+
+    // 5 press a 5 ms l'uno dall'altro su una macro da 20 ms, per policy
+    const std::vector<ButtonAction> shortMacro = { Act(BtnActKind::Text, "x"), Act(BtnActKind::Delay, "", 20), Act(BtnActKind::Text, "y") };
+    for (MacroPolicy p : { MacroPolicy::Queue, MacroPolicy::Restart, MacroPolicy::Ignore }) {
+        Recorder r;
+        MacroScheduler s([&](const ButtonAction& a) { r(a); });
+        s.start();
+        const auto start = Clock::now();
+        for (int i = 0; i < 5; ++i) {
+            s.press("bench", 0, shortMacro, p);
+            std::this_thread::sleep_until(start + std::chrono::milliseconds(5 * (i + 1)));
+        }
+        WaitIdle(s, std::chrono::seconds(1));
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        const MacroStats st = s.stats();
+        const char* name = p == MacroPolicy::Queue ? "queue" : p == MacroPolicy::Restart ? "restart" : "ignore";
+        fmt::print("  {:<7}: partite {} completate {} annullate {} scartate {}, azioni {}, {:.0f} ms\n",
+            name, st.started, st.completed, st.cancelled, st.ignored, r.count(), ms);
+    }
+}
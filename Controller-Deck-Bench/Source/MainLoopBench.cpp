@@ -0,0 +1,101 @@
+#include "Bench.hpp"
+#include "Core/DeckState.hpp"
+#include "Core/ChangeSignal.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Main loop: polling con sleep da 10 ms (vecchio MainApp::run) contro attesa su
+// ChangeSignal notificato dallo store. Un produttore simula il thread di IO:
+// 1 s di fader in movimento a 100 campioni/s, poi 1 s fermo. Per ogni modalità
+// si misura la latenza pubblicazione -> main loop e i risvegli al secondo,
+// separando la fase attiva da quella a riposo.
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int kSamples = 100;                                  // campioni nella fase attiva
+    constexpr auto kPeriod = std::chrono::milliseconds(10);        // 100 Hz
+    constexpr auto kIdle = std::chrono::seconds(1);
+
+    struct Result {
+        std::vector<double> latUs;
+        uint64_t wakeActive = 0;
+        uint64_t wakeIdle = 0;
+    };
+
+    double Pct(std::vector<double> v, double p) {
+        if (v.empty()) return 0.0;
+        const size_t k = std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())));
+        std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(k), v.end());
+        return v[k];
+    }
+
+    template <class Wait>
+    Result Run(DeckStateStore& store, Wait&& wait) {
+        Result r;
+        std::atomic<int64_t> publishedAt{ 0 };
+        std::atomic<bool> idle{ false }, done{ false };
+
+        std::thread producer([&] {
+            auto next = Clock::now();
+            for (int i = 1; i <= kSamples; ++i) {
+                next += kPeriod;
+                std::this_thread::sleep_until(next);
+                DeckState s{};
+                s.sliders[0] = i;
+                publishedAt.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+                store.set(s);
+            }
+            std::this_thread::sleep_for(kPeriod);
+            idle = true;
+            std::this_thread::sleep_for(kIdle);
+            done = true;
+            store.set(DeckState{}); // sveglia il consumatore per l'uscita
+            });
+
+        uint64_t lastVer = store.version();
+        while (!done.load()) {
+            wait();
+            if (done.load()) break;
+            (idle.load() ? r.wakeIdle : r.wakeActive)++;
+
+            uint64_t ver;
+            (void)store.get(ver);
+            if (ver != lastVer && !idle.load()) {
+                const int64_t t0 = publishedAt.load(std::memory_order_relaxed);
+                const double dt = std::chrono::duration<double, std::micro>(Clock::now().time_since_epoch() - Clock::duration(t0)).count();
+                r.latUs.push_back(dt);
+            }
+            lastVer = ver;
+        }
+        producer.join();
+        return r;
+    }
+
+    void Print(const char* label, const Result& r) {
+        const double activeSec = std::chrono::duration<double>(kPeriod * (kSamples + 1)).count();
+        const double idleSec = std::chrono::duration<double>(kIdle).count();
+        fmt::print("  {:<22} latenza p50={:>8.1f} us  p99={:>8.1f} us  max={:>8.1f} us | risvegli/s attivo={:>6.0f}  riposo={:>6.0f}\n",
+            label, Pct(r.latUs, 0.50), Pct(r.latUs, 0.99), Pct(r.latUs, 1.0),
+            static_cast<double>(r.wakeActive) / activeSec, static_cast<double>(r.wakeIdle) / idleSec);
+    }
+}
+
+BENCH_CASE(MainLoopWakeup) {
+    {
+        DeckStateStore store;
+        const auto r = Run(store, [] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+        Print("poll Sleep(10)", r);
+    }
+    {
+        ChangeSignal sig;
+        DeckStateStore store;
+        store.setNotifier(&sig);
+        const auto r = Run(store, [&] { sig.waitFor(); });
+        Print("ChangeSignal", r);
+    }
+}
@@ -0,0 +1,307 @@
+#include "Bench.hpp"
+#include "Core/Audio/AudioWorker.hpp"
+#include "Core/Audio/MockAudioBackend.hpp"
+#include "Core/Audio/VolumeCurve.hpp"
+#include "utils/MappingExecutor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Throughput del mapping slider -> volume (MappingExecutor::applyChanges) sul
+// backend audio mock: quanti stati pubblicati al secondo regge il main loop con
+// chiamate audio gratuite (costo del solo mapping) e con una latenza per chiamata
+// simile a quella di WASAPI, con exe da 0 a 4 sessioni. Verifica che due run
+// sulla stessa traccia producano lo stesso giornale di chiamate e lo stesso stato.
+// AudioWorkerCoalescing: una raffica di stati dal fader con chiamate lente,
+// chiamate sincrone dal main loop contro AudioWorker (coda fusa per target).
+// AudioRateLimit: sweep di 500 ms con il main loop a 1 kHz, AudioWorker senza
+// limite contro 60 Hz per target: scritture eseguite e tempo perché il valore
+// finale arrivi da solo (scrittura trattenuta alla scadenza).
+// VolumeCurveLookup: conteggi -> volume con la curva calcolata a ogni campione
+// (calibrazione + audio taper) contro la tabella compilata al caricamento.
+// MultiExeTargets: uno slider su 4 exe con 40 sessioni scorse a chiamata
+// (WASAPI senza notifiche), un setAppVolume per exe contro setAppsVolume.
+
+namespace {
+
+    // slider k: master, un exe, due exe (uno senza sessioni), un exe con più sessioni, non mappato
+    DeckMapping MakeMapping() {
+        DeckMapping m;
+        for (size_t k = 0; k < DeckState::kSliders; ++k) {
+            switch (k % 5) {
+            case 0: m.sliderMap[k] = SliderTarget{ true, {} }; break;
+            case 1: m.sliderMap[k] = SliderTarget{ false, AppTargetSet({ "spotify.exe" }) }; break;
+            case 2: m.sliderMap[k] = SliderTarget{ false, AppTargetSet({ "chrome.exe", "firefox.exe" }) }; break;
+            case 3: m.sliderMap[k] = SliderTarget{ false, AppTargetSet({ "discord.exe" }) }; break;
+            default: break;
+            }
+        }
+        ButtonAction mute;
+        mute.kind = BtnActKind::ToggleMuteApp;
+        mute.payload = "spotify.exe";
+        m.buttonActions[0].push_back(mute);
+        return m;
+    }
+
+    MockAudioConfig MakeAudio(std::chrono::nanoseconds latency, bool record) {
+        MockAudioConfig cfg;
+        cfg.callLatency = latency;
+        cfg.defaultSessions = 0;
+        cfg.sessions = { {"spotify.exe", 1}, {"chrome.exe", 4}, {"discord.exe", 2} };
+        cfg.recordCalls = record;
+        return cfg;
+    }
+
+    // Stati come li pubblica la catena di filtri: ogni slider si muove a passi
+    // di ~1% con un proprio periodo, quindi 1-2 slider cambiati per stato.
+    std::vector<DeckState> MakeTrace(size_t n) {
+        std::vector<DeckState> out(n);
+        DeckState s{};
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t k = 0; k < DeckState::kSliders; ++k) {
+                const size_t period = k + 2;
+                if (i % period != 0) continue;
+                const int phase = static_cast<int>((i / period) % 170);   // 0..169: su e giù per la corsa
+                s.sliders[k] = (phase < 85 ? phase : 170 - phase) * 12;
+            }
+            out[i] = s;
+        }
+        return out;
+    }
+
+    struct MappingRun {
+        double ns = 0;
+        MockAudioStats stats;
+        std::vector<MockAudioCall> calls;
+        bool spotifyMuted = false;
+    };
+
+    MappingRun Run(const std::vector<DeckState>& trace, std::chrono::nanoseconds latency, bool record) {
+        MockAudioBackend audio(MakeAudio(latency, record));
+        const DeckMapping mapping = MakeMapping();
+        MappingExecutor mapper;
+        DeckState prev = trace.front();
+        MappingExecutor::preapply(mapping, audio, prev);
+
+        Bench::Timer t;
+        for (size_t i = 1; i < trace.size(); ++i) {
+            if (i % 500 == 0 && DeckState::kButtons > 0)   // azioni in linea: giornale deterministico
+                for (const auto& act : mapping.buttonActions[0]) MappingExecutor::runAction(act, audio);
+            mapper.applyChanges(mapping, audio, trace[i], prev);
+        }
+        MappingRun r;
+        r.ns = t.elapsedNs();
+        r.stats = audio.stats();
+        r.calls = audio.calls();
+        r.spotifyMuted = audio.appMute("spotify.exe");
+        return r;
+    }
+}
+
+BENCH_CASE(MappingThroughput) {
+    const auto trace = MakeTrace(20000);
+    const uint64_t states = trace.size() - 1;
+
+    const MappingRun free = Run(trace, std::chrono::nanoseconds(0), false);
+    Bench::Report("mapping, audio senza latenza", free.ns, states);
+    fmt::print("  chiamate backend/stato: {:.2f}, chiamate di sistema/stato: {:.2f}, exe senza sessioni: {}\n",
+        (double)free.stats.calls / states, (double)free.stats.systemCalls / states, free.stats.misses);
+
+    // Con latenza le chiamate dominano: traccia più corta
+    const std::vector<DeckState> shortTrace(trace.begin(), trace.begin() + 2001);
+    for (int us : { 5, 20, 50 }) {
+        const MappingRun slow = Run(shortTrace, std::chrono::microseconds(us), false);
+        Bench::Report(fmt::format("mapping, {} us per chiamata", us), slow.ns, shortTrace.size() - 1);
+    }
+
+    const MappingRun a = Run(trace, std::chrono::nanoseconds(0), true);
+    const MappingRun b = Run(trace, std::chrono::nanoseconds(0), true);
+    fmt::print("  giornale: {} scritture, spotify muto: {}\n", a.calls.size(), a.spotifyMuted ? "si" : "no");
+    if (a.calls != b.calls || a.spotifyMuted != b.spotifyMuted)
+        fmt::print("  ATTENZIONE: due run sulla stessa traccia danno chiamate diverse\n");
+}
+
+BENCH_CASE(AudioWorkerCoalescing) {
+    // 200 stati in raffica (~200 ms di fader a 1 kHz), 20 us per chiamata di sistema
+    const auto trace = MakeTrace(201);
+    const auto latency = std::chrono::microseconds(20);
+    const DeckMapping mapping = MakeMapping();
+
+    // prima: chiamate sincrone sul main loop
+    MockAudioBackend direct(MakeAudio(latency, false));
+    {
+        MappingExecutor mapper;
+        DeckState prev = trace.front();
+        Bench::Timer t;
+        for (size_t i = 1; i < trace.size(); ++i) mapper.applyChanges(mapping, direct, trace[i], prev);
+        Bench::Report("main loop, audio sincrono", t.elapsedNs(), trace.size() - 1);
+    }
+
+    // dopo: il main loop accoda, il worker esegue l'ultima scrittura per target
+    auto owned = std::make_unique<MockAudioBackend>(MakeAudio(latency, false));
+    MockAudioBackend* mock = owned.get();
+    AudioWorker worker(std::move(owned));
+    std::string err;
+    if (!worker.init(err)) { fmt::print("  worker non avviato ({})\n", err); return; }
+    {
+        MappingExecutor mapper;
+        DeckState prev = trace.front();
+        Bench::Timer t;
+        for (size_t i = 1; i < trace.size(); ++i) mapper.applyChanges(mapping, worker, trace[i], prev);
+        const double enqueueNs = t.elapsedNs();
+        float v = 0.f;
+        worker.getMasterVolume(v);   // barriera: eseguito dopo tutte le scritture accodate
+        Bench::Report("main loop, AudioWorker (accodamento)", enqueueNs, trace.size() - 1);
+        Bench::Report("raffica applicata dal worker", t.elapsedNs(), trace.size() - 1);
+    }
+
+    const auto ds = direct.stats();
+    const auto ms = mock->stats();
+    const auto ws = worker.stats();
+    fmt::print("  chiamate di sistema: {} sincrone -> {} dal worker ({} scritture, {} fuse, {} eseguite)\n",
+        ds.systemCalls, ms.systemCalls - 1, ws.submitted, ws.coalesced, ws.applied);
+    const auto q = worker.queueToAudio().snapshot();
+    fmt::print("  ultima scrittura -> applicata: p50={:.1f} us  p99={:.1f} us\n", q.p50Ns / 1000.0, q.p99Ns / 1000.0);
+
+    // stesso stato finale
+    bool same = true;
+    for (const char* exe : { "spotify.exe", "chrome.exe", "discord.exe" }) {
+        float a = 0.f, b = 0.f;
+        direct.getAppVolume(exe, a);
+        worker.getAppVolume(exe, b);
+        same &= (a == b);
+    }
+    float ma = 0.f, mb = 0.f;
+    direct.getMasterVolume(ma);
+    worker.getMasterVolume(mb);
+    if (!same || ma != mb) fmt::print("  ATTENZIONE: stato finale diverso tra sincrono e worker\n");
+    worker.shutdown();
+}
+
+BENCH_CASE(AudioRateLimit) {
+    using Clock = std::chrono::steady_clock;
+    const auto trace = MakeTrace(501);
+    const DeckMapping mapping = MakeMapping();
+
+    // riferimento: stato finale con tutte le scritture, in linea
+    MockAudioBackend direct(MakeAudio(std::chrono::nanoseconds(0), false));
+    {
+        MappingExecutor mapper;
+        DeckState prev = trace.front();
+        for (size_t i = 1; i < trace.size(); ++i) mapper.applyChanges(mapping, direct, trace[i], prev);
+    }
+    float wantMaster = 0.f;
+    direct.getMasterVolume(wantMaster);
+
+    for (double hz : { 0.0, 60.0 }) {
+        auto owned = std::make_unique<MockAudioBackend>(MakeAudio(std::chrono::nanoseconds(0), true));
+        MockAudioBackend* mock = owned.get();
+        AudioWorker worker(std::move(owned));
+        std::string err;
+        if (!worker.init(err)) { fmt::print("  worker non avviato ({})\n", err); return; }
+        worker.setMaxRate(hz);
+
+        MappingExecutor mapper;
+        DeckState prev = trace.front();
+        const auto t0 = Clock::now();
+        for (size_t i = 1; i < trace.size(); ++i) {
+            mapper.applyChanges(mapping, worker, trace[i], prev);
+            std::this_thread::sleep_until(t0 + std::chrono::milliseconds(i));
+        }
+        const auto last = Clock::now();
+
+        // il valore finale del master deve arrivare senza altre scritture né letture dal worker
+        float got = -1.f;
+        while (mock->getMasterVolume(got), got != wantMaster && Clock::now() - last < std::chrono::seconds(1))
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        const double settleMs = std::chrono::duration<double, std::milli>(Clock::now() - last).count();
+        const size_t writes = mock->calls().size();
+        const auto ws = worker.stats();
+
+        bool same = got == wantMaster;
+        for (const char* exe : { "spotify.exe", "chrome.exe", "discord.exe" }) {
+            float a = 0.f, b = 0.f;
+            direct.getAppVolume(exe, a);
+            worker.getAppVolume(exe, b);
+            same &= (a == b);
+        }
+        fmt::print("  {:>4}: {} scritture eseguite ({} trattenute superate, {} finali), valore finale dopo {:.1f} ms\n",
+            hz > 0 ? fmt::format("{:.0f} Hz", hz) : std::string("off"), writes, ws.throttled, ws.trailing, settleMs);
+        if (!same) fmt::print("  ATTENZIONE: stato finale diverso dal riferimento\n");
+        worker.shutdown();
+    }
+}
+
+BENCH_CASE(VolumeCurveLookup) {
+    VolumeCurveConfig c;
+    c.kind = VolumeCurveKind::AudioTaper;
+    c.minCounts = 12;
+    c.maxCounts = 1010;
+    const VolumeLut lut(c);
+
+    const auto trace = MakeTrace(1 << 16);
+    const uint64_t n = trace.size() * DeckState::kSliders;
+
+    // prima: la curva calcolata nel main loop
+    float sumMath = 0.f;
+    Bench::Timer t0;
+    for (const auto& s : trace)
+        for (int v : s.sliders) {
+            const float x = std::clamp(static_cast<float>(v - c.minCounts) / (c.maxCounts - c.minCounts), 0.f, 1.f);
+            sumMath += std::clamp((std::pow(81.f, x) - 1.f) / 80.f, 0.f, 1.f);
+        }
+    const double nsMath = t0.elapsedNs();
+    Bench::DoNotOptimize(sumMath);
+
+    // dopo: un accesso alla tabella
+    float sumLut = 0.f;
+    Bench::Timer t1;
+    for (const auto& s : trace)
+        for (int v : s.sliders) sumLut += lut[v];
+    const double nsLut = t1.elapsedNs();
+    Bench::DoNotOptimize(sumLut);
+
+    Bench::Report("curva calcolata per campione", nsMath, n);
+    Bench::Report("VolumeLut", nsLut, n);
+    if (std::abs(sumMath - sumLut) > 1e-3f * std::max(1.f, sumMath))
+        fmt::print("  ATTENZIONE: tabella e calcolo danno volumi diversi ({} vs {})\n", sumMath, sumLut);
+}
+
+BENCH_CASE(MultiExeTargets) {
+    const AppTargetSet apps({ "applemusic.exe", "amplibraryagent.exe", "chrome.exe", "missing.exe" });
+    const auto trace = MakeTrace(2001);
+
+    MockAudioConfig cfg;
+    cfg.callLatency = std::chrono::nanoseconds(200);
+    cfg.defaultSessions = 0;
+    cfg.sessions = { {"applemusic.exe", 1}, {"amplibraryagent.exe", 1}, {"chrome.exe", 4} };
+    cfg.scannedSessions = 40;
+    cfg.recordCalls = true;
+
+    // prima: un'enumerazione delle sessioni per exe
+    MockAudioBackend perExe(cfg);
+    Bench::Timer t0;
+    for (size_t i = 1; i < trace.size(); ++i)
+        perExe.AudioBackend::setAppsVolume(apps, trace[i].sliders[0] / 1023.0f);   // implementazione base: setAppVolume per exe
+    const double nsPerExe = t0.elapsedNs();
+
+    // dopo: una passata per l'insieme
+    MockAudioBackend onePass(cfg);
+    Bench::Timer t1;
+    for (size_t i = 1; i < trace.size(); ++i)
+        onePass.setAppsVolume(apps, trace[i].sliders[0] / 1023.0f);
+    const double nsOnePass = t1.elapsedNs();
+
+    const uint64_t n = trace.size() - 1;
+    Bench::Report("setAppVolume per exe", nsPerExe, n);
+    Bench::Report("setAppsVolume", nsOnePass, n);
+    const auto a = perExe.stats(), b = onePass.stats();
+    fmt::print("  chiamate di sistema per movimento: {:.0f} -> {:.0f}\n",
+        double(a.systemCalls) / n, double(b.systemCalls) / n);
+    if (perExe.calls() != onePass.calls()) fmt::print("  ATTENZIONE: giornali diversi tra per-exe e insieme\n");
+}
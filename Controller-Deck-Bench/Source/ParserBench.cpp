@@ -0,0 +1,89 @@
+#include "Bench.hpp"
+#include "Core/MessageParser.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <optional>
+#include <string>
+#include <vector>
+
+// ns/linea di ParseDeckLine (SWAR, senza allocazioni) contro la versione
+// precedente basata su std::vector<std::string> + trim, su tre tipi di input:
+// linee valide, malformate e con spazi/CRLF di padding.
+
+namespace {
+
+    // --- parser precedente, riportato qui solo come riferimento ---
+    std::string LegacyTrim(const std::string& s) {
+        auto b = s.find_first_not_of(" \t\r\n");
+        auto e = s.find_last_not_of(" \t\r\n");
+        if (b == std::string::npos) return {};
+        return s.substr(b, e - b + 1);
+    }
+
+    bool LegacyToInt(const std::string& s, int& out) {
+        auto r = std::from_chars(s.data(), s.data() + s.size(), out);
+        return r.ec == std::errc() && r.ptr == s.data() + s.size();
+    }
+
+    std::optional<DeckState> LegacyParseDeckLine(const std::string& line) {
+        std::vector<std::string> tok;
+        std::string cur;
+        cur.reserve(line.size());
+        for (char c : line) {
+            if (c == '\n' || c == '\r') continue;
+            if (c == '|') { tok.push_back(cur); cur.clear(); }
+            else cur.push_back(c);
+        }
+        if (!cur.empty()) tok.push_back(cur);
+        if (tok.size() != 5 && tok.size() != 6) return std::nullopt;
+
+        DeckState st{};
+        for (int i = 0; i < 5; ++i) {
+            int v = 0;
+            if (!LegacyToInt(LegacyTrim(tok[i]), v)) return std::nullopt;
+            st.sliders[i] = std::clamp(v, 0, 1023);
+        }
+        int mask = 0;
+        if (tok.size() == 6) {
+            if (!LegacyToInt(LegacyTrim(tok[5]), mask)) return std::nullopt;
+            mask = std::clamp(mask, 0, 31);
+        }
+        for (int i = 0; i < 5; ++i) st.buttons[i] = ((mask >> i) & 1) != 0;
+        return st;
+    }
+
+    std::vector<std::string> MakeLines(const char* kind) {
+        std::vector<std::string> v;
+        v.reserve(1024);
+        for (int i = 0; i < 1024; ++i) {
+            const int a = i % 1024, b = (i * 7) % 1024, m = i % 32;
+            if (kind[0] == 'v')      v.push_back(fmt::format("{}|{}|512|{}|0|{}", a, b, 1023 - a, m));
+            else if (kind[0] == 'm') v.push_back(i % 2 ? fmt::format("{}|{}|x12|{}|0|{}", a, b, a, m)
+                                                       : fmt::format("{}|{}|{}", a, b, m));
+            else                     v.push_back(fmt::format(" {} | {}\t| 512 | {} |0 | {} \r\n", a, b, 1023 - a, m));
+        }
+        return v;
+    }
+
+    template <class Parse>
+    void Run(const char* label, const std::vector<std::string>& lines, Parse&& parse) {
+        constexpr int kRounds = 2000;
+        uint64_t ok = 0;
+        Bench::Timer t;
+        for (int r = 0; r < kRounds; ++r)
+            for (const auto& l : lines)
+                if (auto st = parse(l)) ok += static_cast<uint64_t>(st->sliders[0]);
+        const double ns = t.elapsedNs();
+        Bench::DoNotOptimize(ok);
+        Bench::Report(label, ns, static_cast<uint64_t>(kRounds) * lines.size());
+    }
+}
+
+BENCH_CASE(ParseDeckLine) {
+    for (const char* kind : { "valid", "malformed", "padded" }) {
+        const auto lines = MakeLines(kind);
+        Run(fmt::format("{} / legacy", kind).c_str(), lines, [](const std::string& l) { return LegacyParseDeckLine(l); });
+        Run(fmt::format("{} / SWAR", kind).c_str(), lines, [](const std::string& l) { return ParseDeckLine(l); });
+    }
+}
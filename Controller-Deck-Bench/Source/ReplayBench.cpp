@@ -0,0 +1,119 @@
+#include "Bench.hpp"
+#include "Core/DeckFrame.hpp"
+#include "Core/MessageParser.hpp"
+#include "Core/Serial/SerialCapture.hpp"
+#include "Core/Serial/SerialController.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+// Frame/s della pipeline completa su una cattura seriale (SerialCapture), come
+// la vedrebbe l'app: parser -> filtri -> debounce -> store -> coda dei fronti,
+// con SerialController::replay senza attese. Per confronto, il solo parsing
+// degli stessi frame. Con CONTROLLER_DECK_CAPTURE=<file> usa una cattura reale
+// (es. registrata con /serial/capture/start), altrimenti ne genera una sintetica:
+// 60 s di protocollo testuale a 1 kHz, 1-3 linee per read, fader lenti con
+// rumore di lettura e un tap ogni 2 s. Verifica che due replay diano la stessa
+// sequenza di stati pubblicati.
+
+namespace {
+
+    std::string MakeSyntheticCapture() {
+        const auto path = (std::filesystem::temp_directory_path() / "controller-deck-bench.cdcap").string();
+        SerialCaptureWriter w;
+        std::string err;
+        if (!w.open(path, err, true)) return {};
+
+        w.recordOpen(static_cast<uint8_t>(DeckProtocol::Auto));
+        const auto base = SerialCaptureWriter::Clock::now();
+        uint32_t rng = 12345;
+        std::string line;
+        for (int i = 0; i < 60000;) {
+            w.recordRead(base + std::chrono::milliseconds(i));
+            const int n = 1 + i % 3;
+            for (int k = 0; k < n; ++k, ++i) {
+                line.clear();
+                for (size_t s = 0; s < DeckState::kSliders; ++s) {
+                    rng = rng * 1664525u + 1013904223u;
+                    const int ramp = static_cast<int>((i / 20 + static_cast<int>(s) * 200) % 1024);
+                    const int noise = static_cast<int>(rng >> 30) - 2;   // -2..1 conteggi
+                    line += std::to_string(std::max(0, std::min(1023, ramp + noise)));
+                    line += '|';
+                }
+                line += (i % 2000) < 40 ? "1" : "0";
+                w.recordFrame(line);
+            }
+        }
+        w.close();
+        return path;
+    }
+
+    struct ReplayRun {
+        ReplayStats stats;
+        uint64_t updates = 0;
+        uint64_t fingerprint = 1469598103934665603ull;
+    };
+
+    ReplayRun Replay(SerialCaptureReader& cap) {
+        asio::io_context io;   // mai avviato: il replay non apre porte
+        DeckStateStore store;
+        ButtonEdgeQueue edges;
+        SerialController ctl(io, "bench", 0, store);
+        ctl.setDebounce(std::chrono::milliseconds(5));
+        ctl.setEdgeQueue(&edges);
+
+        ReplayRun run;
+        ctl.setOnUpdate([&](const DeckState& s) {
+            ++run.updates;
+            for (int v : s.sliders) run.fingerprint = (run.fingerprint ^ static_cast<uint64_t>(v)) * 1099511628211ull;
+            run.fingerprint = (run.fingerprint ^ s.buttonsMask()) * 1099511628211ull;
+            edges.drain([](const ButtonEdge&) {});
+            });
+        run.stats = ctl.replay(cap, 0.0);
+        return run;
+    }
+}
+
+BENCH_CASE(ReplayPipeline) {
+    std::string path;
+    if (const char* env = std::getenv("CONTROLLER_DECK_CAPTURE")) path = env;
+    const bool synthetic = path.empty();
+    if (synthetic) path = MakeSyntheticCapture();
+
+    SerialCaptureReader cap;
+    std::string err;
+    if (path.empty() || !cap.open(path, err)) { fmt::print("  cattura non disponibile ({})\n", path.empty() ? "temp" : err); return; }
+
+    // solo parsing degli stessi frame (testo o binario, come li vede il controller)
+    uint64_t frames = 0, ok = 0;
+    CaptureRecord r;
+    Bench::Timer t0;
+    while (cap.next(r)) {
+        if (r.kind != CaptureRecordKind::Frame) continue;
+        ++frames;
+        DeckState st{};
+        uint8_t seq = 0;
+        if (auto p = ParseDeckLine(r.data)) ok += static_cast<uint64_t>(p->sliders[0]);
+        else if (ParseDeckFrame(r.data, st, seq) == DeckFrameStatus::Ok) ok += static_cast<uint64_t>(st.sliders[0]);
+    }
+    const double nsParse = t0.elapsedNs();
+    Bench::DoNotOptimize(ok);
+
+    const ReplayRun a = Replay(cap);
+    const ReplayRun b = Replay(cap);
+
+    fmt::print("  cattura {}: {} frame, {} read, {:.1f} s{}\n", path, a.stats.frames, a.stats.reads,
+        a.stats.capturedSec, synthetic ? " (sintetica)" : "");
+    Bench::Report("solo parser", nsParse, frames);
+    Bench::Report("replay pipeline completa", b.stats.elapsedSec * 1e9, b.stats.frames);
+    fmt::print("  aggiornamenti store: {} ({:.0f}x tempo reale)\n", b.updates,
+        b.stats.elapsedSec > 0 ? b.stats.capturedSec / b.stats.elapsedSec : 0.0);
+    if (a.updates != b.updates || a.fingerprint != b.fingerprint)
+        fmt::print("  ATTENZIONE: due replay danno stati diversi ({} vs {} aggiornamenti)\n", a.updates, b.updates);
+
+    cap.close();
+    if (synthetic) std::filesystem::remove(path);
+}
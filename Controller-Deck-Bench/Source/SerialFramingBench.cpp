@@ -0,0 +1,95 @@
+#include "Bench.hpp"
+#include "Core/Serial/LineFramer.hpp"
+
+#include <asio.hpp>
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <string>
+#include <string_view>
+
+// Confronta il framing "vecchio" (streambuf + istream + getline, una linea per
+// read) con il LineFramer a buffer fisso. Lo stream è sintetico e viene
+// consegnato a blocchi come farebbe async_read_some: si misura il solo costo
+// di framing sul thread di IO, senza la syscall di lettura.
+
+namespace {
+
+    constexpr int    kLines = 2'000'000;
+    constexpr size_t kChunk = 256;   // byte restituiti da una singola read
+
+    std::string MakeStream() {
+        std::string s;
+        s.reserve(static_cast<size_t>(kLines) * 26);
+        for (int i = 0; i < kLines; ++i) {
+            s += fmt::format("{}|{}|{}|{}|{}|{}\r\n",
+                i % 1024, (i * 3) % 1024, 512, 1023 - i % 1024, 7, i % 32);
+        }
+        return s;
+    }
+
+    // Vecchio percorso: async_read_until riempie lo streambuf, poi una
+    // std::string allocata per ogni linea tramite getline.
+    uint64_t FrameWithStreambuf(const std::string& stream, size_t& bytesOut) {
+        asio::streambuf buf;
+        uint64_t frames = 0;
+        bytesOut = 0;
+
+        for (size_t off = 0; off < stream.size(); off += kChunk) {
+            const size_t n = std::min(kChunk, stream.size() - off);
+            auto dst = buf.prepare(n);
+            std::memcpy(dst.data(), stream.data() + off, n);
+            buf.commit(n);
+
+            // async_read_until completa subito finché c'è un '\n' nel buffer
+            for (;;) {
+                const char* b = static_cast<const char*>(buf.data().data());
+                if (!std::memchr(b, '\n', buf.size())) break;
+                std::istream is(&buf);
+                std::string line;
+                std::getline(is, line);
+                bytesOut += line.size();
+                ++frames;
+            }
+        }
+        return frames;
+    }
+
+    // Nuovo percorso: lettura diretta nel buffer del framer, tutte le linee
+    // complete di una read emesse come string_view.
+    uint64_t FrameWithLineFramer(const std::string& stream, size_t& bytesOut) {
+        LineFramer framer;
+        uint64_t frames = 0;
+        bytesOut = 0;
+
+        size_t off = 0;
+        while (off < stream.size()) {
+            const size_t n = std::min({ kChunk, stream.size() - off, framer.writeSpace() });
+            std::memcpy(framer.writePtr(), stream.data() + off, n);
+            off += n;
+            frames += framer.commit(n, [&](std::string_view line) { bytesOut += line.size(); });
+        }
+        return frames;
+    }
+}
+
+BENCH_CASE(SerialFraming) {
+    const std::string stream = MakeStream();
+
+    size_t bytesOld = 0, bytesNew = 0;
+
+    Bench::Timer t0;
+    const uint64_t framesOld = FrameWithStreambuf(stream, bytesOld);
+    const double nsOld = t0.elapsedNs();
+
+    Bench::Timer t1;
+    const uint64_t framesNew = FrameWithLineFramer(stream, bytesNew);
+    const double nsNew = t1.elapsedNs();
+
+    Bench::DoNotOptimize(bytesOld);
+    Bench::DoNotOptimize(bytesNew);
+
+    Bench::Report("streambuf + getline (prima)", nsOld, framesOld);
+    Bench::Report("LineFramer string_view (dopo)", nsNew, framesNew);
+    if (framesOld != framesNew) fmt::print("  ATTENZIONE: frame diversi ({} vs {})\n", framesOld, framesNew);
+}
@@ -0,0 +1,314 @@
+#include "Bench.hpp"
+#include "Core/Serial/InputSmoother.hpp"
+#include "Core/Serial/FaderFilterChain.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+// ns/campione dello smoothing EMA dei fader: loop float canale per canale (prima)
+// contro il kernel batch in virgola fissa SmoothChannels (dopo), per 5, 16 e 64
+// canali. Prima dei tempi confronta i due su tutte le coppie (ultimo filtrato,
+// campione) in 0..1023, per alpha da 0.05 a 1 e deadband 0/2: quante danno
+// un'uscita diversa e di quanto al massimo.
+
+namespace {
+
+    // --- versione float precedente, riportata qui solo come riferimento ---
+    struct LegacyChannel {
+        int   lastFiltered = 0;
+        bool  hasLast = false;
+        int   deadband = 2;
+        float alpha = 0.20f;
+    };
+
+    void LegacySmooth(int* samples, LegacyChannel* ch, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            const int raw = samples[i];
+            auto& c = ch[i];
+            if (!c.hasLast) {
+                c.lastFiltered = raw;
+                c.hasLast = true;
+                samples[i] = raw;
+                continue;
+            }
+            const int delta = raw - c.lastFiltered;
+            const int ad = delta >= 0 ? delta : -delta;
+            const int step = (ad <= c.deadband) ? 0 : delta;
+            const int target = c.lastFiltered + step;
+
+            const float lf = static_cast<float>(c.lastFiltered);
+            const float tg = static_cast<float>(target);
+            const float nf = lf + c.alpha * (tg - lf);
+
+            c.lastFiltered = static_cast<int>(nf + (nf >= 0 ? 0.5f : -0.5f));
+            samples[i] = c.lastFiltered;
+        }
+    }
+
+    struct Mismatch {
+        uint64_t pairs = 0, diff = 0;
+        int maxAbs = 0;
+    };
+
+    // Confronto esaustivo su un passo di filtro
+    void CountMismatches(float alpha, int deadband, Mismatch& m) {
+        const int alphaQ15 = AlphaToQ15(alpha);
+        for (int last = 0; last <= 1023; ++last) {
+            for (int raw = 0; raw <= 1023; ++raw) {
+                LegacyChannel c{ last, true, deadband, alpha };
+                int legacy = raw;
+                LegacySmooth(&legacy, &c, 1);
+
+                int fixed = raw, lf = last, primed = -1;
+                SmoothChannels(&fixed, &lf, &primed, &deadband, &alphaQ15, 1);
+                ++m.pairs;
+                if (fixed != legacy) {
+                    ++m.diff;
+                    m.maxAbs = std::max(m.maxAbs, std::abs(fixed - legacy));
+                }
+            }
+        }
+    }
+
+    // Campioni sintetici: rampa lenta + rumore, come un fader mosso a mano
+    std::vector<int> MakeSamples(size_t channels, size_t frames) {
+        std::vector<int> v(channels * frames);
+        uint32_t rng = 12345;
+        for (size_t f = 0; f < frames; ++f) {
+            for (size_t c = 0; c < channels; ++c) {
+                rng = rng * 1664525u + 1013904223u;
+                const int noise = static_cast<int>((rng >> 24) % 7) - 3;
+                const int base = static_cast<int>((f * 3 + c * 97) % 1024);
+                v[f * channels + c] = std::clamp(base + noise, 0, 1023);
+            }
+        }
+        return v;
+    }
+}
+
+BENCH_CASE(SmootherKernel) {
+    Mismatch m;
+    for (int a = 1; a <= 20; ++a)
+        for (int deadband : { 0, 2 }) CountMismatches(static_cast<float>(a) * 0.05f, deadband, m);
+    fmt::print("  confronto col float, alpha 0.05..1.00, deadband 0/2: {} coppie diverse su {} ({:.3f}%), al massimo di {} conteggi\n",
+        m.diff, m.pairs, 100.0 * static_cast<double>(m.diff) / static_cast<double>(m.pairs), m.maxAbs);
+
+    constexpr size_t kFrames = 4096;
+    constexpr int kRounds = 200;
+    for (size_t channels : { size_t{ 5 }, size_t{ 16 }, size_t{ 64 } }) {
+        const auto input = MakeSamples(channels, kFrames);
+        std::vector<int> buf(input.size());
+        const uint64_t samples = static_cast<uint64_t>(kRounds) * input.size();
+
+        {
+            std::vector<LegacyChannel> ch(channels);
+            double ns = 0;
+            for (int r = 0; r < kRounds; ++r) {
+                buf = input;   // la copia resta fuori dal tempo misurato
+                Bench::Timer t;
+                for (size_t f = 0; f < kFrames; ++f) LegacySmooth(&buf[f * channels], ch.data(), channels);
+                ns += t.elapsedNs();
+            }
+            Bench::DoNotOptimize(buf);
+            Bench::Report(fmt::format("{} canali / float per canale", channels), ns, samples);
+        }
+        {
+            std::vector<int> last(channels, 0), primed(channels, 0), deadband(channels, 2);
+            std::vector<int> alpha(channels, AlphaToQ15(0.20f));
+            double ns = 0;
+            for (int r = 0; r < kRounds; ++r) {
+                buf = input;
+                Bench::Timer t;
+                for (size_t f = 0; f < kFrames; ++f)
+                    SmoothChannels(&buf[f * channels], last.data(), primed.data(), deadband.data(), alpha.data(), channels);
+                ns += t.elapsedNs();
+            }
+            Bench::DoNotOptimize(buf);
+            Bench::Report(fmt::format("{} canali / batch Q15", channels), ns, samples);
+        }
+    }
+}
+
+// Lag e jitter dei due modi (EMA vs One-Euro) su tracce di un fader a 1 kHz:
+// rumore di lettura gaussiano (sigma ~1.4 conteggi, picchi di ±4-5), fermo,
+// movimento lento e lanci rapidi.
+namespace {
+
+    struct Trace {
+        std::vector<int> truth, raw;
+        std::vector<std::pair<size_t, size_t>> rest;   // [inizio, fine) a fader fermo
+        std::vector<size_t> throwEnds;                 // campione di fine di ogni lancio
+        size_t slowBegin = 0, slowEnd = 0;
+    };
+
+    Trace MakeTrace() {
+        Trace t;
+        auto hold = [&](int v, size_t ms) {
+            t.rest.push_back({ t.truth.size() + 300, t.truth.size() + ms });   // 300 ms di assestamento
+            t.truth.insert(t.truth.end(), ms, v);
+        };
+        auto move = [&](int from, int to, size_t ms) {
+            for (size_t i = 1; i <= ms; ++i)
+                t.truth.push_back(from + static_cast<int>((to - from) * static_cast<int64_t>(i) / static_cast<int64_t>(ms)));
+        };
+
+        hold(300, 1000);
+        t.slowBegin = t.truth.size();
+        move(300, 400, 2000);                  // 50 conteggi/s
+        t.slowEnd = t.truth.size();
+        hold(400, 1000);
+        move(400, 1000, 60);  t.throwEnds.push_back(t.truth.size());
+        hold(1000, 1000);
+        move(1000, 50, 60);   t.throwEnds.push_back(t.truth.size());
+        hold(50, 1000);
+
+        uint32_t rng = 777;
+        for (int v : t.truth) {
+            // somma di 4 uniformi ~ gaussiana
+            int noise = 0;
+            for (int k = 0; k < 4; ++k) {
+                rng = rng * 1664525u + 1013904223u;
+                noise += static_cast<int>((rng >> 16) % 5) - 2;
+            }
+            t.raw.push_back(std::clamp(v + (noise + (noise > 0) - (noise < 0)) / 2, 0, 1023));
+        }
+        return t;
+    }
+
+    void ReportMode(const char* label, const Trace& tr, FaderSmoothingParams p) {
+        InputSmoother sm;
+        sm.setParamsAll(p);
+        std::vector<int> out(tr.raw.size());
+        for (size_t i = 0; i < tr.raw.size(); ++i) {
+            DeckState s{};
+            s.sliders.fill(tr.raw[i]);
+            sm.apply(s, 0.001f);
+            out[i] = s.sliders[0];
+        }
+
+        // jitter a riposo: cambi d'uscita al secondo e ampiezza picco-picco
+        size_t changes = 0, restMs = 0;
+        int pp = 0;
+        for (auto [b, e] : tr.rest) {
+            int lo = out[b], hi = out[b];
+            for (size_t i = b + 1; i < e; ++i) {
+                if (out[i] != out[i - 1]) ++changes;
+                lo = std::min(lo, out[i]);
+                hi = std::max(hi, out[i]);
+            }
+            pp = std::max(pp, hi - lo);
+            restMs += e - b;
+        }
+
+        // movimento lento: ritardo medio (conteggi dietro al vero) e inversioni di direzione
+        double behind = 0;
+        size_t reversals = 0;
+        int lastDir = 0;
+        for (size_t i = tr.slowBegin; i < tr.slowEnd; ++i) {
+            behind += tr.truth[i] - out[i];
+            const int d = out[i] - out[i - 1];
+            if (d != 0) {
+                const int dir = d > 0 ? 1 : -1;
+                if (lastDir != 0 && dir != lastDir) ++reversals;
+                lastDir = dir;
+            }
+        }
+        const double slowLagMs = behind / static_cast<double>(tr.slowEnd - tr.slowBegin) / 50.0 * 1000.0;
+
+        // lanci: ms dopo la fine del lancio per arrivare entro 3 conteggi dal target
+        size_t worstSettle = 0;
+        for (size_t e : tr.throwEnds) {
+            const int target = tr.truth[e];
+            size_t i = e;
+            while (i < out.size() && std::abs(out[i] - target) > 3) ++i;
+            worstSettle = std::max(worstSettle, i - e);
+        }
+
+        fmt::print("  {:<22} riposo: {:>6.1f} cambi/s  p-p {:>2}  |  lento: lag {:>5.1f} ms, {:>3} inversioni  |  lancio: {:>3} ms\n",
+            label, static_cast<double>(changes) * 1000.0 / static_cast<double>(restMs), pp,
+            slowLagMs, reversals, worstSettle);
+    }
+}
+
+BENCH_CASE(SmootherModes) {
+    const Trace tr = MakeTrace();
+
+    FaderSmoothingParams ema{};
+    ReportMode("EMA (db 2, a 0.20)", tr, ema);
+
+    FaderSmoothingParams euro{};
+    euro.mode = SmoothingMode::OneEuro;
+    ReportMode("One-Euro (default)", tr, euro);
+
+    // Replay: due smoother nuovi (fader misti EMA/One-Euro, ognuno con la traccia
+    // sfasata) sulla stessa sequenza devono dare la stessa uscita, campione per campione
+    auto replay = [&] {
+        InputSmoother sm;
+        for (size_t k = 0; k < InputSmoother::kChannels; ++k) sm.setParams(static_cast<int>(k), (k % 2) ? euro : ema);
+        std::vector<int> out;
+        out.reserve(tr.raw.size() * InputSmoother::kChannels);
+        for (size_t i = 0; i < tr.raw.size(); ++i) {
+            DeckState s{};
+            for (size_t k = 0; k < InputSmoother::kChannels; ++k) s.sliders[k] = tr.raw[(i + k * 997) % tr.raw.size()];
+            sm.apply(s, 0.001f);
+            out.insert(out.end(), s.sliders.begin(), s.sliders.end());
+        }
+        return out;
+        };
+    fmt::print("  replay della stessa traccia: {}\n", replay() == replay() ? "uscita identica" : "USCITA DIVERSA");
+}
+
+// Catene di filtri sulla stessa traccia: per stadio campioni entrati, uscite
+// cambiate e cambi soppressi. L'"out" dell'ultimo stadio sono le chiamate di
+// volume che arriverebbero all'audio; ns/campione dell'intera catena (5 fader).
+namespace {
+
+    void ReportChain(const char* label, const Trace& tr, const FilterChainConfig& cfg) {
+        FaderFilterChain chain;
+        chain.configure(cfg);
+        double ns = 0;
+        {
+            Bench::Timer t;
+            for (int v : tr.raw) {
+                DeckState s{};
+                s.sliders.fill(v);
+                chain.apply(s, 0.001f);
+                Bench::DoNotOptimize(s);
+            }
+            ns = t.elapsedNs();
+        }
+        fmt::print("  {:<38} {:>6.1f} ns/campione\n", label, ns / static_cast<double>(tr.raw.size()));
+        for (const auto& st : chain.stats())
+            fmt::print("      {:<10} in {:>6}  out {:>6}  soppressi {:>6}\n", FilterStageName(st.kind), st.in[0], st.out[0], st.suppressed[0]);
+    }
+
+    FilterStageConfig MinDelta(int counts) {
+        FilterStageConfig st{ FilterStageKind::MinDelta, {} };
+        st.counts.fill(counts);
+        return st;
+    }
+}
+
+BENCH_CASE(FilterChainStages) {
+    const Trace tr = MakeTrace();
+    const FilterStageConfig smooth{ FilterStageKind::Smooth, {} };
+
+    FilterChainConfig ema{};
+    ReportChain("smooth EMA -> min_delta 10 (default)", tr, ema);
+
+    FilterChainConfig euro{};
+    for (auto& p : euro.smoothing) p.mode = SmoothingMode::OneEuro;
+    ReportChain("smooth One-Euro -> min_delta 10", tr, euro);
+
+    euro.stages = { smooth };
+    ReportChain("smooth One-Euro", tr, euro);
+
+    FilterChainConfig pre{};
+    pre.stages = { MinDelta(3), smooth };
+    ReportChain("min_delta 3 -> smooth EMA", tr, pre);
+
+    FilterChainConfig raw{};
+    raw.stages.clear();
+    ReportChain("nessun filtro", tr, raw);
+}
@@ -0,0 +1,19 @@
+#include "Bench.hpp"
+#include <cstring>
+
+// Uso: Controller-Deck-Bench [filtro]
+// Senza argomenti esegue tutti i benchmark registrati.
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    int run = 0;
+    for (const auto& c : Bench::Registry()) {
+        if (filter && !std::strstr(c.name, filter)) continue;
+        fmt::print("[{}]\n", c.name);
+        c.fn();
+        ++run;
+    }
+
+    if (run == 0) fmt::print("Nessun benchmark corrisponde a '{}'.\n", filter ? filter : "");
+    return 0;
+}
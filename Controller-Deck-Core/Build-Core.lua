@@ -36,6 +36,17 @@ project "Controller-Deck-Core"
         links { "setupapi", "ws2_32", "mswsock", "advapi32" }
     filter{}
 
+   -- Linux (bench/emulatore): pipeline seriale e backend audio mock, il resto è WASAPI/Win32
+   filter "system:not windows"
+       defines { "ASIO_STANDALONE" }
+       removefiles {
+           "Source/Core/Audio/Audio*Controller.cpp",
+           "Source/Core/Audio/WasapiAudioBackend.cpp",
+           "Source/Core/Actions/**.cpp",
+           "Source/Core/Serial/SerialPortEnumerator.cpp"
+       }
+   filter{}
+
    filter "configurations:Debug"
        defines { "DEBUG" }
        runtime "Debug"
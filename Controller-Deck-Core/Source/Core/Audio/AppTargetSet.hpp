@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Insieme di exe controllati da uno slider ("AppleMusic.exe" + "AMPLibraryAgent.exe"),
+// precalcolato al caricamento della config: elenco in ordine, hash set per il
+// confronto con l'exe di ogni sessione e una chiave che identifica l'insieme.
+// Immutabile; copiarlo costa un contatore di riferimenti (viaggia nella coda di AudioWorker).
+class AppTargetSet {
+public:
+    AppTargetSet() = default;
+
+    // exe in minuscolo; i duplicati vengono ignorati
+    explicit AppTargetSet(const std::vector<std::string>& exesLower) {
+        auto d = std::make_shared<Data>();
+        for (const auto& e : exesLower) {
+            if (!d->lookup.insert(e).second) continue;
+            d->exes.push_back(e);
+            if (!d->key.empty()) d->key += '\n';
+            d->key += e;
+        }
+        m_data = std::move(d);
+    }
+
+    const std::vector<std::string>& exes() const { return m_data ? m_data->exes : Empty().exes; }
+    const std::unordered_set<std::string>& lookup() const { return m_data ? m_data->lookup : Empty().lookup; }
+    const std::string& key() const { return m_data ? m_data->key : Empty().key; }   // exe uniti da '\n'
+    size_t size() const { return m_data ? m_data->exes.size() : 0; }
+    bool empty() const { return size() == 0; }
+
+private:
+    struct Data {
+        std::vector<std::string> exes;
+        std::unordered_set<std::string> lookup;
+        std::string key;
+    };
+    static const Data& Empty() { static const Data d; return d; }
+
+    std::shared_ptr<const Data> m_data;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include "Core/Audio/AppTargetSet.hpp"
+#include <string>
+
+// Interfaccia verso il sistema audio usata da mapping e azioni dei bottoni:
+// volume e mute del master (endpoint di default), per app (tutte le sessioni
+// dell'exe) e di un endpoint scelto per id. Volumi in 0.0..1.0 (clamp incluso).
+//
+// Implementazioni:
+// - WasapiAudioBackend: Windows (AudioController + AudioSessionController + AudioEndpointController)
+// - MockAudioBackend:   in memoria, portabile, con latenza e numero di sessioni configurabili (bench/test)
+//
+// Le chiamate arrivano dal main loop e dal thread REST: le implementazioni sono thread-safe.
+class AudioBackend {
+public:
+    virtual ~AudioBackend() = default;
+
+    // false + err ("master_init_failed", "session_init_failed") se il backend non è usabile
+    virtual bool init(std::string& err) = 0;
+    virtual void shutdown() = 0;
+
+    // ---- master ----
+    virtual bool setMasterVolume(float v01) = 0;
+    virtual bool getMasterVolume(float& out01) = 0;
+    virtual bool setMasterMute(bool mute) = 0;
+    virtual bool toggleMasterMute() = 0;
+
+    // ---- per app (exe in minuscolo, es. "spotify.exe"); false se l'exe non ha sessioni ----
+    virtual bool setAppVolume(const std::string& exeLower, float v01) = 0;
+    virtual bool getAppVolume(const std::string& exeLower, float& out01) = 0;
+    virtual bool setAppMute(const std::string& exeLower, bool mute) = 0;
+    virtual bool toggleAppMute(const std::string& exeLower) = 0;
+
+    // Stesso volume a tutte le sessioni degli exe dell'insieme (slider con più exe).
+    // true se almeno un exe ha sessioni. Default: setAppVolume per exe; i backend
+    // reali lo fanno con un solo passaggio sulle sessioni.
+    virtual bool setAppsVolume(const AppTargetSet& apps, float v01) {
+        bool any = false;
+        for (const auto& exe : apps.exes()) any |= setAppVolume(exe, v01);
+        return any;
+    }
+
+    // ---- endpoint selezionato per id (UTF-8, come in /audio/devices) ----
+    // err: "bad_device_id", "device_not_found", "endpoint_volume_unavailable", "no_active_endpoint", ...
+    virtual bool selectEndpoint(const std::string& idUtf8, std::string& err) = 0;
+    virtual bool setEndpointVolume(float v01, std::string& err) = 0;
+    virtual bool getEndpointVolume(float& out01, std::string& err) = 0;
+    virtual bool setEndpointMute(bool mute, std::string& err) = 0;
+};
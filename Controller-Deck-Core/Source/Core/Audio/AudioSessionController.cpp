@@ -7,6 +7,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 
 static std::string toLower(std::string s) {
@@ -14,6 +15,136 @@ static std::string toLower(std::string s) {
     return s;
 }
 
+namespace {
+    // Sessioni nuove, notificate da un thread del servizio audio: qui solo AddRef e
+    // accodamento. Le chiamate COM (QueryInterface, OpenProcess, registrazione eventi)
+    // le fa il prossimo chiamante di AudioSessionController, sotto il suo lock.
+    class SessionNotifier final : public IAudioSessionNotification {
+    public:
+        ULONG STDMETHODCALLTYPE AddRef() override { return ++m_ref; }
+        ULONG STDMETHODCALLTYPE Release() override {
+            const ULONG r = --m_ref;
+            if (r == 0) delete this;
+            return r;
+        }
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppv) override {
+            if (!ppv) return E_POINTER;
+            if (riid == __uuidof(IUnknown) || riid == __uuidof(IAudioSessionNotification)) {
+                *ppv = static_cast<IAudioSessionNotification*>(this);
+                AddRef();
+                return S_OK;
+            }
+            *ppv = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        HRESULT STDMETHODCALLTYPE OnSessionCreated(IAudioSessionControl* session) override {
+            if (!session) return S_OK;
+            session->AddRef();
+            {
+                std::lock_guard<std::mutex> lock(m_mtx);
+                m_pending.push_back(session);
+            }
+            markDirty();
+            return S_OK;
+        }
+
+        void markDirty() { m_dirty.store(true, std::memory_order_release); }
+        bool takeDirty() { return m_dirty.exchange(false, std::memory_order_acq_rel); }
+
+        // Le sessioni accodate, con il loro riferimento
+        std::vector<IAudioSessionControl*> takePending() {
+            std::vector<IAudioSessionControl*> out;
+            std::lock_guard<std::mutex> lock(m_mtx);
+            out.swap(m_pending);
+            return out;
+        }
+
+    private:
+        ~SessionNotifier() { for (auto* s : m_pending) s->Release(); }
+
+        std::atomic<ULONG> m_ref{ 1 };
+        std::atomic<bool> m_dirty{ false };
+        std::mutex m_mtx;
+        std::vector<IAudioSessionControl*> m_pending;
+    };
+
+    // Eventi di una sessione in cache: scaduta (processo chiuso) o disconnessa
+    // (endpoint rimosso, formato cambiato, ...) esce dalla cache al prossimo accesso.
+    // Non si può deregistrare dal callback: qui solo un flag.
+    class SessionEvents final : public IAudioSessionEvents {
+    public:
+        explicit SessionEvents(SessionNotifier* n) : m_notifier(n) { m_notifier->AddRef(); }
+
+        ULONG STDMETHODCALLTYPE AddRef() override { return ++m_ref; }
+        ULONG STDMETHODCALLTYPE Release() override {
+            const ULONG r = --m_ref;
+            if (r == 0) delete this;
+            return r;
+        }
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppv) override {
+            if (!ppv) return E_POINTER;
+            if (riid == __uuidof(IUnknown) || riid == __uuidof(IAudioSessionEvents)) {
+                *ppv = static_cast<IAudioSessionEvents*>(this);
+                AddRef();
+                return S_OK;
+            }
+            *ppv = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        HRESULT STDMETHODCALLTYPE OnDisplayNameChanged(LPCWSTR, LPCGUID) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE OnIconPathChanged(LPCWSTR, LPCGUID) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE OnSimpleVolumeChanged(float, BOOL, LPCGUID) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE OnChannelVolumeChanged(DWORD, float[], DWORD, LPCGUID) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE OnGroupingParamChanged(LPCGUID, LPCGUID) override { return S_OK; }
+        HRESULT STDMETHODCALLTYPE OnStateChanged(AudioSessionState state) override {
+            if (state == AudioSessionStateExpired) expire();
+            return S_OK;
+        }
+        HRESULT STDMETHODCALLTYPE OnSessionDisconnected(AudioSessionDisconnectReason) override {
+            expire();
+            return S_OK;
+        }
+
+        bool expired() const { return m_expired.load(std::memory_order_acquire); }
+
+    private:
+        ~SessionEvents() { m_notifier->Release(); }
+
+        void expire() {
+            m_expired.store(true, std::memory_order_release);
+            m_notifier->markDirty();
+        }
+
+        std::atomic<ULONG> m_ref{ 1 };
+        std::atomic<bool> m_expired{ false };
+        SessionNotifier* m_notifier;   // riferimento tenuto: il flag "sporco" sopravvive al controller
+    };
+}
+
+struct AudioSessionController::Session {
+    IAudioSessionControl* ctrl = nullptr;
+    ISimpleAudioVolume* vol = nullptr;
+    SessionEvents* events = nullptr;   // null senza notifiche: la cache si ricostruisce a ogni chiamata
+    std::wstring instanceId;
+    std::string exeLower;
+
+    ~Session() {
+        if (events) { ctrl->UnregisterAudioSessionNotification(events); events->Release(); }
+        if (vol) vol->Release();
+        if (ctrl) ctrl->Release();
+    }
+
+    bool expired() const { return events && events->expired(); }
+};
+
+AudioSessionController::AudioSessionController() = default;
+
+AudioSessionController::~AudioSessionController() {
+    shutdown();
+}
+
 std::string AudioSessionController::basenameLower(const std::string& fullPath) {
     std::string s = toLower(fullPath);
     size_t p1 = s.find_last_of("\\/");
@@ -42,93 +173,171 @@ bool AudioSessionController::init() {
     m_enumerator = enumr;
     m_device = dev;
     m_sessionMgr2 = mgr2;
+
+    // Notifiche prima dell'enumerazione (che le attiva): una sessione nata nel mezzo
+    // arriva da entrambe le parti e la seconda viene scartata come doppione.
+    // Senza notifiche si resta corretti, ma con un'enumerazione per chiamata.
+    auto* notifier = new SessionNotifier();
+    if (SUCCEEDED(mgr2->RegisterSessionNotification(notifier))) m_notifier = notifier;
+    else notifier->Release();
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    rebuild();
     return true;
 }
 
 void AudioSessionController::shutdown() {
+    if (m_notifier) {
+        auto* n = (SessionNotifier*)m_notifier;
+        ((IAudioSessionManager2*)m_sessionMgr2)->UnregisterSessionNotification(n);
+        n->Release();
+        m_notifier = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        clearSessions();
+    }
     if (m_sessionMgr2) { ((IAudioSessionManager2*)m_sessionMgr2)->Release(); m_sessionMgr2 = nullptr; }
     if (m_device) { ((IMMDevice*)m_device)->Release(); m_device = nullptr; }
     if (m_enumerator) { ((IMMDeviceEnumerator*)m_enumerator)->Release(); m_enumerator = nullptr; }
     if (m_comInit) { CoUninitialize(); m_comInit = false; }
 }
 
-
-bool AudioSessionController::matchProcessName(unsigned pid, const std::string& wantedExeLower, std::string& outExeLower) {
-    std::string exeLower;
-    if (!ProcUtils::PidToExeLower((DWORD)pid, exeLower)) return false;
-    outExeLower = exeLower;
-    return exeLower == wantedExeLower;
+void AudioSessionController::clearSessions() {
+    m_byExe.clear();
+    m_sessions.clear();
 }
 
-bool AudioSessionController::withSessions(
-    const std::function<bool(void*, void*, unsigned, const std::string&)>& fn) {
-    if (!m_sessionMgr2) return false;
+void AudioSessionController::rebuild() {
+    clearSessions();
 
     IAudioSessionEnumerator* enumr = nullptr;
     HRESULT hr = ((IAudioSessionManager2*)m_sessionMgr2)->GetSessionEnumerator(&enumr);
-    if (FAILED(hr) || !enumr) return false;
+    if (FAILED(hr) || !enumr) return;
 
     int count = 0;
     enumr->GetCount(&count);
-    bool any = false;
-
     for (int i = 0; i < count; ++i) {
         IAudioSessionControl* ctrl = nullptr;
         if (FAILED(enumr->GetSession(i, &ctrl)) || !ctrl) continue;
+        addSession(ctrl);
+    }
+    enumr->Release();
+}
 
-        IAudioSessionControl2* ctrl2 = nullptr;
-        if (FAILED(ctrl->QueryInterface(__uuidof(IAudioSessionControl2), (void**)&ctrl2)) || !ctrl2) {
-            ctrl->Release(); continue;
-        }
+// Prende il riferimento di ctrl: o finisce in cache o viene rilasciato
+void AudioSessionController::addSession(void* p) {
+    auto* ctrl = (IAudioSessionControl*)p;
 
-        ISimpleAudioVolume* vol = nullptr;
-        if (FAILED(ctrl->QueryInterface(__uuidof(ISimpleAudioVolume), (void**)&vol)) || !vol) {
-            ctrl2->Release(); ctrl->Release(); continue;
-        }
+    IAudioSessionControl2* ctrl2 = nullptr;
+    if (FAILED(ctrl->QueryInterface(__uuidof(IAudioSessionControl2), (void**)&ctrl2)) || !ctrl2) {
+        ctrl->Release(); return;
+    }
 
-        DWORD pid = 0;
-        if (SUCCEEDED(ctrl2->GetProcessId(&pid))) {
-            std::string exeLower;
-            // Passiamo i pointer come void* (non **)
-            any |= fn((void*)ctrl2, (void*)vol, (unsigned)pid, exeLower);
-        }
+    // Exe risolto una volta per sessione. PID 0 (suoni di sistema) o processo non
+    // leggibile: come con l'enumerazione, non corrisponde a nessun target.
+    DWORD pid = 0;
+    std::string exeLower;
+    LPWSTR inst = nullptr;
+    const bool known = SUCCEEDED(ctrl2->GetProcessId(&pid)) && ProcUtils::PidToExeLower(pid, exeLower)
+        && SUCCEEDED(ctrl2->GetSessionInstanceIdentifier(&inst)) && inst;
+    std::wstring instanceId = inst ? inst : L"";
+    if (inst) CoTaskMemFree(inst);
+    ctrl2->Release();
+    if (!known) { ctrl->Release(); return; }
 
-        vol->Release();
-        ctrl2->Release();
-        ctrl->Release();
+    auto it = m_byExe.find(exeLower);
+    if (it != m_byExe.end()) {
+        for (const auto* s : it->second)
+            if (s->instanceId == instanceId) { ctrl->Release(); return; }
     }
 
-    enumr->Release();
+    ISimpleAudioVolume* vol = nullptr;
+    if (FAILED(ctrl->QueryInterface(__uuidof(ISimpleAudioVolume), (void**)&vol)) || !vol) {
+        ctrl->Release(); return;
+    }
+
+    auto s = std::make_unique<Session>();
+    s->ctrl = ctrl;
+    s->vol = vol;
+    s->instanceId = std::move(instanceId);
+    s->exeLower = std::move(exeLower);
+
+    if (m_notifier) {
+        auto* ev = new SessionEvents((SessionNotifier*)m_notifier);
+        if (SUCCEEDED(ctrl->RegisterAudioSessionNotification(ev))) s->events = ev;
+        else ev->Release();
+    }
+    // stato letto dopo la registrazione: una scadenza nel mezzo non va persa
+    AudioSessionState state = AudioSessionStateInactive;
+    if (SUCCEEDED(ctrl->GetState(&state)) && state == AudioSessionStateExpired) return;   // ~Session rilascia
+
+    m_byExe[s->exeLower].push_back(s.get());
+    m_sessions.push_back(std::move(s));
+}
+
+void AudioSessionController::sync() {
+    auto* n = (SessionNotifier*)m_notifier;
+    if (!n) { rebuild(); return; }
+    if (!n->takeDirty()) return;   // caso comune: una load atomica
+
+    for (auto* ctrl : n->takePending()) addSession(ctrl);
+
+    for (auto it = m_sessions.begin(); it != m_sessions.end();) {
+        if (!(*it)->expired()) { ++it; continue; }
+        auto e = m_byExe.find((*it)->exeLower);
+        if (e != m_byExe.end()) {
+            auto& v = e->second;
+            v.erase(std::remove(v.begin(), v.end(), it->get()), v.end());
+            if (v.empty()) m_byExe.erase(e);
+        }
+        it = m_sessions.erase(it);
+    }
+}
+
+const std::vector<AudioSessionController::Session*>& AudioSessionController::sessionsOf(const std::string& exeLower) {
+    static const std::vector<Session*> kNone;
+    sync();
+    auto it = m_byExe.find(exeLower);
+    return it != m_byExe.end() ? it->second : kNone;
+}
+
+bool AudioSessionController::forEachVolume(const std::string& processExeLower, const std::function<bool(void*)>& fn) {
+    if (!m_sessionMgr2) return false;
+    const std::string wanted = toLower(processExeLower);
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    bool any = false;
+    for (auto* s : sessionsOf(wanted)) any |= fn(s->vol);
     return any;
 }
 
 
 bool AudioSessionController::setAppVolume(const std::string& processExeLower, float v01) {
-    if (!m_sessionMgr2) return false;
-    std::string wanted = toLower(processExeLower);
     if (v01 < 0.f) v01 = 0.f; if (v01 > 1.f) v01 = 1.f;
-
-    bool applied = false;
-    withSessions([&](void* pCtrl2, void* pVol, unsigned pid, const std::string&) {
-        std::string exeLower;
-        if (!ProcUtils::PidToExeLower(pid, exeLower)) return false;
-        if (exeLower != wanted) return false;
-        auto* vol = (ISimpleAudioVolume*)pVol;
-        if (SUCCEEDED(vol->SetMasterVolume(v01, nullptr))) applied = true;
-        return applied;
+    return forEachVolume(processExeLower, [&](void* pVol) {
+        return SUCCEEDED(((ISimpleAudioVolume*)pVol)->SetMasterVolume(v01, nullptr));
         });
-    return applied;
+}
+
+bool AudioSessionController::setAppsVolume(const std::unordered_set<std::string>& exesLower, float v01) {
+    if (!m_sessionMgr2 || exesLower.empty()) return false;
+    if (v01 < 0.f) v01 = 0.f; if (v01 > 1.f) v01 = 1.f;
+
+    std::lock_guard<std::mutex> lock(m_mtx);
+    sync();
+    bool any = false;
+    for (const auto& s : m_sessions) {
+        if (!exesLower.count(s->exeLower)) continue;
+        any |= SUCCEEDED(s->vol->SetMasterVolume(v01, nullptr));
+    }
+    return any;
 }
 
 bool AudioSessionController::getAppVolume(const std::string& processExeLower, float& out01) {
-    if (!m_sessionMgr2) return false;
-    std::string wanted = toLower(processExeLower);
     bool got = false;
-
-    withSessions([&](void* pCtrl2, void* pVol, unsigned pid, const std::string&) {
-        std::string exeLower;
-        if (!ProcUtils::PidToExeLower(pid, exeLower)) return false;
-        if (exeLower != wanted) return false;
+    forEachVolume(processExeLower, [&](void* pVol) {
+        if (got) return true;   // vale la prima sessione che risponde
         float v = 0.f;
         if (SUCCEEDED(((ISimpleAudioVolume*)pVol)->GetMasterVolume(&v))) {
             out01 = v; got = true;
@@ -139,34 +348,16 @@ bool AudioSessionController::getAppVolume(const std::string& processExeLower, fl
 }
 
 bool AudioSessionController::setAppMute(const std::string& processExeLower, bool mute) {
-    if (!m_sessionMgr2) return false;
-    std::string wanted = toLower(processExeLower);
-    bool applied = false;
-
-    withSessions([&](void* pCtrl2, void* pVol, unsigned pid, const std::string&) {
-        std::string exeLower;
-        if (!ProcUtils::PidToExeLower(pid, exeLower)) return false;
-        if (exeLower != wanted) return false;
-        if (SUCCEEDED(((ISimpleAudioVolume*)pVol)->SetMute(mute, nullptr))) applied = true;
-        return applied;
+    return forEachVolume(processExeLower, [&](void* pVol) {
+        return SUCCEEDED(((ISimpleAudioVolume*)pVol)->SetMute(mute, nullptr));
         });
-    return applied;
 }
 
 bool AudioSessionController::toggleAppMute(const std::string& processExeLower) {
-    if (!m_sessionMgr2) return false;
-    std::string wanted = toLower(processExeLower);
-    bool toggled = false;
-
-    withSessions([&](void* pCtrl2, void* pVol, unsigned pid, const std::string&) {
-        std::string exeLower;
-        if (!ProcUtils::PidToExeLower(pid, exeLower)) return false;
-        if (exeLower != wanted) return false;
+    return forEachVolume(processExeLower, [&](void* pVol) {
         BOOL isMuted = FALSE;
         auto* vol = (ISimpleAudioVolume*)pVol;
         if (FAILED(vol->GetMute(&isMuted))) return false;
-        if (SUCCEEDED(vol->SetMute(!isMuted, nullptr))) toggled = true;
-        return toggled;
+        return SUCCEEDED(vol->SetMute(!isMuted, nullptr));
         });
-    return toggled;
 }
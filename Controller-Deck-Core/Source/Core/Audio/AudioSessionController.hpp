@@ -3,14 +3,31 @@
 #include <vector>
 #include <functional>
 #include <cctype>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 
 // Controller per il volume per-app tramite Audio Sessions (WASAPI).
 // Identifichiamo le sessioni per nome eseguibile (es. "spotify.exe").
 // Nota: i processi possono avere più sessioni (tab di browser, ecc.): applichiamo a tutte.
+//
+// Le sessioni stanno in una cache exe -> ISimpleAudioVolume, costruita una volta
+// all'init e tenuta allineata dalle notifiche WASAPI (IAudioSessionNotification per
+// le nuove, IAudioSessionEvents per scadute/disconnesse). Un exe assente dalla cache
+// non ha sessioni: nessuna enumerazione né OpenProcess per chiamata, un movimento
+// di fader costa una chiamata COM per sessione dell'exe.
+// Thread-safe: main loop e thread REST (preapply) possono chiamare in parallelo.
 
 class AudioSessionController {
 public:
-    bool init();               // COM + endpoint + IAudioSessionManager2
+    AudioSessionController();
+    ~AudioSessionController();   // shutdown()
+
+    AudioSessionController(const AudioSessionController&) = delete;
+    AudioSessionController& operator=(const AudioSessionController&) = delete;
+
+    bool init();               // COM + endpoint + IAudioSessionManager2 + notifiche sessioni
     void shutdown();
 
     // Volume [0..1] applicato a TUTTE le sessioni del processo indicato
@@ -19,6 +36,11 @@ public:
     // Legge il volume dalla prima sessione trovata (se ce n’è almeno una)
     bool getAppVolume(const std::string& processExeLower, float& out01);
 
+    // Volume a tutte le sessioni degli exe dell'insieme (già in minuscolo), con un
+    // solo passaggio sulle sessioni: costo proporzionale alle sessioni, non sessioni × exe
+    // (e senza notifiche una sola enumerazione per slider invece di una per exe)
+    bool setAppsVolume(const std::unordered_set<std::string>& exesLower, float v01);
+
     bool setAppMute(const std::string& processExeLower, bool mute);
     bool toggleAppMute(const std::string& processExeLower);
 
@@ -26,11 +48,25 @@ public:
     static std::string basenameLower(const std::string& fullPath);
 
 private:
-    bool withSessions(const std::function<bool(void* /*IAudioSessionControl2*/, void* /*ISimpleAudioVolume*/, unsigned /*pid*/, const std::string& /*exeLower*/)>& fn);
-    bool matchProcessName(unsigned pid, const std::string& wantedExeLower, std::string& outExeLower);
+    struct Session;    // sessione in cache: ISimpleAudioVolume + eventi registrati (nel .cpp)
+
+    // Sessioni dell'exe (vuoto se non ne ha). Da chiamare con m_mtx preso.
+    const std::vector<Session*>& sessionsOf(const std::string& exeLower);
+    void rebuild();            // enumerazione completa (init, o a ogni chiamata se le notifiche mancano)
+    void sync();               // aggiunge le sessioni notificate, toglie le scadute
+    void addSession(void* /*IAudioSessionControl*/ ctrl);
+    void clearSessions();
+
+    // fn(ISimpleAudioVolume*) su ogni sessione dell'exe; true se almeno una chiamata riesce
+    bool forEachVolume(const std::string& processExeLower, const std::function<bool(void* /*ISimpleAudioVolume*/)>& fn);
 
     void* m_enumerator = nullptr;       // IMMDeviceEnumerator*
     void* m_device = nullptr;           // IMMDevice*
     void* m_sessionMgr2 = nullptr;      // IAudioSessionManager2*
+    void* m_notifier = nullptr;         // IAudioSessionNotification* (null = notifiche non disponibili)
     bool  m_comInit = false;
+
+    std::mutex m_mtx;
+    std::vector<std::unique_ptr<Session>> m_sessions;
+    std::unordered_map<std::string, std::vector<Session*>> m_byExe;
 };
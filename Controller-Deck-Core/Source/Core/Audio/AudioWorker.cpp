@@ -0,0 +1,262 @@
+#include "Core/Audio/AudioWorker.hpp"
+#include <algorithm>
+
+AudioWorker::AudioWorker(std::unique_ptr<AudioBackend> backend) : m_backend(std::move(backend)) {}
+
+AudioWorker::~AudioWorker() {
+    shutdown();
+}
+
+bool AudioWorker::init(std::string& err) {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if (m_running) { err = "already_started"; return false; }
+        if (!m_backend) { err = "no_backend"; return false; }   // già chiuso da shutdown()
+        m_running = true;
+        m_stop = false;
+    }
+    m_thread = std::thread([this] { loop(); });
+
+    bool ok = false;
+    run([&](AudioBackend& b) { ok = b.init(err); });
+    if (!ok) shutdown();
+    return ok;
+}
+
+void AudioWorker::shutdown() {
+    if (!m_thread.joinable()) return;
+    // ultimo comando: le scritture accodate prima vengono eseguite
+    run([this](AudioBackend& b) {
+        b.shutdown();
+        m_backend.reset();   // distrutto sul thread che lo ha creato
+        });
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_running = false;
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+}
+
+// ---- coda ----
+namespace {
+    std::string Key(uint8_t op, const std::string& target) {
+        std::string k;
+        k.reserve(target.size() + 1);
+        k += static_cast<char>(op);
+        k += target;
+        return k;
+    }
+}
+
+bool AudioWorker::post(Op op, const std::string& target, float value, const AppTargetSet& apps) {
+    const auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if (!m_running) return false;
+        m_submitted.fetch_add(1, std::memory_order_relaxed);
+
+        auto key = Key(static_cast<uint8_t>(op), target);
+        auto it = m_pending.find(key);
+        if (it != m_pending.end()) {
+            auto& c = m_queue[static_cast<size_t>(it->second - m_head)];
+            c.value = value;
+            c.at = now;
+            m_coalesced.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+        m_pending.emplace(std::move(key), m_head + m_queue.size());
+        m_queue.push_back(Command{ op, target, value, now, {}, nullptr, apps });
+        if (m_queue.size() > m_queuePeak.load(std::memory_order_relaxed)) m_queuePeak.store(m_queue.size(), std::memory_order_relaxed);
+    }
+    m_cv.notify_one();
+    return true;
+}
+
+bool AudioWorker::toggle(Op op, Op sealed, const std::string& target) {
+    const auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if (!m_running) return false;
+        m_submitted.fetch_add(1, std::memory_order_relaxed);
+        m_pending.erase(Key(static_cast<uint8_t>(sealed), target));
+        m_queue.push_back(Command{ op, target, 0.f, now, {}, nullptr, {} });
+        if (m_queue.size() > m_queuePeak.load(std::memory_order_relaxed)) m_queuePeak.store(m_queue.size(), std::memory_order_relaxed);
+    }
+    m_cv.notify_one();
+    return true;
+}
+
+bool AudioWorker::run(const std::function<void(AudioBackend&)>& fn) {
+    if (std::this_thread::get_id() == m_thread.get_id()) {   // già sul worker
+        if (m_backend) fn(*m_backend);
+        return m_backend != nullptr;
+    }
+    std::promise<void> done;
+    auto finished = done.get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        if (!m_running) return false;
+        Command c;
+        c.call = fn;
+        c.done = &done;
+        m_queue.push_back(std::move(c));
+    }
+    m_cv.notify_one();
+    finished.wait();
+    return true;
+}
+
+void AudioWorker::loop() {
+    using Clock = std::chrono::steady_clock;
+    std::deque<Command> batch;
+    for (;;) {
+        // prossima scadenza tra le scritture trattenute (al più una per target)
+        auto due = Clock::time_point::max();
+        for (const auto& [key, h] : m_held) due = std::min(due, h.due);
+        {
+            std::unique_lock<std::mutex> lock(m_mtx);
+            auto ready = [&] { return !m_queue.empty() || m_stop; };
+            if (due == Clock::time_point::max()) m_cv.wait(lock, ready);
+            else m_cv.wait_until(lock, due, ready);
+            if (m_queue.empty() && m_stop) return;
+            // da qui le nuove scritture aprono comandi nuovi: quelli presi sono in esecuzione
+            batch.swap(m_queue);
+            m_head += batch.size();
+            m_pending.clear();
+        }
+        for (auto& c : batch) execute(c);
+        batch.clear();
+        releaseHeld(false);
+    }
+}
+
+void AudioWorker::execute(Command& c) {
+    if (c.op == Op::Call) {
+        releaseHeld(true);   // letture e comandi REST vedono tutte le scritture precedenti
+        apply(c);
+        return;
+    }
+
+    const int64_t minNs = m_minIntervalNs.load(std::memory_order_relaxed);
+    if ((c.op != Op::MasterVolume && c.op != Op::AppVolume && c.op != Op::AppsVolume) || minNs <= 0) { apply(c); return; }
+
+    const auto now = std::chrono::steady_clock::now();
+    const auto interval = std::chrono::nanoseconds(minNs);
+    auto key = Key(static_cast<uint8_t>(c.op), c.target);
+    auto last = m_lastApplied.find(key);
+    if (last != m_lastApplied.end() && now - last->second < interval) {
+        // troppo presto: trattenuta fino a 1/hz dopo l'ultima eseguita; una già trattenuta è superata
+        const auto due = last->second + interval;
+        auto [it, fresh] = m_held.try_emplace(std::move(key));
+        if (!fresh) m_throttled.fetch_add(1, std::memory_order_relaxed);
+        it->second.cmd = std::move(c);
+        it->second.due = due;
+        return;
+    }
+    if (m_held.erase(key)) m_throttled.fetch_add(1, std::memory_order_relaxed);
+    apply(c);
+    m_lastApplied[std::move(key)] = now;
+}
+
+void AudioWorker::releaseHeld(bool all) {
+    if (m_held.empty()) return;
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = m_held.begin(); it != m_held.end();) {
+        if (!all && it->second.due > now) { ++it; continue; }
+        apply(it->second.cmd);
+        m_lastApplied[it->first] = now;
+        m_trailing.fetch_add(1, std::memory_order_relaxed);
+        it = m_held.erase(it);
+    }
+}
+
+void AudioWorker::apply(Command& c) {
+    if (c.op == Op::Call) {
+        if (m_backend) c.call(*m_backend);
+        c.done->set_value();
+        return;
+    }
+    if (!m_backend) return;
+
+    bool ok = false;
+    switch (c.op) {
+    case Op::MasterVolume:     ok = m_backend->setMasterVolume(c.value); break;
+    case Op::MasterMute:       ok = m_backend->setMasterMute(c.value != 0.f); break;
+    case Op::AppVolume:        ok = m_backend->setAppVolume(c.target, c.value); break;
+    case Op::AppMute:          ok = m_backend->setAppMute(c.target, c.value != 0.f); break;
+    case Op::ToggleMasterMute: ok = m_backend->toggleMasterMute(); break;
+    case Op::ToggleAppMute:    ok = m_backend->toggleAppMute(c.target); break;
+    case Op::AppsVolume:       ok = m_backend->setAppsVolume(c.apps, c.value); break;
+    case Op::Call:             break;
+    }
+    m_applied.fetch_add(1, std::memory_order_relaxed);
+    if (!ok) m_failed.fetch_add(1, std::memory_order_relaxed);
+    m_queueToAudio.record(std::chrono::steady_clock::now() - c.at);
+}
+
+void AudioWorker::setMaxRate(double hz) {
+    const int64_t ns = hz > 0 ? static_cast<int64_t>(1e9 / hz) : 0;
+    m_minIntervalNs.store(ns, std::memory_order_relaxed);   // le già trattenute tengono la loro scadenza
+}
+
+// ---- master ----
+bool AudioWorker::setMasterVolume(float v01) { return post(Op::MasterVolume, {}, v01); }
+bool AudioWorker::setMasterMute(bool mute) { return post(Op::MasterMute, {}, mute ? 1.f : 0.f); }
+bool AudioWorker::toggleMasterMute() { return toggle(Op::ToggleMasterMute, Op::MasterMute, {}); }
+
+bool AudioWorker::getMasterVolume(float& out01) {
+    bool ok = false;
+    run([&](AudioBackend& b) { ok = b.getMasterVolume(out01); });
+    return ok;
+}
+
+// ---- per app ----
+bool AudioWorker::setAppVolume(const std::string& exeLower, float v01) { return post(Op::AppVolume, exeLower, v01); }
+bool AudioWorker::setAppMute(const std::string& exeLower, bool mute) { return post(Op::AppMute, exeLower, mute ? 1.f : 0.f); }
+bool AudioWorker::toggleAppMute(const std::string& exeLower) { return toggle(Op::ToggleAppMute, Op::AppMute, exeLower); }
+bool AudioWorker::setAppsVolume(const AppTargetSet& apps, float v01) { return post(Op::AppsVolume, apps.key(), v01, apps); }
+
+bool AudioWorker::getAppVolume(const std::string& exeLower, float& out01) {
+    bool ok = false;
+    run([&](AudioBackend& b) { ok = b.getAppVolume(exeLower, out01); });
+    return ok;
+}
+
+// ---- endpoint: dal REST, con esito ----
+bool AudioWorker::selectEndpoint(const std::string& idUtf8, std::string& err) {
+    bool ok = false;
+    if (!run([&](AudioBackend& b) { ok = b.selectEndpoint(idUtf8, err); })) err = "audio_not_running";
+    return ok;
+}
+
+bool AudioWorker::setEndpointVolume(float v01, std::string& err) {
+    bool ok = false;
+    if (!run([&](AudioBackend& b) { ok = b.setEndpointVolume(v01, err); })) err = "audio_not_running";
+    return ok;
+}
+
+bool AudioWorker::getEndpointVolume(float& out01, std::string& err) {
+    bool ok = false;
+    if (!run([&](AudioBackend& b) { ok = b.getEndpointVolume(out01, err); })) err = "audio_not_running";
+    return ok;
+}
+
+bool AudioWorker::setEndpointMute(bool mute, std::string& err) {
+    bool ok = false;
+    if (!run([&](AudioBackend& b) { ok = b.setEndpointMute(mute, err); })) err = "audio_not_running";
+    return ok;
+}
+
+AudioWorkerStats AudioWorker::stats() const {
+    AudioWorkerStats s;
+    s.submitted = m_submitted.load(std::memory_order_relaxed);
+    s.coalesced = m_coalesced.load(std::memory_order_relaxed);
+    s.applied = m_applied.load(std::memory_order_relaxed);
+    s.failed = m_failed.load(std::memory_order_relaxed);
+    s.queuePeak = m_queuePeak.load(std::memory_order_relaxed);
+    s.throttled = m_throttled.load(std::memory_order_relaxed);
+    s.trailing = m_trailing.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include "Core/Audio/AudioBackend.hpp"
+#include "Core/Metrics/LatencyHistogram.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Contatori del worker audio (snapshot)
+struct AudioWorkerStats {
+    uint64_t submitted = 0;   // scritture ricevute (volume/mute/toggle)
+    uint64_t coalesced = 0;   // scritture assorbite da una ancora in coda per lo stesso target
+    uint64_t applied = 0;     // chiamate eseguite sul backend
+    uint64_t failed = 0;      // ... di cui fallite (es. exe senza sessioni)
+    uint64_t queuePeak = 0;   // massimo di comandi in coda
+    uint64_t throttled = 0;   // scritture di volume trattenute dal limite di frequenza e superate da una successiva
+    uint64_t trailing = 0;    // scritture trattenute eseguite alla scadenza (valore finale di una raffica)
+};
+
+// Un solo thread possiede il backend audio (oggetti COM creati, usati e distrutti
+// lì) ed esegue tutte le operazioni di volume e mute, da qualsiasi thread arrivino.
+//
+// - Scritture di volume/mute: accodate senza attesa, true = accettata. Per target
+//   (master, exe, endpoint) e tipo vale l'ultima: una scritta ancora in coda viene
+//   aggiornata sul posto, così una raffica di campioni dal fader diventa una
+//   chiamata per giro del worker e una sessione lenta non ferma il main loop.
+// - Uno slider con più exe è un solo target (AppTargetSet): un comando e una
+//   chiamata al backend per movimento, non uno per exe.
+// - Limite di frequenza per target (setMaxRate): un volume scritto meno di 1/hz dopo
+//   il precedente sullo stesso target viene trattenuto; alla scadenza parte l'ultimo
+//   trattenuto, così il valore a fader fermo arriva sempre, con al più 1/hz di ritardo.
+// - Toggle: in coda in ordine, mai fusi (due toggle si annullano); chiudono la
+//   scrittura di mute in coda per lo stesso target, che non assorbe più le successive.
+// - Letture, selezione endpoint e volume endpoint (errori per il REST): eseguite sul
+//   worker, il chiamante attende l'esito. Vedono le scritture accodate prima di loro
+//   (anche quelle trattenute dal limite di frequenza, eseguite subito prima).
+class AudioWorker final : public AudioBackend {
+public:
+    explicit AudioWorker(std::unique_ptr<AudioBackend> backend);
+    ~AudioWorker() override;   // shutdown()
+
+    AudioWorker(const AudioWorker&) = delete;
+    AudioWorker& operator=(const AudioWorker&) = delete;
+
+    // Avvia il thread e inizializza lì il backend
+    bool init(std::string& err) override;
+    // Esegue le scritture in coda, chiude e distrugge il backend sul worker, ferma il thread
+    void shutdown() override;
+
+    bool setMasterVolume(float v01) override;
+    bool getMasterVolume(float& out01) override;
+    bool setMasterMute(bool mute) override;
+    bool toggleMasterMute() override;
+
+    bool setAppVolume(const std::string& exeLower, float v01) override;
+    bool getAppVolume(const std::string& exeLower, float& out01) override;
+    bool setAppMute(const std::string& exeLower, bool mute) override;
+    bool toggleAppMute(const std::string& exeLower) override;
+    bool setAppsVolume(const AppTargetSet& apps, float v01) override;   // un comando per l'insieme, fuso per insieme
+
+    bool selectEndpoint(const std::string& idUtf8, std::string& err) override;
+    bool setEndpointVolume(float v01, std::string& err) override;
+    bool getEndpointVolume(float& out01, std::string& err) override;
+    bool setEndpointMute(bool mute, std::string& err) override;
+
+    // Massimo di scritture di volume al secondo per target (master, exe). 0 = nessun limite.
+    void setMaxRate(double hz);
+
+    AudioWorkerStats stats() const;
+    // Ultima scrittura accodata -> chiamata completata (lock-free, azzerabile dal REST)
+    LatencyHistogram& queueToAudio() { return m_queueToAudio; }
+
+private:
+    enum class Op : uint8_t { MasterVolume, MasterMute, AppVolume, AppMute, ToggleMasterMute, ToggleAppMute, AppsVolume, Call };
+
+    struct Command {
+        Op op = Op::Call;
+        std::string target;
+        float value = 0.f;
+        std::chrono::steady_clock::time_point at{};
+        std::function<void(AudioBackend&)> call;   // solo Op::Call
+        std::promise<void>* done = nullptr;        // solo Op::Call
+        AppTargetSet apps;                         // solo Op::AppsVolume (target = apps.key())
+    };
+
+    bool post(Op op, const std::string& target, float value, const AppTargetSet& apps = {});   // scrittura, fusa per target
+    bool toggle(Op op, Op sealed, const std::string& target);
+    bool run(const std::function<void(AudioBackend&)>& fn);     // sul worker, attende
+    struct Held {
+        Command cmd;
+        std::chrono::steady_clock::time_point due;
+    };
+
+    void loop();
+    void execute(Command& c);   // limite di frequenza, poi apply()
+    void apply(Command& c);
+    void releaseHeld(bool all); // trattenute scadute (o tutte)
+
+    std::unique_ptr<AudioBackend> m_backend;   // solo dal worker dopo init()
+
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::deque<Command> m_queue;
+    uint64_t m_head = 0;                                // numero progressivo di m_queue.front()
+    std::unordered_map<std::string, uint64_t> m_pending; // target -> progressivo della scrittura in coda
+    bool m_running = false;
+    bool m_stop = false;
+    std::thread m_thread;
+
+    std::atomic<int64_t> m_minIntervalNs{ 0 };   // 1/hz di setMaxRate
+    // solo dal worker: ultima scrittura eseguita e scrittura trattenuta, per target
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_lastApplied;
+    std::unordered_map<std::string, Held> m_held;
+
+    std::atomic<uint64_t> m_submitted{ 0 }, m_coalesced{ 0 }, m_applied{ 0 }, m_failed{ 0 }, m_queuePeak{ 0 };
+    std::atomic<uint64_t> m_throttled{ 0 }, m_trailing{ 0 };
+    LatencyHistogram m_queueToAudio;
+};
@@ -0,0 +1,208 @@
+#include "Core/Audio/MockAudioBackend.hpp"
+#include <algorithm>
+
+namespace {
+    float Clamp01(float v) { return std::min(1.f, std::max(0.f, v)); }
+}
+
+MockAudioBackend::MockAudioBackend(MockAudioConfig cfg) : m_cfg(std::move(cfg)) {}
+
+bool MockAudioBackend::init(std::string&) {
+    return true;
+}
+
+int MockAudioBackend::sessionsOf(const std::string& exeLower) const {
+    auto it = m_cfg.sessions.find(exeLower);
+    return it != m_cfg.sessions.end() ? it->second : m_cfg.defaultSessions;
+}
+
+void MockAudioBackend::spend(int n) const {
+    m_stats.systemCalls += static_cast<uint64_t>(n);
+    if (m_cfg.callLatency.count() <= 0 || n <= 0) return;
+    const auto until = std::chrono::steady_clock::now() + m_cfg.callLatency * n;
+    while (std::chrono::steady_clock::now() < until) {}
+}
+
+void MockAudioBackend::record(MockAudioOp op, const std::string& target, float value) {
+    if (m_cfg.recordCalls) m_calls.push_back(MockAudioCall{ op, target, value });
+}
+
+// ---- master ----
+bool MockAudioBackend::setMasterVolume(float v01) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    spend(1);
+    m_masterVolume = Clamp01(v01);
+    record(MockAudioOp::MasterVolume, {}, m_masterVolume);
+    return true;
+}
+
+bool MockAudioBackend::getMasterVolume(float& out01) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    spend(1);
+    out01 = m_masterVolume;
+    return true;
+}
+
+bool MockAudioBackend::setMasterMute(bool mute) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    spend(1);
+    m_masterMute = mute;
+    record(MockAudioOp::MasterMute, {}, mute ? 1.f : 0.f);
+    return true;
+}
+
+bool MockAudioBackend::toggleMasterMute() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    spend(2);   // lettura + scrittura, come IAudioEndpointVolume
+    m_masterMute = !m_masterMute;
+    record(MockAudioOp::MasterMute, {}, m_masterMute ? 1.f : 0.f);
+    return true;
+}
+
+// ---- per app ----
+bool MockAudioBackend::setAppVolume(const std::string& exeLower, float v01) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    spend(m_cfg.scannedSessions);
+    const int n = sessionsOf(exeLower);
+    if (n <= 0) { ++m_stats.misses; return false; }
+    spend(n);
+    auto& app = m_apps[exeLower];
+    app.volume = Clamp01(v01);
+    record(MockAudioOp::AppVolume, exeLower, app.volume);
+    return true;
+}
+
+bool MockAudioBackend::setAppsVolume(const AppTargetSet& apps, float v01) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    spend(m_cfg.scannedSessions);
+    bool any = false;
+    for (const auto& exe : apps.exes()) {
+        const int n = sessionsOf(exe);
+        if (n <= 0) { ++m_stats.misses; continue; }
+        spend(n);
+        auto& app = m_apps[exe];
+        app.volume = Clamp01(v01);
+        record(MockAudioOp::AppVolume, exe, app.volume);
+        any = true;
+    }
+    return any;
+}
+
+bool MockAudioBackend::getAppVolume(const std::string& exeLower, float& out01) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    spend(m_cfg.scannedSessions);
+    if (sessionsOf(exeLower) <= 0) { ++m_stats.misses; return false; }
+    spend(1);   // prima sessione
+    auto it = m_apps.find(exeLower);
+    out01 = it != m_apps.end() ? it->second.volume : 1.f;
+    return true;
+}
+
+bool MockAudioBackend::setAppMute(const std::string& exeLower, bool mute) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    spend(m_cfg.scannedSessions);
+    const int n = sessionsOf(exeLower);
+    if (n <= 0) { ++m_stats.misses; return false; }
+    spend(n);
+    m_apps[exeLower].mute = mute;
+    record(MockAudioOp::AppMute, exeLower, mute ? 1.f : 0.f);
+    return true;
+}
+
+bool MockAudioBackend::toggleAppMute(const std::string& exeLower) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    spend(m_cfg.scannedSessions);
+    const int n = sessionsOf(exeLower);
+    if (n <= 0) { ++m_stats.misses; return false; }
+    spend(2 * n);   // GetMute + SetMute per sessione
+    auto& app = m_apps[exeLower];
+    app.mute = !app.mute;
+    record(MockAudioOp::AppMute, exeLower, app.mute ? 1.f : 0.f);
+    return true;
+}
+
+// ---- endpoint ----
+bool MockAudioBackend::selectEndpoint(const std::string& idUtf8, std::string& err) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    if (idUtf8.empty()) { err = "bad_device_id"; return false; }
+    if (!m_cfg.endpoints.empty() && std::find(m_cfg.endpoints.begin(), m_cfg.endpoints.end(), idUtf8) == m_cfg.endpoints.end()) {
+        m_endpointId.clear();
+        err = "device_not_found";
+        return false;
+    }
+    spend(1);
+    if (m_endpointId != idUtf8) m_endpoint = AppState{};
+    m_endpointId = idUtf8;
+    return true;
+}
+
+bool MockAudioBackend::setEndpointVolume(float v01, std::string& err) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    if (m_endpointId.empty()) { err = "no_active_endpoint"; return false; }
+    spend(1);
+    m_endpoint.volume = Clamp01(v01);
+    record(MockAudioOp::EndpointVolume, m_endpointId, m_endpoint.volume);
+    return true;
+}
+
+bool MockAudioBackend::getEndpointVolume(float& out01, std::string& err) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    if (m_endpointId.empty()) { err = "no_active_endpoint"; return false; }
+    spend(1);
+    out01 = m_endpoint.volume;
+    return true;
+}
+
+bool MockAudioBackend::setEndpointMute(bool mute, std::string& err) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    ++m_stats.calls;
+    if (m_endpointId.empty()) { err = "no_active_endpoint"; return false; }
+    spend(1);
+    m_endpoint.mute = mute;
+    record(MockAudioOp::EndpointMute, m_endpointId, mute ? 1.f : 0.f);
+    return true;
+}
+
+// ---- ispezione / scenario ----
+void MockAudioBackend::setSessions(const std::string& exeLower, int count) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_cfg.sessions[exeLower] = std::max(count, 0);
+}
+
+bool MockAudioBackend::appMute(const std::string& exeLower) const {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    auto it = m_apps.find(exeLower);
+    return it != m_apps.end() && it->second.mute;
+}
+
+bool MockAudioBackend::masterMute() const {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_masterMute;
+}
+
+MockAudioStats MockAudioBackend::stats() const {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_stats;
+}
+
+std::vector<MockAudioCall> MockAudioBackend::calls() const {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_calls;
+}
+
+void MockAudioBackend::clearCalls() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_calls.clear();
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "Core/Audio/AudioBackend.hpp"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scrittura registrata dal mock, nell'ordine di arrivo
+enum class MockAudioOp : uint8_t { MasterVolume, MasterMute, AppVolume, AppMute, EndpointVolume, EndpointMute };
+
+struct MockAudioCall {
+    MockAudioOp op = MockAudioOp::MasterVolume;
+    std::string target;    // exe o id endpoint; vuoto per il master
+    float value = 0.f;     // volume, o 0/1 per il mute
+
+    bool operator==(const MockAudioCall&) const = default;
+};
+
+struct MockAudioConfig {
+    // Costo di una chiamata al sistema audio, in attesa attiva (precisa e ripetibile,
+    // a differenza di una sleep). Le operazioni per app la pagano una volta per sessione.
+    std::chrono::nanoseconds callLatency{ 0 };
+    int defaultSessions = 1;                 // sessioni di un exe non elencato (0 = nessuna)
+    std::map<std::string, int> sessions;     // exe -> numero di sessioni
+    // Sessioni scorse da ogni operazione per app prima di agire: 0 = cache per exe
+    // (WasapiAudioBackend con notifiche), N = enumerazione di N sessioni a chiamata
+    int scannedSessions = 0;
+    std::vector<std::string> endpoints;      // id accettati da selectEndpoint (vuoto = qualsiasi)
+    bool recordCalls = false;                // tiene il giornale delle scritture (calls())
+};
+
+struct MockAudioStats {
+    uint64_t calls = 0;          // chiamate al backend
+    uint64_t systemCalls = 0;    // chiamate "COM" simulate (una per sessione)
+    uint64_t misses = 0;         // operazioni per app su exe senza sessioni
+};
+
+// Backend audio in memoria: stesso contratto di WasapiAudioBackend, senza sistema
+// audio. Deterministico: stesso ingresso, stesso stato e stesso giornale. Per bench
+// e regressioni del mapping su Linux/CI.
+class MockAudioBackend final : public AudioBackend {
+public:
+    explicit MockAudioBackend(MockAudioConfig cfg = {});
+
+    bool init(std::string& err) override;
+    void shutdown() override {}
+
+    bool setMasterVolume(float v01) override;
+    bool getMasterVolume(float& out01) override;
+    bool setMasterMute(bool mute) override;
+    bool toggleMasterMute() override;
+
+    bool setAppVolume(const std::string& exeLower, float v01) override;
+    bool getAppVolume(const std::string& exeLower, float& out01) override;
+    bool setAppMute(const std::string& exeLower, bool mute) override;
+    bool toggleAppMute(const std::string& exeLower) override;
+    bool setAppsVolume(const AppTargetSet& apps, float v01) override;   // un solo passaggio per l'insieme
+
+    bool selectEndpoint(const std::string& idUtf8, std::string& err) override;
+    bool setEndpointVolume(float v01, std::string& err) override;
+    bool getEndpointVolume(float& out01, std::string& err) override;
+    bool setEndpointMute(bool mute, std::string& err) override;
+
+    // ---- ispezione / scenario ----
+    void setSessions(const std::string& exeLower, int count);   // processo avviato (count > 0) o chiuso (0)
+    bool appMute(const std::string& exeLower) const;
+    bool masterMute() const;
+
+    MockAudioStats stats() const;
+    std::vector<MockAudioCall> calls() const;
+    void clearCalls();
+
+private:
+    struct AppState { float volume = 1.f; bool mute = false; };
+
+    int sessionsOf(const std::string& exeLower) const;   // con m_mtx preso
+    void spend(int n) const;                              // n chiamate di sistema
+    void record(MockAudioOp op, const std::string& target, float value);
+
+    mutable std::mutex m_mtx;
+    MockAudioConfig m_cfg;
+    mutable MockAudioStats m_stats;
+
+    float m_masterVolume = 1.f;
+    bool  m_masterMute = false;
+    std::map<std::string, AppState> m_apps;
+    std::string m_endpointId;    // vuoto = nessuno selezionato
+    AppState m_endpoint;
+
+    std::vector<MockAudioCall> m_calls;
+};
@@ -0,0 +1,50 @@
+#include "Core/Audio/VolumeCurve.hpp"
+#include <algorithm>
+#include <cmath>
+
+const char* VolumeCurveName(VolumeCurveKind k) {
+    switch (k) {
+    case VolumeCurveKind::Db:         return "db";
+    case VolumeCurveKind::AudioTaper: return "audio_taper";
+    case VolumeCurveKind::Points:     return "points";
+    default:                          return "linear";
+    }
+}
+
+namespace {
+    // Posizione 0..1 -> volume 0..1
+    float Shape(const VolumeCurveConfig& c, float x) {
+        switch (c.kind) {
+        case VolumeCurveKind::Db:
+            return x <= 0.f ? 0.f : std::pow(10.f, -c.rangeDb * (1.f - x) / 20.f);
+        case VolumeCurveKind::AudioTaper:
+            // (81^x - 1) / 80: 0 -> 0, 0.5 -> 0.1, 1 -> 1
+            return (std::pow(81.f, x) - 1.f) / 80.f;
+        case VolumeCurveKind::Points: {
+            const auto& p = c.points;
+            if (p.empty()) return x;
+            if (x <= p.front().first) return p.front().second;
+            if (x >= p.back().first) return p.back().second;
+            auto hi = std::upper_bound(p.begin(), p.end(), x, [](float v, const auto& q) { return v < q.first; });
+            auto lo = hi - 1;
+            const float t = (x - lo->first) / (hi->first - lo->first);
+            return lo->second + t * (hi->second - lo->second);
+        }
+        default:
+            return x;
+        }
+    }
+}
+
+VolumeLut::VolumeLut() {
+    for (int i = 0; i < kSize; ++i) m_v[static_cast<size_t>(i)] = i / 1023.0f;
+}
+
+VolumeLut::VolumeLut(const VolumeCurveConfig& c) {
+    const int span = std::max(c.maxCounts - c.minCounts, 1);
+    for (int i = 0; i < kSize; ++i) {
+        float x = std::clamp(static_cast<float>(i - c.minCounts) / span, 0.f, 1.f);
+        if (c.invert) x = 1.f - x;
+        m_v[static_cast<size_t>(i)] = std::clamp(Shape(c, x), 0.f, 1.f);
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Forma della curva conteggi -> volume di uno slider
+enum class VolumeCurveKind : uint8_t {
+    Linear,       // volume = corsa (comportamento storico)
+    Db,           // lineare in dB: da -range_db a 0 dB, muto in fondo alla corsa
+    AudioTaper,   // potenziometro logaritmico "A": 10% del volume a metà corsa
+    Points        // spezzata per punti (corsa, volume), interpolata linearmente
+};
+
+const char* VolumeCurveName(VolumeCurveKind k);
+
+struct VolumeCurveConfig {
+    VolumeCurveKind kind = VolumeCurveKind::Linear;
+    float rangeDb = 60.f;                          // Db: attenuazione a inizio corsa
+    std::vector<std::pair<float, float>> points;   // Points: x strettamente crescenti, x e y in 0..1
+
+    // Calibrazione: conteggi letti a fader tutto giù / tutto su (fuori: saturano)
+    int  minCounts = 0;
+    int  maxCounts = 1023;
+    bool invert = false;                           // fader montato al contrario
+};
+
+// Curva compilata: un volume 0..1 per ogni conteggio. Costruita al caricamento
+// della config; nel main loop la conversione è un solo accesso all'array.
+class VolumeLut {
+public:
+    static constexpr int kSize = 1024;   // conteggi 0..1023, come DeckState::sliders
+
+    VolumeLut();   // lineare
+    explicit VolumeLut(const VolumeCurveConfig& c);
+
+    // counts in 0..1023: parser e filtri non pubblicano altro
+    float operator[](int counts) const { return m_v[static_cast<size_t>(counts)]; }
+
+private:
+    std::array<float, kSize> m_v;
+};
@@ -0,0 +1,65 @@
+#include "Core/Audio/WasapiAudioBackend.hpp"
+#include <fmt/core.h>
+
+namespace {
+    std::string Narrow(const std::wstring& w) {
+        // codici d'errore di AudioEndpointController: solo ASCII
+        return std::string(w.begin(), w.end());
+    }
+}
+
+WasapiAudioBackend::~WasapiAudioBackend() {
+    shutdown();
+}
+
+bool WasapiAudioBackend::init(std::string& err) {
+    if (!m_master.init()) { err = "master_init_failed"; return false; }
+    if (!m_sessions.init()) { err = "session_init_failed"; return false; }
+
+    // endpoint per id: opzionale, senza restano master e sessioni
+    // (selectEndpoint risponde "enumerator_not_initialized")
+    std::lock_guard<std::mutex> lock(m_endpointMtx);
+    if (!m_endpoint.init()) {
+        fmt::print("Audio endpoint controller init fallita.\n");
+    }
+    return true;
+}
+
+void WasapiAudioBackend::shutdown() {
+    m_sessions.shutdown();
+    m_master.shutdown();
+}
+
+bool WasapiAudioBackend::selectEndpoint(const std::string& idUtf8, std::string& err) {
+    // UTF-8 -> UTF-16 (id IMM)
+    int len = MultiByteToWideChar(CP_UTF8, 0, idUtf8.c_str(), -1, nullptr, 0);
+    if (len <= 1) { err = "bad_device_id"; return false; }
+    std::wstring wid(len - 1, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, idUtf8.c_str(), -1, wid.data(), len);
+
+    std::lock_guard<std::mutex> lock(m_endpointMtx);
+    std::wstring werr;
+    if (!m_endpoint.setActiveEndpointById(wid, werr)) { err = Narrow(werr); return false; }
+    return true;
+}
+
+bool WasapiAudioBackend::setEndpointVolume(float v01, std::string& err) {
+    std::lock_guard<std::mutex> lock(m_endpointMtx);
+    std::wstring werr;
+    if (!m_endpoint.setVolumeScalar(v01, werr)) { err = Narrow(werr); return false; }
+    return true;
+}
+
+bool WasapiAudioBackend::getEndpointVolume(float& out01, std::string& err) {
+    std::lock_guard<std::mutex> lock(m_endpointMtx);
+    std::wstring werr;
+    if (!m_endpoint.getVolumeScalar(out01, werr)) { err = Narrow(werr); return false; }
+    return true;
+}
+
+bool WasapiAudioBackend::setEndpointMute(bool mute, std::string& err) {
+    std::lock_guard<std::mutex> lock(m_endpointMtx);
+    std::wstring werr;
+    if (!m_endpoint.setMute(mute, werr)) { err = Narrow(werr); return false; }
+    return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "Core/Audio/AudioBackend.hpp"
+#include "Core/Audio/AudioController.hpp"
+#include "Core/Audio/AudioSessionController.hpp"
+#include "Core/Audio/AudioEndpointController.hpp"
+#include <mutex>
+
+// Backend Windows: master dall'endpoint di default, sessioni per app dalla cache
+// di AudioSessionController, endpoint per id da AudioEndpointController.
+class WasapiAudioBackend final : public AudioBackend {
+public:
+    ~WasapiAudioBackend() override;   // shutdown()
+
+    bool init(std::string& err) override;
+    void shutdown() override;
+
+    bool setMasterVolume(float v01) override { return m_master.setMasterVolume(v01); }
+    bool getMasterVolume(float& out01) override { return m_master.getMasterVolume(out01); }
+    bool setMasterMute(bool mute) override { return m_master.setMasterMute(mute); }
+    bool toggleMasterMute() override { return m_master.toggleMasterMute(); }
+
+    bool setAppVolume(const std::string& exeLower, float v01) override { return m_sessions.setAppVolume(exeLower, v01); }
+    bool getAppVolume(const std::string& exeLower, float& out01) override { return m_sessions.getAppVolume(exeLower, out01); }
+    bool setAppMute(const std::string& exeLower, bool mute) override { return m_sessions.setAppMute(exeLower, mute); }
+    bool toggleAppMute(const std::string& exeLower) override { return m_sessions.toggleAppMute(exeLower); }
+    bool setAppsVolume(const AppTargetSet& apps, float v01) override { return m_sessions.setAppsVolume(apps.lookup(), v01); }
+
+    bool selectEndpoint(const std::string& idUtf8, std::string& err) override;
+    bool setEndpointVolume(float v01, std::string& err) override;
+    bool getEndpointVolume(float& out01, std::string& err) override;
+    bool setEndpointMute(bool mute, std::string& err) override;
+
+private:
+    AudioController        m_master;
+    AudioSessionController m_sessions;
+
+    std::mutex m_endpointMtx;   // AudioEndpointController tiene l'endpoint selezionato: selezione e uso insieme
+    AudioEndpointController m_endpoint;
+};
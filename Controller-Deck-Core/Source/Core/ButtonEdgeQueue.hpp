@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "Core/ChangeSignal.hpp"
+
+// Fronte di un bottone (già filtrato dal debounce)
+struct ButtonEdge {
+    uint16_t button = 0;     // 0..DeckState::kButtons-1
+    bool     pressed = false; // true = press, false = release
+    std::chrono::steady_clock::time_point at{};   // istante del campione (ricostruito a ritroso dalla read che lo ha portato)
+};
+
+// Coda lock-free single-producer / single-consumer dei fronti dei bottoni.
+// - Produttore: il thread di IO seriale (uno solo alla volta, come per lo store).
+// - Consumatore: il main loop, che la svuota a ogni giro.
+// Lo store tiene solo l'ultimo stato; qui ogni press/release resta finché non
+// viene consumato, qualunque sia il ritmo del consumatore.
+// Capacità fissa N (potenza di due): a coda piena il fronte è scartato e contato.
+template <size_t N>
+class BasicButtonEdgeQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "la capacità deve essere una potenza di due");
+
+public:
+    static constexpr size_t kCapacity = N;
+
+    // Solo produttore. false (e dropped()+1) se la coda è piena.
+    bool push(const ButtonEdge& e) {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == N) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_buf[head & (N - 1)] = e;
+        m_head.store(head + 1, std::memory_order_release);
+        if (m_notify) m_notify->notify();
+        return true;
+    }
+
+    // Solo consumatore: chiama fn(const ButtonEdge&) per ogni fronte in coda, in
+    // ordine di arrivo. Lo slot è liberato prima di fn (che può anche essere lenta).
+    template <class Fn>
+    size_t drain(Fn&& fn) {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        const size_t n = static_cast<size_t>(head - tail);
+        for (; tail != head; ++tail) {
+            const ButtonEdge e = m_buf[tail & (N - 1)];
+            m_tail.store(tail + 1, std::memory_order_release);
+            fn(e);
+        }
+        return n;
+    }
+
+    // Fronti in attesa (indicativo se letto da un terzo thread)
+    size_t size() const {
+        return static_cast<size_t>(m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire));
+    }
+
+    // Fronti persi a coda piena (qualsiasi thread)
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    // Segnale da notificare a ogni push (come DeckStateStore::setNotifier).
+    // Da impostare prima che il produttore parta.
+    void setNotifier(ChangeSignal* s) { m_notify = s; }
+
+private:
+    // Indici monotoni su linee di cache separate: produttore e consumatore non si contendono la stessa
+    alignas(64) std::atomic<uint64_t> m_head{ 0 };   // scritto dal produttore
+    alignas(64) std::atomic<uint64_t> m_tail{ 0 };   // scritto dal consumatore
+    alignas(64) std::array<ButtonEdge, N> m_buf{};
+    std::atomic<uint64_t> m_dropped{ 0 };
+    ChangeSignal* m_notify = nullptr;
+};
+
+// Una coda per deck: a 1 kHz servono 256 fronti senza consumo prima di perderne uno
+using ButtonEdgeQueue = BasicButtonEdgeQueue<256>;
@@ -0,0 +1,73 @@
+#include "Core/ChangeSignal.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include <stdexcept>
+
+#ifdef _WIN32
+
+ChangeSignal::ChangeSignal() {
+    m_event = CreateEventW(nullptr, /*manualReset*/ FALSE, /*initialState*/ FALSE, nullptr);
+    if (!m_event) throw std::runtime_error("CreateEvent fallita");
+}
+
+ChangeSignal::~ChangeSignal() {
+    if (m_event) CloseHandle(static_cast<HANDLE>(m_event));
+}
+
+void ChangeSignal::notify() {
+    // Se c'è già un notify non consumato il consumatore si sveglierà comunque
+    if (m_pending.exchange(true, std::memory_order_acq_rel)) return;
+    SetEvent(static_cast<HANDLE>(m_event));
+}
+
+bool ChangeSignal::waitFor(int64_t timeoutMs) {
+    const DWORD ms = timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs);
+    const bool signaled = WaitForSingleObject(static_cast<HANDLE>(m_event), ms) == WAIT_OBJECT_0;
+    if (signaled) m_wakeups.fetch_add(1, std::memory_order_relaxed);
+    // RMW: si sincronizza con l'ultimo notify, i cui dati sono quindi visibili
+    m_pending.exchange(false, std::memory_order_acq_rel);
+    return signaled;
+}
+
+#else
+
+ChangeSignal::ChangeSignal() {
+    m_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_fd < 0) throw std::runtime_error("eventfd fallita");
+}
+
+ChangeSignal::~ChangeSignal() {
+    if (m_fd >= 0) ::close(m_fd);
+}
+
+void ChangeSignal::notify() {
+    if (m_pending.exchange(true, std::memory_order_acq_rel)) return;
+    const uint64_t one = 1;
+    (void)!::write(m_fd, &one, sizeof(one));
+}
+
+bool ChangeSignal::waitFor(int64_t timeoutMs) {
+    pollfd p{ m_fd, POLLIN, 0 };
+    const int timeout = timeoutMs < 0 ? -1 : static_cast<int>(timeoutMs);
+    int r;
+    do { r = ::poll(&p, 1, timeout); } while (r < 0 && errno == EINTR);
+
+    const bool signaled = r > 0;
+    if (signaled) {
+        uint64_t v;
+        (void)!::read(m_fd, &v, sizeof(v));   // azzera il contatore (non bloccante)
+        m_wakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_pending.exchange(false, std::memory_order_acq_rel);
+    return signaled;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Segnale "stato cambiato" tra il thread di IO seriale e il main loop.
+// - notify(): chiamabile da qualsiasi thread, non blocca; più notify ravvicinati
+//   collassano in un solo risveglio (al massimo una syscall per giro del consumatore).
+// - waitFor(): dorme finché arriva un notify o scade il timeout (-1 = infinito).
+// Backend: Event auto-reset su Windows, eventfd su Linux.
+// Sono possibili risvegli spuri: chi attende deve sempre ricontrollare lo stato.
+class ChangeSignal {
+public:
+    static constexpr int64_t kInfinite = -1;
+
+    ChangeSignal();
+    ~ChangeSignal();
+
+    ChangeSignal(const ChangeSignal&) = delete;
+    ChangeSignal& operator=(const ChangeSignal&) = delete;
+
+    void notify();
+
+    // true se svegliato da un notify, false su timeout
+    bool waitFor(int64_t timeoutMs = kInfinite);
+
+    // Numero di risvegli effettivi di waitFor (diagnostica)
+    uint64_t wakeups() const { return m_wakeups.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> m_pending{ false };
+    std::atomic<uint64_t> m_wakeups{ 0 };
+
+#ifdef _WIN32
+    void* m_event = nullptr;   // HANDLE
+#else
+    int m_fd = -1;             // eventfd
+#endif
+};
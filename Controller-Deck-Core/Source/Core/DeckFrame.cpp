@@ -0,0 +1,118 @@
+#include "DeckFrame.hpp"
+#include <array>
+
+namespace {
+
+    constexpr std::array<uint8_t, 256> MakeCrc8Table() {
+        std::array<uint8_t, 256> t{};
+        for (int i = 0; i < 256; ++i) {
+            uint8_t c = static_cast<uint8_t>(i);
+            for (int b = 0; b < 8; ++b) c = (c & 0x80) ? static_cast<uint8_t>((c << 1) ^ 0x07) : static_cast<uint8_t>(c << 1);
+            t[static_cast<size_t>(i)] = c;
+        }
+        return t;
+    }
+
+    constexpr auto kCrc8Table = MakeCrc8Table();
+
+    constexpr size_t kPackedBytes = kDeckFrameSize - 2;
+    constexpr size_t kButtonsBit = DeckState::kSliders * 10;
+
+    // Campi LSB-first nel blocco impacchettato (n <= 57 bit, il campo sta in una parola)
+    inline uint64_t getBits(const uint8_t* p, size_t bit, size_t n) {
+        uint64_t v = 0;
+        const size_t first = bit / 8;
+        const size_t last = (bit + n - 1) / 8;
+        for (size_t i = first; i <= last; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * (i - first));
+        return (v >> (bit % 8)) & ((uint64_t{ 1 } << n) - 1);
+    }
+
+    inline void putBits(uint8_t* p, size_t bit, size_t n, uint64_t v) {
+        for (size_t k = 0; k < n; ++k, ++bit)
+            if ((v >> k) & 1) p[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+    }
+}
+
+uint8_t DeckFrameCrc8(const uint8_t* data, size_t n) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < n; ++i) crc = kCrc8Table[crc ^ data[i]];
+    return crc;
+}
+
+size_t CobsDecode(std::string_view in, uint8_t* out, size_t outCap) {
+    size_t o = 0;
+    size_t i = 0;
+    while (i < in.size()) {
+        const uint8_t code = static_cast<uint8_t>(in[i++]);
+        if (code == 0) return 0;                         // 0x00 non ammesso nel frame
+        const size_t run = static_cast<size_t>(code) - 1;
+        if (i + run > in.size() || o + run > outCap) return 0;
+        for (size_t k = 0; k < run; ++k) {
+            const uint8_t b = static_cast<uint8_t>(in[i++]);
+            if (b == 0) return 0;
+            out[o++] = b;
+        }
+        // lo zero implicito va aggiunto solo se il blocco non è l'ultimo e non è "pieno"
+        if (code != 0xFF && i < in.size()) {
+            if (o >= outCap) return 0;
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+size_t CobsEncode(const uint8_t* in, size_t n, uint8_t* out) {
+    size_t codeIdx = 0;
+    size_t o = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < n; ++i) {
+        if (in[i] == 0) {
+            out[codeIdx] = code;
+            codeIdx = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xFF) {
+            out[codeIdx] = code;
+            codeIdx = o++;
+            code = 1;
+        }
+    }
+    out[codeIdx] = code;
+    return o;
+}
+
+DeckFrameStatus ParseDeckFrame(std::string_view encoded, DeckState& out, uint8_t& seq) {
+    uint8_t raw[kDeckFrameSize + 1];
+    const size_t n = CobsDecode(encoded, raw, sizeof(raw));
+    if (n == 0) return DeckFrameStatus::BadEncoding;
+    if (n != kDeckFrameSize) return DeckFrameStatus::BadLength;
+    if (DeckFrameCrc8(raw, kDeckFrameSize - 1) != raw[kDeckFrameSize - 1]) return DeckFrameStatus::BadCrc;
+
+    const uint8_t* packed = raw + 1;
+    DeckState st{};
+    for (size_t i = 0; i < DeckState::kSliders; ++i) st.sliders[i] = static_cast<int>(getBits(packed, 10 * i, 10));
+    for (size_t i = 0; i < DeckState::kButtons; ++i) st.buttons[i] = getBits(packed, kButtonsBit + i, 1) != 0;
+
+    seq = raw[0];
+    out = st;
+    return DeckFrameStatus::Ok;
+}
+
+size_t EncodeDeckFrame(const DeckState& s, uint8_t seq, uint8_t* out) {
+    uint8_t raw[kDeckFrameSize] = {};
+    raw[0] = seq;
+    for (size_t i = 0; i < DeckState::kSliders; ++i) {
+        int v = s.sliders[i];
+        if (v < 0) v = 0;
+        if (v > 1023) v = 1023;
+        putBits(raw + 1, 10 * i, 10, static_cast<uint64_t>(v));
+    }
+    putBits(raw + 1, kButtonsBit, DeckState::kButtons, s.buttonsMask());
+    raw[kDeckFrameSize - 1] = DeckFrameCrc8(raw, kDeckFrameSize - 1);
+
+    const size_t n = CobsEncode(raw, kDeckFrameSize, out);
+    out[n] = 0; // delimitatore
+    return n + 1;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "DeckState.hpp"
+
+// Protocollo binario compatto, alternativo alle linee "v0|v1|...|mask".
+//
+// Frame decodificato (9 byte col deck di default, 5 slider + 5 bottoni):
+//   [0]     seq    numero di sequenza (uint8, wrap a 256)
+//   [1..n]  bits   S slider da 10 bit + B bit bottoni, impacchettati LSB-first
+//   [n+1]   crc    CRC-8 (poly 0x07, init 0x00) sui byte [0..n]
+// Sul filo il frame è codificato COBS e terminato da 0x00: 11 byte per campione,
+// cioè ~1050 frame/s a 115200 baud (la linea testuale ne richiede ~25).
+// Le linee testuali non contengono mai 0x00: è così che i due formati si distinguono.
+
+constexpr size_t kDeckFrameBits = DeckState::kSliders * 10 + DeckState::kButtons;
+constexpr size_t kDeckFrameSize = 1 + (kDeckFrameBits + 7) / 8 + 1;        // decodificato
+constexpr size_t kDeckFrameMaxEncoded = kDeckFrameSize + 1 + 1;            // COBS + 0x00
+static_assert(kDeckFrameSize < 254, "il frame deve stare in un solo blocco COBS");
+
+enum class DeckFrameStatus {
+    Ok,
+    BadEncoding,   // COBS non valido
+    BadLength,     // lunghezza decodificata diversa da kDeckFrameSize
+    BadCrc         // checksum errato
+};
+
+// CRC-8 (poly 0x07) usato dal frame
+uint8_t DeckFrameCrc8(const uint8_t* data, size_t n);
+
+// Decodifica COBS: in = frame SENZA il delimitatore 0x00.
+// Ritorna il numero di byte scritti in out, 0 se l'input non è valido.
+size_t CobsDecode(std::string_view in, uint8_t* out, size_t outCap);
+
+// Codifica COBS (senza delimitatore). out deve avere almeno n + n/254 + 1 byte.
+size_t CobsEncode(const uint8_t* in, size_t n, uint8_t* out);
+
+// Parsea un frame COBS (senza delimitatore) in DeckState + seq.
+DeckFrameStatus ParseDeckFrame(std::string_view encoded, DeckState& out, uint8_t& seq);
+
+// Costruisce il frame completo da inviare (COBS + 0x00 finale) in out
+// (almeno kDeckFrameMaxEncoded byte). Usato da emulatori/test e come
+// riferimento per il firmware. Ritorna i byte scritti.
+size_t EncodeDeckFrame(const DeckState& s, uint8_t seq, uint8_t* out);
@@ -1,44 +1,114 @@
 #pragma once
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
-#include <mutex>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include "Core/ChangeSignal.hpp"
 
-// Rappresenta lo stato "grezzo" letto dalla seriale
-struct DeckState {
-    std::array<int, 5> sliders{};   // 0..1023
-    std::array<bool, 5> buttons{};  // true = premuto
+// Numero di canali del deck, fissato a compile time. Per un deck più grande
+// (8, 16, 32 fader...) basta ridefinirli nella build (premake: defines).
+#ifndef CONTROLLER_DECK_SLIDERS
+#define CONTROLLER_DECK_SLIDERS 5
+#endif
+#ifndef CONTROLLER_DECK_BUTTONS
+#define CONTROLLER_DECK_BUTTONS 5
+#endif
 
-    // Bitmask dei bottoni (bit 0 = B1, bit 4 = B5)
-    uint32_t buttonsMask() const {
-        uint32_t m = 0;
-        for (int i = 0; i < 5; ++i) if (buttons[i]) m |= (1u << i);
+// Rappresenta lo stato "grezzo" letto dalla seriale, per S slider e B bottoni.
+// Solo array a dimensione fissa: copiabile con memcpy, cicli srotolabili.
+template <size_t S, size_t B>
+struct BasicDeckState {
+    static_assert(S >= 1, "serve almeno uno slider");
+    static_assert(B <= 64, "la bitmask dei bottoni sta in 64 bit");
+
+    static constexpr size_t kSliders = S;
+    static constexpr size_t kButtons = B;
+
+    // Bitmask dei bottoni: l'intero più piccolo che contiene B bit
+    using Mask = std::conditional_t<(B <= 32), uint32_t, uint64_t>;
+    static constexpr Mask kButtonsAll = B == 0 ? Mask{ 0 } : static_cast<Mask>(~Mask{ 0 } >> (sizeof(Mask) * 8 - B));
+
+    std::array<int, S> sliders{};   // 0..1023
+    std::array<bool, B> buttons{};  // true = premuto
+
+    // Istanti del campione (steady_clock): fine della read seriale che lo ha
+    // portato e fine del parsing. Restano a epoch se lo stato non viene dalla seriale.
+    std::chrono::steady_clock::time_point readAt{};
+    std::chrono::steady_clock::time_point parsedAt{};
+
+    // Bitmask dei bottoni (bit 0 = B1, bit B-1 = ultimo bottone)
+    Mask buttonsMask() const {
+        Mask m = 0;
+        for (size_t i = 0; i < B; ++i) if (buttons[i]) m |= (Mask{ 1 } << i);
         return m;
     }
+
+    void setButtonsMask(Mask m) {
+        for (size_t i = 0; i < B; ++i) buttons[i] = ((m >> i) & 1) != 0;
+    }
 };
 
-// Storage thread-safe dell'ultimo stato
-class DeckStateStore {
+inline constexpr size_t kDeckSliders = CONTROLLER_DECK_SLIDERS;
+inline constexpr size_t kDeckButtons = CONTROLLER_DECK_BUTTONS;
+
+// Il deck di questa build: tutta la pipeline (parser, smoothing, mapping, API) usa questo
+using DeckState = BasicDeckState<kDeckSliders, kDeckButtons>;
+
+// Storage dell'ultimo stato: seqlock single-writer / multi-reader.
+// - Un solo scrittore alla volta (il thread di IO seriale): non si blocca mai sui lettori.
+// - I lettori (main loop, REST, SSE) non prendono lock: se leggono durante una
+//   scrittura riprovano (finestra di pochi ns).
+// - version() cresce a ogni pubblicazione: chi legge può saltare il lavoro se
+//   non è cambiato nulla dall'ultima lettura.
+template <class State>
+class BasicDeckStateStore {
 public:
-    // Sostituisce lo stato corrente
-    void set(const DeckState& s) {
-        std::lock_guard<std::mutex> lock(m_mutex);
+    // Sostituisce lo stato corrente (solo scrittore)
+    void set(const State& s) {
         m_state = s;
+        publish();
     }
 
-    // Restituisce una copia dello stato corrente
-    DeckState get() const {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        return m_state;
+    // Restituisce una copia dello stato corrente (qualsiasi thread)
+    State get() const {
+        uint64_t v;
+        return get(v);
     }
 
+    // Copia coerente dello stato + versione a cui si riferisce
+    State get(uint64_t& version) const {
+        uint64_t words[kWords];
+        uint64_t s1, s2;
+        do {
+            s1 = m_seq.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWords; ++i) words[i] = m_words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s2 = m_seq.load(std::memory_order_relaxed);
+        } while ((s1 & 1) || s1 != s2);
+
+        State out;
+        std::memcpy(&out, words, sizeof(State));
+        version = s1 >> 1;
+        return out;
+    }
+
+    // Numero di pubblicazioni finora (monotono)
+    uint64_t version() const { return m_seq.load(std::memory_order_acquire) >> 1; }
+
+    // Segnale da notificare a ogni pubblicazione (es. per svegliare il main loop).
+    // Da impostare prima che lo scrittore parta; il segnale deve sopravvivere allo store.
+    void setNotifier(ChangeSignal* s) { m_notify = s; }
+
     // Aggiorna solo se ci sono cambi significativi (riduce lo spam)
-    // Ritorna true se qualcosa è cambiato.
-    bool updateIfChanged(const DeckState& s, int sliderThreshold = 2) {
-        std::lock_guard<std::mutex> lock(m_mutex);
+    // Ritorna true se qualcosa è cambiato. Solo scrittore.
+    bool updateIfChanged(const State& s, int sliderThreshold = 2) {
         bool changed = false;
 
         // Bottoni: qualsiasi variazione è "cambio"
-        for (int i = 0; i < 5; ++i) {
+        for (size_t i = 0; i < State::kButtons; ++i) {
             if (m_state.buttons[i] != s.buttons[i]) {
                 m_state.buttons[i] = s.buttons[i];
                 changed = true;
@@ -46,17 +116,42 @@ public:
         }
 
         // Slider: applica soglia per il rumore
-        for (int i = 0; i < 5; ++i) {
+        for (size_t i = 0; i < State::kSliders; ++i) {
             if (std::abs(m_state.sliders[i] - s.sliders[i]) >= sliderThreshold) {
                 m_state.sliders[i] = s.sliders[i];
                 changed = true;
             }
         }
 
+        if (changed) {
+            m_state.readAt = s.readAt;
+            m_state.parsedAt = s.parsedAt;
+            publish();
+        }
         return changed;
     }
 
 private:
-    mutable std::mutex m_mutex;
-    DeckState m_state{};
+    static_assert(std::is_trivially_copyable_v<State>, "lo stato deve essere copiabile con memcpy");
+    static constexpr size_t kWords = (sizeof(State) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    void publish() {
+        uint64_t words[kWords] = {};
+        std::memcpy(words, &m_state, sizeof(State));
+
+        const uint64_t s = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(s + 1, std::memory_order_relaxed);         // dispari: scrittura in corso
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; ++i) m_words[i].store(words[i], std::memory_order_relaxed);
+        m_seq.store(s + 2, std::memory_order_release);         // pari: stato coerente
+
+        if (m_notify) m_notify->notify();
+    }
+
+    std::atomic<uint64_t> m_seq{ 0 };
+    std::array<std::atomic<uint64_t>, kWords> m_words{};
+    State m_state{};   // copia privata dello scrittore
+    ChangeSignal* m_notify = nullptr;
 };
+
+using DeckStateStore = BasicDeckStateStore<DeckState>;
@@ -1,64 +1,135 @@
-﻿#pragma once
-#include <optional>
-#include <string>
-#include "DeckState.hpp"
-
-// Parsea una linea nel formato "v0|v1|v2|v3|v4|mask"
-// - Compatibile col DeeJ (se arrivano solo 5 valori → mask=0)
-// - v* in [0..1023], mask in [0..31] (bit0..bit4 = B1..B5)
-std::optional<DeckState> ParseDeckLine(const std::string& line);
-#include "MessageParser.hpp"
-#include <vector>
-#include <charconv>
-#include <algorithm>
-
-static inline std::string trim(const std::string& s) {
-    auto b = s.find_first_not_of(" \t\r\n");
-    auto e = s.find_last_not_of(" \t\r\n");
-    if (b == std::string::npos) return {};
-    return s.substr(b, e - b + 1);
-}
+﻿#include "MessageParser.hpp"
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
 
-static bool toInt(const std::string& s, int& out) {
-    auto sv = std::string_view(s);
-    auto first = sv.data();
-    auto last = sv.data() + sv.size();
-    std::from_chars_result r = std::from_chars(first, last, out);
-    return r.ec == std::errc() && r.ptr == last;
-}
+// Parser senza allocazioni: scansiona la linea sul posto cercando i '|'
+// 8 byte alla volta (SWAR) e converte ogni token direttamente in DeckState.
+
+namespace {
+
+    constexpr uint64_t kOnes = 0x0101010101010101ull;
+    constexpr uint64_t kLow7 = 0x7F7F7F7F7F7F7F7Full;
+    constexpr uint64_t kPipes = kOnes * static_cast<uint8_t>('|');
+
+    constexpr size_t kSliders = DeckState::kSliders;
+
+    // S slider + mask + eventuale token finale vuoto: oltre la linea è comunque invalida
+    constexpr size_t kMaxSeps = kSliders + 2;
+
+    // Mask letta come int finché ci sta (stesse regole di prima), altrimenti a 64 bit
+    using MaskInt = std::conditional_t<(DeckState::kButtons < 31), int, int64_t>;
+    constexpr MaskInt kMaskMax = DeckState::kButtons < 63
+        ? static_cast<MaskInt>(DeckState::kButtonsAll)
+        : std::numeric_limits<MaskInt>::max();
+
+    // Bit 7 acceso in ogni byte di w uguale a '|' (esatto, senza falsi positivi)
+    inline uint64_t pipeBytes(uint64_t w) {
+        const uint64_t x = w ^ kPipes;
+        return ~(((x & kLow7) + kLow7) | x | kLow7);
+    }
+
+    // Posizioni dei '|' in line; ritorna il numero trovato, o kMaxSeps+1 se troppi
+    size_t findSeparators(std::string_view line, size_t (&pos)[kMaxSeps]) {
+        size_t n = 0;
+        size_t i = 0;
+        const char* p = line.data();
+        const size_t len = line.size();
+
+        for (; i + 8 <= len; i += 8) {
+            uint64_t w;
+            std::memcpy(&w, p + i, 8);
+            uint64_t m = pipeBytes(w);
+            while (m) {
+                if (n == kMaxSeps) return kMaxSeps + 1;
+                pos[n++] = i + static_cast<size_t>(std::countr_zero(m) >> 3); // little-endian
+                m &= m - 1;
+            }
+        }
+        for (; i < len; ++i) {
+            if (p[i] != '|') continue;
+            if (n == kMaxSeps) return kMaxSeps + 1;
+            pos[n++] = i;
+        }
+        return n;
+    }
 
-std::optional<DeckState> ParseDeckLine(const std::string& line) {
-    // split su '|'
-    std::vector<std::string> tok;
-    std::string cur;
-    cur.reserve(line.size());
-    for (char c : line) {
-        if (c == '\n' || c == '\r') continue;
-        if (c == '|') { tok.push_back(cur); cur.clear(); }
-        else cur.push_back(c);
+    inline bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
     }
-    if (!cur.empty()) tok.push_back(cur);
 
-    if (tok.size() != 5 && tok.size() != 6) return std::nullopt;
+    // Token con soli CR/LF (o vuoto): come prima, in coda alla linea viene ignorato
+    inline bool onlyLineBreaks(std::string_view t) {
+        for (char c : t) if (c != '\r' && c != '\n') return false;
+        return true;
+    }
+
+    // Intero decimale con segno opzionale, spazi ai bordi ammessi.
+    // Stesse regole di std::from_chars sul token trimmato (niente '+', fuori range = errore).
+    template <class Int>
+    bool parseInt(std::string_view t, Int& out) {
+        size_t b = 0, e = t.size();
+        while (b < e && isSpace(t[b])) ++b;
+        while (e > b && isSpace(t[e - 1])) --e;
+        if (b == e) return false;
+
+        bool neg = false;
+        if (t[b] == '-') { neg = true; ++b; }
+        if (b == e) return false;
+
+        constexpr uint64_t kLimit = static_cast<uint64_t>(std::numeric_limits<Int>::max()) + 1; // |MIN|
+        uint64_t v = 0;
+        for (size_t i = b; i < e; ++i) {
+            const unsigned d = static_cast<unsigned char>(t[i]) - '0';
+            if (d > 9) return false;
+            if (v > (kLimit - d) / 10) return false;   // prima di moltiplicare: con Int a 64 bit v*10 trabocca uint64
+            v = v * 10 + d;
+        }
+        if (!neg && v == kLimit) return false;
+
+        out = neg ? static_cast<Int>(0 - v) : static_cast<Int>(v);
+        return true;
+    }
+
+    template <class Int>
+    inline Int clampInt(Int v, Int lo, Int hi) {
+        return v < lo ? lo : (v > hi ? hi : v);
+    }
+}
+
+std::optional<DeckState> ParseDeckLine(std::string_view line) {
+    size_t sep[kMaxSeps];
+    const size_t nSep = findSeparators(line, sep);
+    if (nSep + 1 < kSliders || nSep > kSliders + 1) return std::nullopt;
+
+    // confini dei token: [begin_i, end_i)
+    auto tokenAt = [&](size_t i) {
+        const size_t b = (i == 0) ? 0 : sep[i - 1] + 1;
+        const size_t e = (i == nSep) ? line.size() : sep[i];
+        return line.substr(b, e - b);
+    };
+
+    size_t nTok = nSep + 1;
+    if (onlyLineBreaks(tokenAt(nSep))) --nTok; // es. "1|2|3|4|5|\r\n"
+    if (nTok != kSliders && nTok != kSliders + 1) return std::nullopt;
 
     DeckState st{};
     // sliders
-    for (int i = 0; i < 5; ++i) {
+    for (size_t i = 0; i < kSliders; ++i) {
         int v = 0;
-        if (!toInt(trim(tok[i]), v)) return std::nullopt;
-        if (v < 0) v = 0;
-        if (v > 1023) v = 1023;
-        st.sliders[i] = v;
+        if (!parseInt(tokenAt(i), v)) return std::nullopt;
+        st.sliders[i] = clampInt(v, 0, 1023);
     }
 
     // mask
-    int mask = 0;
-    if (tok.size() == 6) {
-        if (!toInt(trim(tok[5]), mask)) return std::nullopt;
-        if (mask < 0) mask = 0;
-        if (mask > 31) mask = 31;
+    MaskInt mask = 0;
+    if (nTok == kSliders + 1) {
+        if (!parseInt(tokenAt(kSliders), mask)) return std::nullopt;
+        mask = clampInt<MaskInt>(mask, 0, kMaskMax);
     }
-    for (int i = 0; i < 5; ++i) st.buttons[i] = ((mask >> i) & 1) != 0;
+    st.setButtonsMask(static_cast<DeckState::Mask>(mask));
 
     return st;
 }
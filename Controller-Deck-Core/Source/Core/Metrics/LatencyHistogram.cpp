@@ -0,0 +1,65 @@
+#include "Core/Metrics/LatencyHistogram.hpp"
+#include <bit>
+
+size_t LatencyHistogram::bucketOf(uint64_t ns) {
+    constexpr uint64_t kMax = (uint64_t{ 1 } << kMaxBits) - 1;
+    if (ns > kMax) ns = kMax;
+    if (ns < kSub) return static_cast<size_t>(ns);                 // lineare sotto 16 ns
+
+    const int shift = static_cast<int>(std::bit_width(ns)) - 1 - kSubBits;
+    return static_cast<size_t>(shift + 1) * kSub + static_cast<size_t>((ns >> shift) - kSub);
+}
+
+uint64_t LatencyHistogram::bucketUpper(size_t idx) {
+    if (idx < kSub) return idx;
+    const int shift = static_cast<int>(idx / kSub) - 1;
+    const uint64_t low = static_cast<uint64_t>(kSub + idx % kSub) << shift;
+    return low + (uint64_t{ 1 } << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t ns) {
+    const uint64_t v = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    m_counts[bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(v, std::memory_order_relaxed);
+
+    uint64_t cur = m_maxNs.load(std::memory_order_relaxed);
+    while (v > cur && !m_maxNs.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+}
+
+uint64_t LatencyHistogram::percentileNs(double p) const {
+    uint64_t total = 0;
+    for (const auto& c : m_counts) total += c.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+
+    const double want = p * static_cast<double>(total);
+    uint64_t target = static_cast<uint64_t>(want);
+    if (static_cast<double>(target) < want) ++target;                // ceil
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        seen += m_counts[i].load(std::memory_order_relaxed);
+        if (seen >= target) return bucketUpper(i);
+    }
+    return bucketUpper(kBuckets - 1);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot s;
+    for (const auto& c : m_counts) s.count += c.load(std::memory_order_relaxed);
+    if (s.count == 0) return s;
+
+    s.meanNs = static_cast<double>(m_sumNs.load(std::memory_order_relaxed)) / static_cast<double>(s.count);
+    s.maxNs = m_maxNs.load(std::memory_order_relaxed);
+    s.p50Ns = percentileNs(0.50);
+    s.p90Ns = percentileNs(0.90);
+    s.p99Ns = percentileNs(0.99);
+    s.p999Ns = percentileNs(0.999);
+    return s;
+}
+
+void LatencyHistogram::reset() {
+    for (auto& c : m_counts) c.store(0, std::memory_order_relaxed);
+    m_sumNs.store(0, std::memory_order_relaxed);
+    m_maxNs.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Istogramma di latenze lock-free in stile HDR: bucket log-lineari con 16
+// sotto-bucket per potenza di 2 (errore relativo <= 6.25%), da 1 ns a ~68 s.
+// - record(): wait-free (solo fetch_add relaxed), chiamabile da più thread.
+// - snapshot(): legge i contatori senza fermare gli scrittori; durante una
+//   scrittura concorrente i totali possono differire di qualche campione.
+class LatencyHistogram {
+public:
+    struct Snapshot {
+        uint64_t count = 0;
+        double   meanNs = 0.0;
+        uint64_t maxNs = 0;
+        uint64_t p50Ns = 0;
+        uint64_t p90Ns = 0;
+        uint64_t p99Ns = 0;
+        uint64_t p999Ns = 0;
+    };
+
+    void record(int64_t ns);
+
+    template <class Rep, class Period>
+    void record(std::chrono::duration<Rep, Period> d) {
+        record(static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+    }
+
+    Snapshot snapshot() const;
+    void reset();
+
+    // Valore (ns) riportato per il percentile p (0..1), limite superiore del bucket
+    uint64_t percentileNs(double p) const;
+
+private:
+    static constexpr int    kSubBits = 4;
+    static constexpr size_t kSub = size_t{ 1 } << kSubBits;
+    static constexpr int    kMaxBits = 36;                            // 2^36 ns ~ 68.7 s
+    static constexpr size_t kBuckets = (kMaxBits - kSubBits + 1) * kSub;
+
+    static size_t   bucketOf(uint64_t ns);
+    static uint64_t bucketUpper(size_t idx);
+
+    std::array<std::atomic<uint64_t>, kBuckets> m_counts{};
+    std::atomic<uint64_t> m_sumNs{ 0 };
+    std::atomic<uint64_t> m_maxNs{ 0 };
+};
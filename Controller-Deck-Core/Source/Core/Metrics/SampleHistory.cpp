@@ -0,0 +1,92 @@
+#include "Core/Metrics/SampleHistory.hpp"
+#include <algorithm>
+
+namespace {
+    uint16_t Clamp16(int v) { return static_cast<uint16_t>(std::clamp(v, 0, 0xFFFF)); }
+}
+
+SampleHistory::SampleHistory()
+    : m_base(Clock::now())
+    , m_values(std::make_unique<std::atomic<uint16_t>[]>(2 * kChannels * kCapacity))
+    , m_times(std::make_unique<std::atomic<uint32_t>[]>(kCapacity)) {
+}
+
+uint32_t SampleHistory::toMs(Clock::time_point t) const {
+    if (t <= m_base) return 0;
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t - m_base).count();
+    return static_cast<uint32_t>(std::min<int64_t>(ms, UINT32_MAX));
+}
+
+void SampleHistory::push(Clock::time_point at, const std::array<int, kChannels>& raw, const std::array<int, kChannels>& filtered) {
+    const uint64_t head = m_head.load(std::memory_order_relaxed);
+    // i tempi restano monotoni anche se "at" arriva da una read precedente
+    const uint32_t prev = head ? timeAt(head - 1) : 0;
+    m_times[head & (kCapacity - 1)].store(std::max(toMs(at), prev), std::memory_order_relaxed);
+    for (size_t ch = 0; ch < kChannels; ++ch) {
+        value(Source::Raw, ch, head).store(Clamp16(raw[ch]), std::memory_order_relaxed);
+        value(Source::Filtered, ch, head).store(Clamp16(filtered[ch]), std::memory_order_relaxed);
+    }
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+uint64_t SampleHistory::search(uint64_t lo, uint64_t hi, uint32_t ms, bool upper) const {
+    while (lo < hi) {
+        const uint64_t mid = lo + (hi - lo) / 2;
+        const uint32_t t = timeAt(mid);
+        if (upper ? t <= ms : t < ms) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+bool SampleHistory::query(size_t channel, Source src, uint32_t fromMs, uint32_t toMs, size_t maxPoints, HistorySeries& out) const {
+    if (channel >= kChannels) return false;
+    if (toMs < fromMs) std::swap(fromMs, toMs);
+    maxPoints = std::clamp<size_t>(maxPoints, 1, kMaxPoints);
+
+    // bucket di larghezza intera in ms: i confini non dipendono da quali campioni ci sono
+    const uint64_t span = uint64_t{ toMs } - fromMs + 1;
+    const uint64_t width = (span + maxPoints - 1) / maxPoints;
+
+    for (int attempt = 0; ; ++attempt) {
+        out = HistorySeries{};
+        out.fromMs = fromMs;
+        out.toMs = toMs;
+        out.bucketMs = static_cast<uint32_t>(width);
+        out.t.reserve(maxPoints); out.min.reserve(maxPoints); out.max.reserve(maxPoints); out.last.reserve(maxPoints);
+
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        const uint64_t oldest = head > kCapacity - kGuard ? head - (kCapacity - kGuard) : 0;
+        const uint64_t lo = search(oldest, head, fromMs, false);
+        const uint64_t hi = search(lo, head, toMs, true);
+
+        // una divisione per bucket, non per campione: i tempi sono monotoni
+        uint64_t bucketEnd = 0;   // primo ms dopo il bucket corrente (0 = nessun bucket aperto)
+        uint32_t t = 0;
+        uint16_t mn = 0, mx = 0, last = 0;
+        for (uint64_t i = lo; i < hi; ++i) {
+            const uint32_t ti = timeAt(i);
+            const uint16_t v = value(src, channel, i).load(std::memory_order_relaxed);
+            if (ti >= bucketEnd) {
+                if (bucketEnd) {
+                    out.t.push_back(t); out.min.push_back(mn); out.max.push_back(mx); out.last.push_back(last);
+                }
+                bucketEnd = fromMs + ((ti - fromMs) / width + 1) * width;
+                mn = mx = v;
+            }
+            mn = std::min(mn, v);
+            mx = std::max(mx, v);
+            last = v;
+            t = ti;
+        }
+        if (bucketEnd) {
+            out.t.push_back(t); out.min.push_back(mn); out.max.push_back(mx); out.last.push_back(last);
+        }
+        out.samples = hi - lo;
+
+        // Validazione: lo scrittore non deve aver riciclato lo slot lo durante la scansione
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t now = m_head.load(std::memory_order_relaxed);
+        if (now - lo <= kCapacity || attempt + 1 >= kMaxRetries) return true;
+    }
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Core/DeckState.hpp"
+
+// Serie decimata di un canale in [from, to]: un punto per bucket di tempo non vuoto
+struct HistorySeries {
+    uint32_t fromMs = 0, toMs = 0;   // intervallo effettivo (clock della history)
+    uint32_t bucketMs = 0;           // larghezza di un bucket
+    uint64_t samples = 0;            // campioni grezzi letti per costruire la serie
+    std::vector<uint32_t> t;         // istante dell'ultimo campione del bucket
+    std::vector<uint16_t> min, max, last;
+};
+
+// Storico a memoria fissa dei campioni dei fader di un deck: ring di kCapacity
+// campioni con timestamp, in struct-of-arrays a 16 bit (un array per canale e
+// sorgente, uno per i tempi in ms). A 1 kHz copre ~32 s, a 100 Hz ~5 min.
+// - Sorgenti: Raw = valore dal parser, Filtered = uscita della FaderFilterChain.
+// - push(): unico scrittore (il thread di IO), wait-free, nessuna allocazione.
+// - query(): da qualsiasi thread, lock-free. Ricerca binaria sui tempi e un solo
+//   passaggio sull'intervallo richiesto verso min/max/last per bucket: lo storico
+//   non viene mai copiato. Se lo scrittore sovrascrive la finestra letta durante
+//   la scansione, la query viene ripetuta.
+class SampleHistory {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t kChannels = DeckState::kSliders;
+    static constexpr size_t kCapacity = size_t{ 1 } << 15;   // potenza di due
+    static constexpr size_t kMaxPoints = 5000;
+
+    enum class Source : uint8_t { Raw, Filtered };
+
+    SampleHistory();
+
+    // Solo scrittore. I valori fuori da 0..65535 vengono saturati.
+    void push(Clock::time_point at, const std::array<int, kChannels>& raw, const std::array<int, kChannels>& filtered);
+
+    // Istante t sul clock della history (ms dalla costruzione)
+    uint32_t toMs(Clock::time_point t) const;
+    uint32_t nowMs() const { return toMs(Clock::now()); }
+
+    // Campioni scritti da sempre (il ring ne conserva al più kCapacity)
+    uint64_t written() const { return m_head.load(std::memory_order_acquire); }
+
+    // Serie del canale in [fromMs, toMs] con al più maxPoints punti (1..kMaxPoints).
+    // false se channel non esiste.
+    bool query(size_t channel, Source src, uint32_t fromMs, uint32_t toMs, size_t maxPoints, HistorySeries& out) const;
+
+private:
+    // Slot che lo scrittore può riempire durante una query prima che la si debba
+    // ripetere: la finestra leggibile si ferma kGuard campioni prima del più vecchio
+    static constexpr size_t kGuard = 1024;
+    static constexpr int    kMaxRetries = 4;
+
+    std::atomic<uint16_t>& value(Source src, size_t ch, uint64_t i) const {
+        return m_values[(static_cast<size_t>(src) * kChannels + ch) * kCapacity + (i & (kCapacity - 1))];
+    }
+    uint32_t timeAt(uint64_t i) const { return m_times[i & (kCapacity - 1)].load(std::memory_order_relaxed); }
+
+    // Primo indice in [lo, hi) con tempo > ms (upper) o >= ms (!upper)
+    uint64_t search(uint64_t lo, uint64_t hi, uint32_t ms, bool upper) const;
+
+    Clock::time_point m_base;
+    // Gli slot sono atomici (relaxed) perché un lettore può leggere uno slot
+    // mentre lo scrittore lo ricicla: il valore è scartato dalla validazione su m_head
+    std::unique_ptr<std::atomic<uint16_t>[]> m_values;   // [sorgente][canale][slot]
+    std::unique_ptr<std::atomic<uint32_t>[]> m_times;    // [slot], ms dalla costruzione
+    alignas(64) std::atomic<uint64_t> m_head{ 0 };       // prossimo slot da scrivere (monotono)
+};
@@ -0,0 +1,22 @@
+#include "Core/Serial/ButtonDebouncer.hpp"
+
+void ButtonDebouncer::reset(const std::array<bool, DeckState::kButtons>& stable) {
+    m_stable = stable;
+    m_lastEdge.fill(Clock::time_point{});
+}
+
+DeckState::Mask ButtonDebouncer::apply(DeckState& s, Clock::time_point t) {
+    DeckState::Mask changed = 0;
+    for (size_t i = 0; i < DeckState::kButtons; ++i) {
+        if (s.buttons[i] != m_stable[i]) {
+            const bool locked = m_lastEdge[i] != Clock::time_point{} && t - m_lastEdge[i] < m_window;
+            if (!locked) {
+                m_stable[i] = s.buttons[i];
+                m_lastEdge[i] = t;
+                changed |= DeckState::Mask{ 1 } << i;
+            }
+        }
+        s.buttons[i] = m_stable[i];
+    }
+    return changed;
+}
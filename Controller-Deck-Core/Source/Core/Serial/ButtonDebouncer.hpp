@@ -0,0 +1,30 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include "Core/DeckState.hpp"
+
+// Debounce dei bottoni "a blocco", come un debouncer hardware con lockout:
+// - il primo cambio di livello passa subito (nessuna latenza aggiunta al press);
+// - per window dopo ogni fronte accettato il bottone ignora i rimbalzi;
+// - allo scadere, se il livello grezzo è diverso da quello accettato, il cambio
+//   passa al primo campione utile: un release arrivato durante il blocco non si perde.
+// Un tap più breve della finestra produce comunque press + release.
+class ButtonDebouncer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void setWindow(std::chrono::microseconds w) { m_window = w.count() > 0 ? w : std::chrono::microseconds{ 0 }; }
+    std::chrono::microseconds window() const { return m_window; }
+
+    // Riparte da uno stato accettato noto (es. all'apertura della porta), senza blocchi attivi
+    void reset(const std::array<bool, DeckState::kButtons>& stable);
+
+    // Filtra s.buttons in-place con il campione arrivato a t.
+    // Ritorna la maschera dei bottoni il cui stato accettato è cambiato.
+    DeckState::Mask apply(DeckState& s, Clock::time_point t);
+
+private:
+    std::chrono::microseconds m_window{ 0 };
+    std::array<bool, DeckState::kButtons> m_stable{};
+    std::array<Clock::time_point, DeckState::kButtons> m_lastEdge{};   // epoch = nessun blocco
+};
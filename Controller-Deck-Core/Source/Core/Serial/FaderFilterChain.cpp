@@ -0,0 +1,97 @@
+#include "Core/Serial/FaderFilterChain.hpp"
+#include <algorithm>
+#include <cstdlib>
+
+const char* FilterStageName(FilterStageKind k) {
+    switch (k) {
+    case FilterStageKind::MinDelta: return "min_delta";
+    default:                        return "smooth";
+    }
+}
+
+std::vector<FilterStageConfig> DefaultFilterStages() {
+    FilterStageConfig minDelta{ FilterStageKind::MinDelta, {} };
+    minDelta.counts.fill(kDefaultMinDeltaCounts);
+    return { FilterStageConfig{ FilterStageKind::Smooth, {} }, minDelta };
+}
+
+FaderFilterChain::FaderFilterChain() {
+    configure(FilterChainConfig{});
+}
+
+void FaderFilterChain::ClearCounters(Stage& st) {
+    for (size_t k = 0; k < kChannels; ++k) {
+        st.in[k].store(0, std::memory_order_relaxed);
+        st.out[k].store(0, std::memory_order_relaxed);
+        st.suppressed[k].store(0, std::memory_order_relaxed);
+    }
+}
+
+void FaderFilterChain::configure(const FilterChainConfig& cfg) {
+    for (size_t k = 0; k < kChannels; ++k) m_smoother.setParams(static_cast<int>(k), cfg.smoothing[k]);
+
+    const size_t old = m_count.load(std::memory_order_relaxed);
+    const size_t n = std::min(cfg.stages.size(), kMaxStages);
+    for (size_t p = 0; p < n; ++p) {
+        auto& st = m_stages[p];
+        const auto kind = cfg.stages[p].kind;
+        if (p >= old || st.kind.load(std::memory_order_relaxed) != kind) {
+            st.kind.store(kind, std::memory_order_relaxed);
+            st.primed = false;
+            ClearCounters(st);
+            if (kind == FilterStageKind::Smooth) m_smoother.reset();
+        }
+        for (size_t k = 0; k < kChannels; ++k) st.counts[k] = std::max(cfg.stages[p].counts[k], 0);
+    }
+    m_count.store(n, std::memory_order_release);
+}
+
+void FaderFilterChain::reset() {
+    m_smoother.reset();
+    for (auto& st : m_stages) st.primed = false;
+}
+
+void FaderFilterChain::apply(DeckState& s, float dt) {
+    const size_t n = m_count.load(std::memory_order_relaxed);
+    for (size_t p = 0; p < n; ++p) {
+        auto& st = m_stages[p];
+        const auto in = s.sliders;
+
+        switch (st.kind.load(std::memory_order_relaxed)) {
+        case FilterStageKind::Smooth:
+            m_smoother.apply(s, dt);
+            break;
+        case FilterStageKind::MinDelta:
+            if (st.primed) {
+                for (size_t k = 0; k < kChannels; ++k)
+                    if (std::abs(s.sliders[k] - st.lastOut[k]) < st.counts[k]) s.sliders[k] = st.lastOut[k];
+            }
+            break;
+        }
+
+        for (size_t k = 0; k < kChannels; ++k) {
+            Bump(st.in[k]);
+            if (!st.primed) continue;   // primo campione: aggancia, non è un cambio
+            if (s.sliders[k] != st.lastOut[k]) Bump(st.out[k]);
+            else if (in[k] != st.lastIn[k]) Bump(st.suppressed[k]);
+        }
+        st.lastIn = in;
+        st.lastOut = s.sliders;
+        st.primed = true;
+    }
+}
+
+std::vector<FilterStageStats> FaderFilterChain::stats() const {
+    const size_t n = m_count.load(std::memory_order_acquire);
+    std::vector<FilterStageStats> out(n);
+    for (size_t p = 0; p < n; ++p) {
+        const auto& st = m_stages[p];
+        out[p].kind = st.kind.load(std::memory_order_relaxed);
+        for (size_t k = 0; k < kChannels; ++k) {
+            out[p].in[k] = st.in[k].load(std::memory_order_relaxed);
+            out[p].out[k] = st.out[k].load(std::memory_order_relaxed);
+            out[p].suppressed[k] = st.suppressed[k].load(std::memory_order_relaxed);
+        }
+    }
+    return out;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Core/DeckState.hpp"
+#include "Core/Serial/InputSmoother.hpp"
+
+// Tipi di stadio della catena di filtri dei fader
+enum class FilterStageKind : uint8_t {
+    Smooth,     // InputSmoother: EMA (con deadband) o One-Euro, parametri per fader
+    MinDelta    // isteresi: l'uscita si muove solo se il campione si allontana di almeno "counts"
+};
+
+const char* FilterStageName(FilterStageKind k);
+
+struct FilterStageConfig {
+    FilterStageKind kind = FilterStageKind::Smooth;
+    std::array<int, DeckState::kSliders> counts{};   // MinDelta: soglia per fader, in conteggi
+};
+
+// Soglia di default dello stadio min_delta: ~1% della corsa (0..1023)
+inline constexpr int kDefaultMinDeltaCounts = 10;
+
+// Catena di default: smoothing, poi variazione minima dell'1% prima di muovere il volume
+std::vector<FilterStageConfig> DefaultFilterStages();
+
+// Configurazione della catena di un deck (blocchi "filters" + "smoothing")
+struct FilterChainConfig {
+    static constexpr size_t kMaxStages = 4;
+
+    std::vector<FilterStageConfig> stages = DefaultFilterStages();   // in ordine; vuota = valori grezzi
+    std::array<FaderSmoothingParams, DeckState::kSliders> smoothing{};  // per lo stadio Smooth (al più uno)
+};
+
+// Contatori di uno stadio, per fader (snapshot)
+struct FilterStageStats {
+    FilterStageKind kind = FilterStageKind::Smooth;
+    std::array<uint64_t, DeckState::kSliders> in{};          // campioni entrati
+    std::array<uint64_t, DeckState::kSliders> out{};         // campioni che hanno cambiato l'uscita
+    std::array<uint64_t, DeckState::kSliders> suppressed{};  // ingresso cambiato, uscita ferma
+};
+
+// Catena di filtri dei fader: l'unico punto in cui un campione grezzo diventa
+// il valore pubblicato (e quindi il volume applicato). Ogni stadio conta
+// campioni entrati, uscite cambiate e cambi soppressi, per fader: quanti
+// aggiornamenti di volume risparmia ogni stadio si legge da qui.
+// apply/configure/reset: solo dal thread di IO; stats(): da qualsiasi thread.
+class FaderFilterChain {
+public:
+    static constexpr size_t kChannels = DeckState::kSliders;
+    static constexpr size_t kMaxStages = FilterChainConfig::kMaxStages;
+
+    FaderFilterChain();
+
+    // Adotta una nuova catena. Gli stadi che restano dello stesso tipo nella
+    // stessa posizione mantengono stato e contatori; gli altri ripartono da zero.
+    void configure(const FilterChainConfig& cfg);
+
+    // Stato dei filtri (non i contatori): il prossimo campione "aggancia"
+    void reset();
+
+    // Filtra s.sliders in-place, un campione alla volta. dt = periodo nominale (vedi InputSmoother)
+    void apply(DeckState& s, float dt);
+
+    std::vector<FilterStageStats> stats() const;
+
+private:
+    using Counters = std::array<std::atomic<uint64_t>, kChannels>;
+
+    struct Stage {
+        std::atomic<FilterStageKind> kind{ FilterStageKind::Smooth };
+        std::array<int, kChannels> counts{};
+        std::array<int, kChannels> lastIn{}, lastOut{};
+        bool primed = false;   // tutti i fader arrivano in ogni campione: un solo flag per stadio
+
+        // unico scrittore (thread di IO): incremento senza read-modify-write atomico
+        Counters in{}, out{}, suppressed{};
+    };
+
+    static void Bump(std::atomic<uint64_t>& c) { c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    static void ClearCounters(Stage& st);
+
+    std::array<Stage, kMaxStages> m_stages;
+    std::atomic<size_t> m_count{ 0 };
+    InputSmoother m_smoother;   // stato dello stadio Smooth
+};
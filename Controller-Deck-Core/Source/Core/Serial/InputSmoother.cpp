@@ -1,53 +1,116 @@
 #include "Core/Serial/InputSmoother.hpp"
+#include <cmath>
+
+namespace {
+    // L'uscita intera cambia solo se il valore filtrato si allontana di più di così:
+    // evita lo sfarfallio di ±1 quando il filtrato sta a cavallo di x.5
+    // (dopo un cambio serve tornare indietro di 0.8 conteggi per invertire)
+    constexpr float kOutHysteresis = 0.9f;
+
+    inline float LowpassAlpha(float cutoffHz, float dt) {
+        const float tau = 1.0f / (6.2831853f * cutoffHz);
+        return 1.0f / (1.0f + tau / dt);
+    }
+}
+
+void SmoothChannels(int* __restrict samples, int* __restrict lastFiltered, int* __restrict primed,
+    const int* __restrict deadband, const int* __restrict alphaQ15, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        const int raw = samples[i];
+
+        // primo campione: "aggancia" per evitare salto iniziale (delta = 0 -> out = raw)
+        const int last = (lastFiltered[i] & primed[i]) | (raw & ~primed[i]);
+
+        // 1) DEADBAND (in conteggi): ignora micro variazioni, a maschera invece che a ramo
+        const int delta = raw - last;
+        const int ad = delta < 0 ? -delta : delta;
+        const int step = delta & -static_cast<int>(ad > deadband[i]);
+
+        // 2) SMOOTH (EMA): new = last + alpha*step, in Q15 arrotondato (shift aritmetico)
+        const int out = last + ((alphaQ15[i] * step + (1 << 14)) >> 15);
+        samples[i] = out;
+        lastFiltered[i] = out;
+        primed[i] = -1;
+    }
+}
 
 InputSmoother::InputSmoother() {
     setParamsAll(FaderSmoothingParams{}); // default
 }
 
 void InputSmoother::setParams(int i, FaderSmoothingParams p) {
-    if (i < 0 || i >= 5) return;
-    if (p.deadband_counts < 0) p.deadband_counts = 0;
-    if (p.alpha < 0.f) p.alpha = 0.f;
-    if (p.alpha > 1.f) p.alpha = 1.f;
-    m_params[static_cast<size_t>(i)] = p;
+    if (i < 0 || i >= static_cast<int>(kChannels)) return;
+    const size_t k = static_cast<size_t>(i);
+    m_deadband[k] = std::max(p.deadband_counts, 0);
+    m_alphaQ15[k] = AlphaToQ15(p.alpha);
+
+    auto& c = m_euro[k];
+    c.minCutoff = std::max(p.min_cutoff, 0.001f);
+    c.beta = std::max(p.beta, 0.f);
+    c.dCutoff = std::max(p.d_cutoff, 0.001f);
+
+    // cambio di modo: il canale riparte agganciando il prossimo campione
+    if (p.mode != m_mode[k]) {
+        m_mode[k] = p.mode;
+        m_primed[k] = 0;
+        c.primed = false;
+    }
+    m_euroCount = 0;
+    for (size_t j = 0; j < kChannels; ++j)
+        if (m_mode[j] == SmoothingMode::OneEuro) m_euroIdx[m_euroCount++] = static_cast<uint16_t>(j);
 }
 
 void InputSmoother::setParamsAll(FaderSmoothingParams p) {
-    for (int i = 0; i < 5; ++i) setParams(i, p);
+    for (int i = 0; i < static_cast<int>(kChannels); ++i) setParams(i, p);
 }
 
 void InputSmoother::reset() {
-    m_hasLast.fill(false);
+    m_primed.fill(0);
     m_lastFiltered.fill(0);
+    for (auto& c : m_euro) c.primed = false;
 }
 
-void InputSmoother::apply(DeckState& s) {
-    for (int i = 0; i < 5; ++i) {
-        const auto  raw = s.sliders[i];
-        auto& lastF = m_lastFiltered[static_cast<size_t>(i)];
-        auto& has = m_hasLast[static_cast<size_t>(i)];
-        const auto& prm = m_params[static_cast<size_t>(i)];
-
-        if (!has) {
-            // primo campione: aggancia per evitare salto iniziale
-            lastF = raw;
-            has = true;
-            s.sliders[i] = raw;
-            continue;
-        }
-
-        // 1) DEADBAND (in conteggi): ignora micro variazioni
-        const int delta = raw - lastF;
-        const int ad = delta >= 0 ? delta : -delta;
-        const int step = (ad <= prm.deadband_counts) ? 0 : delta;
-        const int target = lastF + step;
-
-        // 2) SMOOTH (EMA): new = last + alpha*(target-last)
-        const float lf = static_cast<float>(lastF);
-        const float tg = static_cast<float>(target);
-        const float nf = lf + prm.alpha * (tg - lf);
-
-        lastF = static_cast<int>(nf + (nf >= 0 ? 0.5f : -0.5f)); // arrotonda
-        s.sliders[i] = lastF;
+void InputSmoother::applyOneEuro(OneEuroChannel& c, int& sample, float dt) {
+    const float raw = static_cast<float>(sample);
+    if (!c.primed) {
+        // primo campione: aggancia, come l'EMA
+        c.x = raw;
+        c.dx = 0.f;
+        c.out = sample;
+        c.primed = true;
+        return;
+    }
+
+    if (dt > 0.f) {
+        // velocità stimata, a sua volta filtrata (taglio fisso d_cutoff)
+        const float v = (raw - c.x) / dt;
+        c.dx += LowpassAlpha(c.dCutoff, dt) * (v - c.dx);
+
+        // taglio adattivo: basso a fader fermo, alto (quasi senza lag) in movimento
+        const float cutoff = c.minCutoff + c.beta * std::fabs(c.dx);
+        c.x += LowpassAlpha(cutoff, dt) * (raw - c.x);
+    }
+
+    if (std::fabs(c.x - static_cast<float>(c.out)) > kOutHysteresis)
+        c.out = static_cast<int>(std::lround(c.x));
+    sample = c.out;
+}
+
+void InputSmoother::apply(DeckState& s, float dt) {
+    if (m_euroCount == 0) {
+        SmoothChannels(s.sliders.data(), m_lastFiltered.data(), m_primed.data(),
+            m_deadband.data(), m_alphaQ15.data(), kChannels);
+        return;
+    }
+
+    // Canali misti: il kernel batch passa su tutti, poi i One-Euro riprendono il grezzo
+    const auto raw = s.sliders;
+    SmoothChannels(s.sliders.data(), m_lastFiltered.data(), m_primed.data(),
+        m_deadband.data(), m_alphaQ15.data(), kChannels);
+
+    for (size_t n = 0; n < m_euroCount; ++n) {
+        const size_t k = m_euroIdx[n];
+        s.sliders[k] = raw[k];
+        applyOneEuro(m_euro[k], s.sliders[k], dt);
     }
 }
@@ -1,19 +1,50 @@
 #pragma once
 #include <array>
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include "Core/DeckState.hpp"   // ha sliders[5], buttons[5]
+#include "Core/DeckState.hpp"   // ha sliders[kSliders], buttons[kButtons]
+
+enum class SmoothingMode {
+    Ema,       // deadband + EMA a coefficiente fisso
+    OneEuro    // One-Euro: taglio basso a fader fermo, si apre con la velocità
+};
 
 struct FaderSmoothingParams {
+    SmoothingMode mode = SmoothingMode::Ema;
+
+    // EMA
     int   deadband_counts = 2;   // min delta per accettare variazione (anti jitter)
     float alpha = 0.20f;         // 0..1, filtro EMA (0 = no movimento, 1 = nessun filtro)
+
+    // One-Euro (Casiez et al., 2012): taglio = min_cutoff + beta * |velocità|
+    float min_cutoff = 1.0f;     // Hz a fader fermo: più basso = meno jitter
+    float beta = 0.02f;          // Hz per conteggio/s: quanto si apre in movimento (più alto = meno lag)
+    float d_cutoff = 1.0f;       // Hz, filtro sulla velocità stimata
 };
 
+// Kernel batch: deadband + EMA su n canali in un solo passaggio, in virgola fissa
+// (alpha in Q15) e senza rami per canale: layout SoA, vettorizzabile dal compilatore.
+// Rispetto all'EMA float differisce di al massimo 1 conteggio (alpha arrotondato a
+// 1/32768, arrotondamento a metà verso l'alto); il bench SmootherKernel lo misura.
+//  - samples: 0..1023 (alpha * delta deve stare in 32 bit)
+//  - lastFiltered: ultimo valore filtrato di ogni canale (aggiornato)
+//  - primed: 0 = canale senza storia (aggancia il campione), -1 = con storia (aggiornato)
+//  - alphaQ15: 0..32768 per canale, vedi AlphaToQ15
+void SmoothChannels(int* __restrict samples, int* __restrict lastFiltered, int* __restrict primed,
+    const int* __restrict deadband, const int* __restrict alphaQ15, size_t n);
+
+constexpr int AlphaToQ15(float alpha) {
+    return static_cast<int>(std::clamp(alpha, 0.f, 1.f) * 32768.f + 0.5f);
+}
+
 class InputSmoother {
 public:
+    static constexpr size_t kChannels = DeckState::kSliders;
+
     InputSmoother();
 
-    // Imposta parametri per singolo fader (0..4)
+    // Imposta parametri per singolo fader (0..kChannels-1)
     void setParams(int index, FaderSmoothingParams p);
 
     // Imposta parametri uguali per tutti
@@ -22,11 +53,30 @@ public:
     // Reset dello stato interno (usa al cambio porta/boot)
     void reset();
 
-    // Applica deadband + smoothing IN-PLACE ai soli sliders
-    void apply(DeckState& s);
+    // Applica il filtro di ogni fader IN-PLACE ai soli sliders, un campione alla volta.
+    // dt = periodo di campionamento in secondi (velocità dei fader One-Euro): fisso,
+    // così la stessa sequenza di campioni dà sempre la stessa uscita.
+    void apply(DeckState& s, float dt);
 
 private:
-    std::array<int, 5>   m_lastFiltered{}; // ultimo valore filtrato
-    std::array<bool, 5>  m_hasLast{};
-    std::array<FaderSmoothingParams, 5> m_params;
+    // Stato e parametri EMA per canale in SoA, come li vuole SmoothChannels
+    std::array<int, kChannels>   m_lastFiltered{}; // ultimo valore filtrato
+    std::array<int, kChannels>   m_primed{};       // 0 = nessun campione ancora
+    std::array<int, kChannels>   m_deadband{};
+    std::array<int, kChannels>   m_alphaQ15{};
+
+    // Fader One-Euro: stato float (non arrotondato) + uscita con isteresi
+    struct OneEuroChannel {
+        float minCutoff = 1.0f, beta = 0.02f, dCutoff = 1.0f;
+        float x = 0.f;        // posizione filtrata
+        float dx = 0.f;       // velocità filtrata (conteggi/s)
+        int   out = 0;
+        bool  primed = false;
+    };
+    void applyOneEuro(OneEuroChannel& c, int& sample, float dt);
+
+    std::array<SmoothingMode, kChannels>  m_mode{};
+    std::array<OneEuroChannel, kChannels> m_euro{};
+    std::array<uint16_t, kChannels>       m_euroIdx{};   // canali One-Euro, i primi m_euroCount
+    size_t m_euroCount = 0;
 };
@@ -0,0 +1,94 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Framing a buffer fisso per lo stream seriale.
+// I byte vengono letti direttamente in writePtr()/writeSpace(), poi commit(n)
+// separa TUTTE le linee complete presenti e le passa come string_view
+// (valide solo durante la callback). Nessuna allocazione per frame.
+// Il residuo parziale (meno di una linea) viene riportato in testa al buffer.
+class LineFramer {
+public:
+    static constexpr size_t kCapacity = 4096;
+
+    explicit LineFramer(char delimiter = '\n') : m_delim(delimiter) {}
+
+    // Regione libera dove scrivere i prossimi byte (es. async_read_some)
+    char* writePtr() { return m_buf.data() + m_tail; }
+    size_t writeSpace() const { return kCapacity - m_tail; }
+
+    // Registra n byte appena scritti e invoca onFrame(std::string_view) per
+    // ogni frame completo (delimitatore escluso). Ritorna i frame emessi.
+    template <class Fn>
+    size_t commit(size_t n, Fn&& onFrame) {
+        m_tail += n;
+        size_t frames = 0;
+
+        while (m_scan < m_tail) {
+            const void* hit = std::memchr(m_buf.data() + m_scan, m_delim, m_tail - m_scan);
+            if (!hit) { m_scan = m_tail; break; }
+
+            const size_t pos = static_cast<size_t>(static_cast<const char*>(hit) - m_buf.data());
+            if (m_discard) {
+                // coda di una linea troppo lunga: la scartiamo fino al delimitatore
+                m_discard = false;
+            }
+            else {
+                onFrame(std::string_view(m_buf.data() + m_head, pos - m_head));
+                ++frames;
+            }
+            m_head = pos + 1;
+            m_scan = m_head;
+        }
+
+        compact();
+        return frames;
+    }
+
+    // Svuota il buffer (al cambio porta / riconnessione)
+    void reset() {
+        m_head = m_tail = m_scan = 0;
+        m_discard = false;
+    }
+
+    // Delimitatore corrente (modificabile solo dal thread che chiama commit)
+    char delimiter() const { return m_delim; }
+    void setDelimiter(char d) { m_delim = d; m_scan = m_head; }
+
+    // Numero di linee scartate perché più lunghe del buffer
+    uint64_t overflows() const { return m_overflows; }
+
+private:
+    void compact() {
+        if (m_head == m_tail) {
+            m_head = m_tail = m_scan = 0;
+            return;
+        }
+        if (m_head > 0) {
+            // sposta il residuo parziale in testa (tipicamente pochi byte)
+            const size_t len = m_tail - m_head;
+            std::memmove(m_buf.data(), m_buf.data() + m_head, len);
+            m_head = 0;
+            m_tail = len;
+            m_scan = len;
+            return;
+        }
+        if (m_tail == kCapacity) {
+            // buffer pieno senza delimitatore: linea troppo lunga, la scartiamo
+            ++m_overflows;
+            m_discard = true;
+            m_head = m_tail = m_scan = 0;
+        }
+    }
+
+    std::array<char, kCapacity> m_buf{};
+    size_t   m_head = 0;   // inizio del frame corrente
+    size_t   m_tail = 0;   // fine dei dati validi
+    size_t   m_scan = 0;   // da dove riprendere la ricerca del delimitatore
+    bool     m_discard = false;
+    char     m_delim;
+    uint64_t m_overflows = 0;
+};
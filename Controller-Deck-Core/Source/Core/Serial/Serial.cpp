@@ -1,68 +1,105 @@
 #include "Serial.hpp"
 #include <fmt/core.h>
 
-SerialReader::SerialReader(const std::string& port, unsigned int baud, LineCallback onLine)
-    : m_port(port), m_baud(baud), m_onLine(std::move(onLine)) {
+SerialReader::SerialReader(asio::io_context& io, const std::string& port, unsigned int baud, LineCallback onLine,
+    BatchCallback onBatchEnd, ErrorCallback onError)
+    : m_port(port), m_baud(baud), m_onLine(std::move(onLine)), m_onBatchEnd(std::move(onBatchEnd)), m_onError(std::move(onError)),
+    m_strand(asio::make_strand(io)) {
 }
 
 SerialReader::~SerialReader() { stop(); }
 
 void SerialReader::start() {
     if (m_running.exchange(true)) return;
+    m_serial = std::make_unique<asio::serial_port>(m_strand);
+}
+
+bool SerialReader::open(asio::error_code& ec) {
+    ec.clear();
+    if (!m_running) return false;
+
+    // Dopo un errore l'handle è ancora aperto ma inutilizzabile
+    if (m_serial->is_open()) {
+        asio::error_code ignored;
+        m_serial->close(ignored);
+    }
 
-    m_serial = std::make_unique<asio::serial_port>(m_io);
-    asio::error_code ec;
     m_serial->open(m_port, ec);
+    if (!ec) m_serial->set_option(asio::serial_port_base::baud_rate(m_baud), ec);
+    if (!ec) m_serial->set_option(asio::serial_port_base::character_size(8), ec);
+    if (!ec) m_serial->set_option(asio::serial_port_base::parity(asio::serial_port_base::parity::none), ec);
+    if (!ec) m_serial->set_option(asio::serial_port_base::stop_bits(asio::serial_port_base::stop_bits::one), ec);
+    if (!ec) m_serial->set_option(asio::serial_port_base::flow_control(asio::serial_port_base::flow_control::none), ec);
     if (ec) {
-        fmt::print("Errore apertura {}: {}\n", m_port, ec.message());
-        m_running = false;
-        return;
+        asio::error_code ignored;
+        m_serial->close(ignored);
+        return false;
     }
 
-    m_serial->set_option(asio::serial_port_base::baud_rate(m_baud));
-    m_serial->set_option(asio::serial_port_base::character_size(8));
-    m_serial->set_option(asio::serial_port_base::parity(asio::serial_port_base::parity::none));
-    m_serial->set_option(asio::serial_port_base::stop_bits(asio::serial_port_base::stop_bits::one));
-    m_serial->set_option(asio::serial_port_base::flow_control(asio::serial_port_base::flow_control::none));
-
+    m_framer.reset();
+    {
+        std::lock_guard<std::mutex> lk(m_mx);
+        m_reading = true;
+    }
     doRead();
-    m_thread = std::make_unique<std::thread>([this] { m_io.run(); });
     fmt::print("Seriale {} @ {} avviata.\n", m_port, m_baud);
+    return true;
 }
 
 void SerialReader::stop() {
     if (!m_running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lk(m_mx);
+        m_closePosted = true;
+    }
 
-    asio::post(m_io, [this] {
-        if (m_serial && m_serial->is_open()) {
+    // La chiusura gira sullo strand (serial_port non è thread-safe):
+    // la read in volo termina con operation_aborted e chiama readDone()
+    asio::post(m_strand, [this] {
+        if (m_serial->is_open()) {
             asio::error_code ignored;
             m_serial->cancel(ignored);
             m_serial->close(ignored);
         }
+        std::lock_guard<std::mutex> lk(m_mx);
+        m_closePosted = false;
+        m_cv.notify_all();
         });
 
-    if (m_thread && m_thread->joinable()) {
-        m_thread->join();
-    }
+    std::unique_lock<std::mutex> lk(m_mx);
+    m_cv.wait(lk, [this] { return !m_reading && !m_closePosted; });
+    lk.unlock();
+
     m_serial.reset();
-    m_thread.reset();
-    m_io.restart(); // pronto per un eventuale riavvio
+}
+
+void SerialReader::readDone() {
+    std::lock_guard<std::mutex> lk(m_mx);
+    m_reading = false;
+    m_cv.notify_all();
 }
 
 void SerialReader::doRead() {
-    if (!m_running) return;
-    asio::async_read_until(*m_serial, m_buffer, '\n',
+    if (!m_running) { readDone(); return; }
+    // Legge tutto ciò che è disponibile (fino allo spazio libero del framer)
+    m_serial->async_read_some(asio::buffer(m_framer.writePtr(), m_framer.writeSpace()),
         [this](const asio::error_code& ec, std::size_t bytes) {
             if (!ec) {
-                std::istream is(&m_buffer);
-                std::string line;
-                std::getline(is, line);
-                if (m_onLine) m_onLine(line);
+                m_lastReadAt = std::chrono::steady_clock::now();
+                m_framer.commit(bytes, [this](std::string_view line) {
+                    if (m_onLine) m_onLine(line);
+                    });
+                if (m_onBatchEnd) m_onBatchEnd();
                 doRead(); // continua
+                return;
             }
-            else if (ec != asio::error::operation_aborted) {
-                fmt::print("Errore IO: {}\n", ec.message());
-                stop();
+            // Con il reader ancora attivo anche operation_aborted è un errore del
+            // device (su Windows la rimozione USB interrompe così la ReadFile).
+            // niente stop() qui: siamo sul thread di IO, decide il proprietario
+            if (m_running) {
+                if (m_onError) m_onError(ec);
+                else fmt::print("Errore IO {}: {}\n", m_port, ec.message());
             }
+            readDone();   // ultimo accesso: da qui stop() può distruggere il reader
         });
 }
@@ -1,32 +1,75 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <functional>
-#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <atomic>
+#include <chrono>
 #include <asio.hpp>
+#include "Core/Serial/LineFramer.hpp"
 
 // Semplice reader di linee terminate da '\n'.
-// Chiama onLine(data) sul thread di IO interno.
+// Legge a blocchi nel LineFramer e chiama onLine(line) per ogni linea completa
+// su un thread dell'io_context condiviso (SerialIoPool). La string_view è valida
+// solo durante la callback. onBatchEnd (opzionale) viene chiamata alla fine di ogni lettura.
+// Tutte le handler della porta girano sul suo strand (executor()): anche con più
+// thread di IO le callback di uno stesso reader non corrono mai in parallelo.
 class SerialReader {
 public:
-    using LineCallback = std::function<void(const std::string&)>;
+    using LineCallback = std::function<void(std::string_view)>;
+    using BatchCallback = std::function<void()>;
+    // Errore di IO con porta ancora attiva (es. device scollegato): la catena di
+    // read è terminata e la porta va riaperta con open()
+    using ErrorCallback = std::function<void(const asio::error_code&)>;
+    using Executor = asio::strand<asio::io_context::executor_type>;
 
-    SerialReader(const std::string& port, unsigned int baud, LineCallback onLine);
+    // io deve essere in esecuzione (run) e sopravvivere al reader
+    SerialReader(asio::io_context& io, const std::string& port, unsigned int baud, LineCallback onLine,
+        BatchCallback onBatchEnd = nullptr, ErrorCallback onError = nullptr);
     ~SerialReader();
 
+    // Abilita il reader. La porta si apre con open(), da chiamare sullo strand.
     void start();
+    // Chiude la porta e attende che nessuna handler sia più in volo.
+    // Non va chiamata dal thread di IO (dalle callback).
     void stop();
 
+    // (Ri)apre la porta e avvia la lettura. SOLO sullo strand (callback o
+    // handler postate su executor()). false se chiuso da stop() o apertura fallita.
+    bool open(asio::error_code& ec);
+
+    const Executor& executor() const { return m_strand; }
+
+    // Cambia il delimitatore di frame ('\n' testo, '\0' COBS).
+    // Da chiamare SOLO dal thread di IO, cioè dalla callback onLine.
+    void setDelimiter(char d) { m_framer.setDelimiter(d); }
+
+    // Linee scartate perché più lunghe del buffer (solo dal thread di IO)
+    uint64_t overflows() const { return m_framer.overflows(); }
+
+    // Istante di completamento della read in corso di consegna (solo dal thread di IO)
+    std::chrono::steady_clock::time_point lastReadAt() const { return m_lastReadAt; }
+
 private:
     void doRead();
+    void readDone();   // la catena di read è terminata (errore o stop)
 
     std::string m_port;
     unsigned int m_baud;
     LineCallback m_onLine;
+    BatchCallback m_onBatchEnd;
+    ErrorCallback m_onError;
 
-    asio::io_context m_io;
+    Executor m_strand;
     std::unique_ptr<asio::serial_port> m_serial;
-    std::unique_ptr<std::thread> m_thread;
-    std::atomic<bool> m_running{ false };
-    asio::streambuf m_buffer;
+    std::atomic<bool> m_running{ false };   // tra start() e stop()
+
+    // read in volo: stop() attende che la catena sia terminata
+    std::mutex m_mx;
+    std::condition_variable m_cv;
+    bool m_reading = false;
+    bool m_closePosted = false;
+    LineFramer m_framer;
+    std::chrono::steady_clock::time_point m_lastReadAt{};
 };
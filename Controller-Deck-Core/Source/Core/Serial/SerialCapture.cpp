@@ -0,0 +1,337 @@
+#include "Core/Serial/SerialCapture.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+    constexpr unsigned char kMagic[4] = { 'C', 'D', 'C', 'P' };
+    constexpr unsigned char kVersion = 1;
+
+    // Il file cresce a blocchi: 1 MiB, poi raddoppia fino a passi di 64 MiB
+    constexpr size_t kInitialSize = size_t{ 1 } << 20;
+    constexpr size_t kMaxGrowStep = size_t{ 64 } << 20;
+
+    constexpr size_t kMaxVarint = 10;
+
+    // Regione di file mappata (comune a writer e reader)
+    struct MappedRegion {
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE section = nullptr;
+#else
+        int fd = -1;
+#endif
+        unsigned char* view = nullptr;
+        size_t size = 0;
+    };
+
+#ifdef _WIN32
+    std::wstring Widen(const std::string& s) {
+        if (s.empty()) return {};
+        const int n = MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), nullptr, 0);
+        std::wstring w(static_cast<size_t>(n), L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), w.data(), n);
+        return w;
+    }
+
+    void Unmap(MappedRegion& m) {
+        if (m.view) UnmapViewOfFile(m.view);
+        if (m.section) CloseHandle(m.section);
+        m.view = nullptr;
+        m.section = nullptr;
+    }
+
+    bool Map(MappedRegion& m, size_t size, bool writable) {
+        const DWORD hi = static_cast<DWORD>(static_cast<uint64_t>(size) >> 32);
+        const DWORD lo = static_cast<DWORD>(size & 0xFFFFFFFFu);
+        // in scrittura la sezione più grande del file lo estende
+        m.section = CreateFileMappingW(m.file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, hi, lo, nullptr);
+        if (!m.section) return false;
+        m.view = static_cast<unsigned char*>(MapViewOfFile(m.section, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+        if (!m.view) { Unmap(m); return false; }
+        m.size = size;
+        return true;
+    }
+
+    bool CreateForWrite(MappedRegion& m, const std::string& path, bool overwrite, std::string& err) {
+        m.file = CreateFileW(Widen(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+            overwrite ? CREATE_ALWAYS : CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m.file == INVALID_HANDLE_VALUE) {
+            err = GetLastError() == ERROR_FILE_EXISTS ? "file_exists" : "cannot_create_file";
+            return false;
+        }
+        if (!Map(m, kInitialSize, true)) {
+            CloseHandle(m.file);
+            m.file = INVALID_HANDLE_VALUE;
+            err = "cannot_map_file";
+            return false;
+        }
+        return true;
+    }
+
+    bool Grow(MappedRegion& m, size_t size) {
+        Unmap(m);
+        return Map(m, size, true);
+    }
+
+    void CloseWritten(MappedRegion& m, size_t used) {
+        if (m.view) FlushViewOfFile(m.view, used);
+        Unmap(m);
+        if (m.file == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(used);
+        if (SetFilePointerEx(m.file, end, nullptr, FILE_BEGIN)) SetEndOfFile(m.file);
+        CloseHandle(m.file);
+        m.file = INVALID_HANDLE_VALUE;
+    }
+
+    bool OpenForRead(MappedRegion& m, const std::string& path, std::string& err) {
+        m.file = CreateFileW(Widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m.file == INVALID_HANDLE_VALUE) { err = "cannot_open_file"; return false; }
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(m.file, &size) || size.QuadPart < static_cast<LONGLONG>(SerialCaptureReader::kHeaderSize) ||
+            !Map(m, static_cast<size_t>(size.QuadPart), false)) {
+            CloseHandle(m.file);
+            m.file = INVALID_HANDLE_VALUE;
+            err = "bad_capture";
+            return false;
+        }
+        return true;
+    }
+
+    void CloseRead(MappedRegion& m) {
+        Unmap(m);
+        if (m.file != INVALID_HANDLE_VALUE) CloseHandle(m.file);
+        m.file = INVALID_HANDLE_VALUE;
+    }
+#else
+    bool Map(MappedRegion& m, size_t size, bool writable) {
+        void* p = ::mmap(nullptr, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, m.fd, 0);
+        if (p == MAP_FAILED) return false;
+        m.view = static_cast<unsigned char*>(p);
+        m.size = size;
+        return true;
+    }
+
+    void Unmap(MappedRegion& m) {
+        if (m.view) ::munmap(m.view, m.size);
+        m.view = nullptr;
+    }
+
+    bool CreateForWrite(MappedRegion& m, const std::string& path, bool overwrite, std::string& err) {
+        m.fd = ::open(path.c_str(), O_RDWR | O_CREAT | (overwrite ? O_TRUNC : O_EXCL) | O_CLOEXEC, 0644);
+        if (m.fd < 0) { err = errno == EEXIST ? "file_exists" : "cannot_create_file"; return false; }
+        if (::ftruncate(m.fd, static_cast<off_t>(kInitialSize)) != 0 || !Map(m, kInitialSize, true)) {
+            ::close(m.fd);
+            m.fd = -1;
+            err = "cannot_map_file";
+            return false;
+        }
+        return true;
+    }
+
+    bool Grow(MappedRegion& m, size_t size) {
+        Unmap(m);
+        return ::ftruncate(m.fd, static_cast<off_t>(size)) == 0 && Map(m, size, true);
+    }
+
+    void CloseWritten(MappedRegion& m, size_t used) {
+        Unmap(m);
+        if (m.fd < 0) return;
+        (void)::ftruncate(m.fd, static_cast<off_t>(used));
+        ::close(m.fd);
+        m.fd = -1;
+    }
+
+    bool OpenForRead(MappedRegion& m, const std::string& path, std::string& err) {
+        m.fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (m.fd < 0) { err = "cannot_open_file"; return false; }
+        struct stat sb{};
+        if (::fstat(m.fd, &sb) != 0 || sb.st_size < static_cast<off_t>(SerialCaptureReader::kHeaderSize) ||
+            !Map(m, static_cast<size_t>(sb.st_size), false)) {
+            ::close(m.fd);
+            m.fd = -1;
+            err = "bad_capture";
+            return false;
+        }
+        return true;
+    }
+
+    void CloseRead(MappedRegion& m) {
+        Unmap(m);
+        if (m.fd >= 0) ::close(m.fd);
+        m.fd = -1;
+    }
+#endif
+
+    size_t PutVarint(unsigned char* p, uint64_t v) {
+        size_t n = 0;
+        while (v >= 0x80) {
+            p[n++] = static_cast<unsigned char>(v | 0x80);
+            v >>= 7;
+        }
+        p[n++] = static_cast<unsigned char>(v);
+        return n;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Writer
+// -----------------------------------------------------------------------------
+struct SerialCaptureWriter::Mapping : MappedRegion {};
+
+SerialCaptureWriter::SerialCaptureWriter() = default;
+
+SerialCaptureWriter::~SerialCaptureWriter() { close(); }
+
+bool SerialCaptureWriter::open(const std::string& path, std::string& err, bool overwrite) {
+    close();
+    auto map = std::make_unique<Mapping>();
+    if (!CreateForWrite(*map, path, overwrite, err)) return false;
+
+    const auto unixUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    unsigned char* h = map->view;
+    std::memcpy(h, kMagic, sizeof(kMagic));
+    h[4] = kVersion;
+    h[5] = h[6] = h[7] = 0;
+    for (int i = 0; i < 8; ++i) h[8 + i] = static_cast<unsigned char>(static_cast<uint64_t>(unixUs) >> (8 * i));
+
+    m_map = std::move(map);
+    m_path = path;
+    m_used = SerialCaptureReader::kHeaderSize;
+    m_lastRead = Clock::now();
+    m_bytes.store(m_used, std::memory_order_relaxed);
+    m_frames.store(0, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void SerialCaptureWriter::close() {
+    if (!m_map) return;
+    CloseWritten(*m_map, m_used);
+    m_map.reset();
+}
+
+bool SerialCaptureWriter::reserve(size_t n) {
+    if (!m_map) return false;
+    if (m_used + n <= m_map->size) return true;
+
+    size_t size = m_map->size;
+    while (m_used + n > size) size += std::min(size, kMaxGrowStep);
+    if (Grow(*m_map, size)) return true;
+
+    // mappatura persa: si chiude quel che c'è, i record successivi sono contati come persi
+    CloseWritten(*m_map, m_used);
+    m_map.reset();
+    return false;
+}
+
+void SerialCaptureWriter::putTag(uint64_t value, CaptureRecordKind kind) {
+    m_used += PutVarint(m_map->view + m_used, (value << 2) | static_cast<uint64_t>(kind));
+}
+
+void SerialCaptureWriter::recordOpen(uint8_t protocol) {
+    if (!reserve(kMaxVarint)) { m_dropped.fetch_add(1, std::memory_order_relaxed); return; }
+    putTag(protocol, CaptureRecordKind::Open);
+    m_bytes.store(m_used, std::memory_order_relaxed);
+}
+
+void SerialCaptureWriter::recordRead(Clock::time_point at) {
+    if (!reserve(kMaxVarint)) { m_dropped.fetch_add(1, std::memory_order_relaxed); return; }
+    // tempi monotoni: una read non può precedere la precedente
+    if (at < m_lastRead) at = m_lastRead;
+    // in ns: il replay ricostruisce gli stessi intervalli del vivo (il debounce confronta differenze di tempo)
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(at - m_lastRead).count();
+    putTag(static_cast<uint64_t>(ns), CaptureRecordKind::Read);
+    m_lastRead = at;
+    m_bytes.store(m_used, std::memory_order_relaxed);
+}
+
+void SerialCaptureWriter::recordFrame(std::string_view frame) {
+    if (frame.empty()) return;   // il tag 0 è riservato alla fine dei dati
+    if (!reserve(kMaxVarint + frame.size())) { m_dropped.fetch_add(1, std::memory_order_relaxed); return; }
+    putTag(frame.size(), CaptureRecordKind::Frame);
+    std::memcpy(m_map->view + m_used, frame.data(), frame.size());
+    m_used += frame.size();
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    m_bytes.store(m_used, std::memory_order_relaxed);
+}
+
+void SerialCaptureWriter::recordOverflow() {
+    if (!reserve(kMaxVarint)) { m_dropped.fetch_add(1, std::memory_order_relaxed); return; }
+    putTag(0, CaptureRecordKind::Overflow);
+    m_bytes.store(m_used, std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------------
+// Reader
+// -----------------------------------------------------------------------------
+struct SerialCaptureReader::Mapping : MappedRegion {};
+
+SerialCaptureReader::SerialCaptureReader() = default;
+
+SerialCaptureReader::~SerialCaptureReader() { close(); }
+
+bool SerialCaptureReader::open(const std::string& path, std::string& err) {
+    close();
+    auto map = std::make_unique<Mapping>();
+    if (!OpenForRead(*map, path, err)) return false;
+
+    const unsigned char* h = map->view;
+    if (std::memcmp(h, kMagic, sizeof(kMagic)) != 0 || h[4] != kVersion) {
+        CloseRead(*map);
+        err = "bad_capture";
+        return false;
+    }
+    m_startUnixUs = 0;
+    for (int i = 0; i < 8; ++i) m_startUnixUs |= static_cast<uint64_t>(h[8 + i]) << (8 * i);
+
+    m_data = map->view;
+    m_size = map->size;
+    m_pos = kHeaderSize;
+    m_map = std::move(map);
+    return true;
+}
+
+void SerialCaptureReader::close() {
+    if (!m_map) return;
+    CloseRead(*m_map);
+    m_map.reset();
+    m_data = nullptr;
+    m_size = 0;
+    m_pos = kHeaderSize;
+}
+
+bool SerialCaptureReader::next(CaptureRecord& r) {
+    uint64_t tag = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (m_pos >= m_size || shift >= 64) return false;
+        const unsigned char b = m_data[m_pos++];
+        tag |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    if (tag == 0) return false;   // coda preallocata e mai scritta (chiusura mancata)
+
+    r.kind = static_cast<CaptureRecordKind>(tag & 3);
+    r.value = tag >> 2;
+    r.data = {};
+    if (r.kind == CaptureRecordKind::Frame) {
+        if (r.value > m_size - m_pos) return false;
+        r.data = std::string_view(reinterpret_cast<const char*>(m_data + m_pos), static_cast<size_t>(r.value));
+        m_pos += static_cast<size_t>(r.value);
+    }
+    return true;
+}
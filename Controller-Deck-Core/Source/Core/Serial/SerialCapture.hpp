@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Cattura della seriale su file: ciò che il framer ha consegnato a SerialController,
+// con gli istanti delle read, per riprodurlo identico (SerialController::replay).
+//
+// Formato (little-endian, append-only):
+//   header  16 byte: "CDCP", versione (1), 3 byte riservati, avvio in µs Unix (uint64)
+//   record  varint tag = (valore << 2) | tipo, seguito dal payload del tipo:
+//     Frame    valore = lunghezza, poi i byte del frame (mai vuoto)
+//     Read     valore = ns dalla Read precedente (o dall'apertura della cattura);
+//              i Frame che seguono arrivano da questa read
+//     Open     valore = protocollo (DeckProtocol): porta (ri)aperta o cattura avviata, lo stato riparte
+//     Overflow il framer ha scartato una linea troppo lunga
+// Il file cresce a blocchi preallocati e mappati in memoria; alla chiusura viene
+// troncato alla parte scritta. Dopo un crash la coda resta a zero: un tag 0
+// (Frame vuoto, mai scritto) segna la fine dei dati.
+enum class CaptureRecordKind : uint8_t { Frame, Read, Open, Overflow };
+
+struct CaptureRecord {
+    CaptureRecordKind kind = CaptureRecordKind::Frame;
+    uint64_t value = 0;            // vedi formato
+    std::string_view data;         // solo Frame: valido finché il reader è aperto
+};
+
+// Scrittore: un solo thread (quello di IO del deck). I contatori si leggono da qualsiasi thread.
+class SerialCaptureWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    SerialCaptureWriter();
+    ~SerialCaptureWriter();   // close()
+
+    SerialCaptureWriter(const SerialCaptureWriter&) = delete;
+    SerialCaptureWriter& operator=(const SerialCaptureWriter&) = delete;
+
+    // Crea il file. Se esiste già: "file_exists", salvo overwrite (solo per percorsi
+    // scelti da chi lancia il processo: bench, emulatore). false + err se non si può creare o mappare.
+    bool open(const std::string& path, std::string& err, bool overwrite = false);
+    // Tronca il file alla parte scritta e lo chiude. Idempotente.
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+
+    void recordOpen(uint8_t protocol);
+    void recordRead(Clock::time_point at);
+    void recordFrame(std::string_view frame);
+    void recordOverflow();
+
+    const std::string& path() const { return m_path; }
+    uint64_t bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+    uint64_t frames() const { return m_frames.load(std::memory_order_relaxed); }
+    // Record persi (file non più estendibile: disco pieno o errore di mapping)
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Mapping;
+
+    bool reserve(size_t n);   // garantisce n byte liberi nella mappatura
+    void putTag(uint64_t value, CaptureRecordKind kind);
+
+    std::unique_ptr<Mapping> m_map;
+    std::string m_path;
+    size_t m_used = 0;
+    Clock::time_point m_lastRead{};
+
+    std::atomic<uint64_t> m_bytes{ 0 };
+    std::atomic<uint64_t> m_frames{ 0 };
+    std::atomic<uint64_t> m_dropped{ 0 };
+};
+
+// Lettore: mappa il file in sola lettura e lo scorre record per record
+class SerialCaptureReader {
+public:
+    SerialCaptureReader();
+    ~SerialCaptureReader();
+
+    SerialCaptureReader(const SerialCaptureReader&) = delete;
+    SerialCaptureReader& operator=(const SerialCaptureReader&) = delete;
+
+    // false + err se il file manca o non è una cattura valida
+    bool open(const std::string& path, std::string& err);
+    void close();
+
+    // Record successivo. false a fine dati (o su un record troncato).
+    bool next(CaptureRecord& r);
+    void rewind() { m_pos = kHeaderSize; }
+
+    uint64_t startUnixUs() const { return m_startUnixUs; }
+    size_t size() const { return m_size; }
+
+    static constexpr size_t kHeaderSize = 16;
+
+private:
+    struct Mapping;
+
+    std::unique_ptr<Mapping> m_map;
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_pos = kHeaderSize;
+    uint64_t m_startUnixUs = 0;
+};
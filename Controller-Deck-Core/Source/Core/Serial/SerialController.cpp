@@ -1,7 +1,29 @@
 #include "Core/Serial/SerialController.hpp"
+#include <algorithm>
+#include <thread>
 
-SerialController::SerialController(const std::string& port, unsigned int baud)
-    : m_port(port), m_baud(baud) {
+const char* DeckProtocolName(DeckProtocol p) {
+    switch (p) {
+    case DeckProtocol::Text:   return "text";
+    case DeckProtocol::Binary: return "binary";
+    default:                   return "auto";
+    }
+}
+
+const char* SerialLinkStateName(SerialLinkState s) {
+    switch (s) {
+    case SerialLinkState::Connecting:   return "connecting";
+    case SerialLinkState::Connected:    return "connected";
+    case SerialLinkState::Reconnecting: return "reconnecting";
+    default:                            return "stopped";
+    }
+}
+
+SerialController::SerialController(asio::io_context& io, const std::string& port, unsigned int baud, DeckStateStore& store)
+    : m_io(io), m_port(port), m_baud(baud), m_store(store),
+    m_rng(static_cast<std::minstd_rand::result_type>(std::hash<std::string>{}(port) ^
+        static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count()))) {
+    m_batch.reserve(64);   // una read normale porta pochi frame: niente allocazioni nel caso comune
 }
 
 SerialController::~SerialController() { stop(); }
@@ -9,28 +31,394 @@ SerialController::~SerialController() { stop(); }
 void SerialController::start() {
     if (m_reader) return;
 
+    m_stopping = false;
+    m_retryAttempt = 0;
+    m_everConnected = false;
+
     // Crea il SerialReader con callback che parsea e aggiorna lo store
-    m_reader = std::make_unique<SerialReader>(m_port, m_baud,
-        [this](const std::string& line) {
-            if (auto st = ParseDeckLine(line)) {
-                if (m_store.updateIfChanged(*st, /*sliderThreshold*/ 2)) {
-                    // Log minimale ogni cambiamento
-                    const auto s = m_store.get();
-                    fmt::print("BTN mask={}  SLD=[{}, {}, {}, {}, {}]\n",
-                        s.buttonsMask(),
-                        s.sliders[0], s.sliders[1], s.sliders[2], s.sliders[3], s.sliders[4]);
-                }
-            }
-            else {
-                // linea malformata: ignora (puoi aggiungere un contatore errori)
-            }
-        });
+    m_reader = std::make_unique<SerialReader>(m_io, m_port, m_baud,
+        [this](std::string_view frame) { onReaderFrame(frame); },
+        [this] { onReaderBatchEnd(); },
+        [this](const asio::error_code& ec) { onLinkError(ec); });
+    m_retryTimer = std::make_unique<asio::steady_timer>(m_reader->executor());
 
     m_reader->start();
+    setLink(SerialLinkState::Connecting);
+
+    // Anche il primo tentativo gira sullo strand: start() non attende l'apertura
+    beginOp();
+    asio::post(m_reader->executor(), [this] {
+        if (!m_stopping) tryOpen();
+        endOp();
+        });
 }
 
 void SerialController::stop() {
     if (!m_reader) return;
+    m_stopping = true;
+
+    // Stesso strand e ordine FIFO: il timer è annullato prima che il reader chiuda.
+    // Da qui in poi nessun tentativo riapre la porta (m_stopping).
+    beginOp();
+    asio::post(m_reader->executor(), [this] {
+        m_retryTimer->cancel();
+        endOp();
+        });
     m_reader->stop();
+
+    {
+        std::unique_lock<std::mutex> lk(m_opsMx);
+        m_opsCv.wait(lk, [this] { return m_ops == 0; });
+    }
+    m_retryTimer.reset();
     m_reader.reset();
+    setLink(SerialLinkState::Stopped);
+}
+
+SerialStats SerialController::stats() const {
+    SerialStats s;
+    s.protocol = m_protocol.load(std::memory_order_relaxed);
+    s.link = m_link.load(std::memory_order_acquire);
+    s.reconnects = m_reconnects.load(std::memory_order_relaxed);
+    s.frames = m_frames.load(std::memory_order_relaxed);
+    s.parseErrors = m_parseErrors.load(std::memory_order_relaxed);
+    s.crcErrors = m_crcErrors.load(std::memory_order_relaxed);
+    s.seqGaps = m_seqGaps.load(std::memory_order_relaxed);
+    s.coalesced = m_coalesced.load(std::memory_order_relaxed);
+    s.backlogPeak = m_backlogPeak.load(std::memory_order_relaxed);
+    s.edgeDrops = m_edges ? m_edges->dropped() : 0;
+    return s;
+}
+
+void SerialController::onReaderFrame(std::string_view frame) {
+    if (frame.empty()) return;
+    if (!m_inBatch) {
+        m_inBatch = true;
+        m_readAt = m_reader->lastReadAt();
+        if (m_capture) m_capture->recordRead(m_readAt);
+    }
+    if (m_capture) m_capture->recordFrame(frame);
+    onFrame(frame);
+}
+
+void SerialController::onReaderBatchEnd() {
+    const uint64_t ovf = m_reader->overflows();
+    if (ovf != m_lastOverflows) {
+        m_lastOverflows = ovf;
+        if (m_capture) m_capture->recordOverflow();
+        onOverflow();
+    }
+    onBatchEnd();
+}
+
+void SerialController::onFrame(std::string_view frame) {
+    if (frame.empty()) return; // delimitatori consecutivi (es. 0x00 di sincronizzazione)
+
+    const auto proto = m_protocol.load(std::memory_order_relaxed);
+
+    // Le linee testuali non contengono mai 0x00: se compare durante il rilevamento,
+    // il device parla binario. A protocollo testo già agganciato è solo rumore di linea.
+    if (proto == DeckProtocol::Auto && frame.find('\0') != std::string_view::npos) {
+        switchProtocol(DeckProtocol::Binary);
+        return;
+    }
+
+    if (proto == DeckProtocol::Binary) handleBinary(frame);
+    else handleText(frame, proto == DeckProtocol::Auto);
+}
+
+void SerialController::handleText(std::string_view line, bool detecting) {
+    if (auto st = ParseDeckLine(line)) {
+        if (detecting) switchProtocol(DeckProtocol::Text);
+        m_badStreak = 0;
+        accept(*st, false);
+        return;
+    }
+
+    m_parseErrors.fetch_add(1, std::memory_order_relaxed);
+    if (!detecting && ++m_badStreak >= kMaxBadStreak) switchProtocol(DeckProtocol::Auto);
+}
+
+void SerialController::handleBinary(std::string_view frame) {
+    DeckState st{};
+    uint8_t seq = 0;
+    if (ParseDeckFrame(frame, st, seq) != DeckFrameStatus::Ok) {
+        m_crcErrors.fetch_add(1, std::memory_order_relaxed);
+        if (++m_badStreak >= kMaxBadStreak) switchProtocol(DeckProtocol::Auto);
+        return;
+    }
+
+    if (m_hasSeq) {
+        const uint8_t gap = static_cast<uint8_t>(seq - m_lastSeq - 1);
+        if (gap) m_seqGaps.fetch_add(gap, std::memory_order_relaxed);
+    }
+    m_hasSeq = true;
+    m_lastSeq = seq;
+    m_badStreak = 0;
+    accept(st, true, seq);
+}
+
+void SerialController::setCapture(std::shared_ptr<SerialCaptureWriter> w) {
+    // Fermo: il prossimo tryOpen registrerà l'apertura
+    if (!m_reader) { m_capture = std::move(w); return; }
+
+    beginOp();
+    asio::post(m_reader->executor(), [this, w = std::move(w)]() mutable {
+        // la cattura parte dal protocollo già agganciato: il replay non deve rilevarlo
+        if (w) w->recordOpen(static_cast<uint8_t>(m_protocol.load(std::memory_order_relaxed)));
+        m_capture = std::move(w);
+        endOp();
+        });
+}
+
+ReplayStats SerialController::replay(SerialCaptureReader& cap, double speed, const std::atomic<bool>* cancel) {
+    using Clock = std::chrono::steady_clock;
+    ReplayStats rs;
+    if (m_reader) return rs;   // la porta è l'unica sorgente finché il controller è avviato
+
+    const auto start = Clock::now();
+    auto t = start;   // tempo della cattura, ancorato all'avvio del replay
+    resetLink();
+    setLink(SerialLinkState::Connected);
+
+    auto endBatch = [this] { if (m_inBatch) onBatchEnd(); };
+    cap.rewind();
+    CaptureRecord r;
+    rs.completed = true;
+    while (cap.next(r)) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) { rs.completed = false; break; }
+
+        switch (r.kind) {
+        case CaptureRecordKind::Read:
+            endBatch();   // dal vivo la read precedente si chiude appena consegnata
+            t += std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(r.value));
+            if (speed > 0.0)
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>((t - start) / speed));
+            m_readAt = t;
+            m_inBatch = true;
+            ++rs.reads;
+            break;
+        case CaptureRecordKind::Frame:
+            if (!m_inBatch) { m_readAt = t; m_inBatch = true; }
+            onFrame(r.data);
+            ++rs.frames;
+            break;
+        case CaptureRecordKind::Open:
+            endBatch();
+            resetLink();
+            if (r.value == static_cast<uint64_t>(DeckProtocol::Text) || r.value == static_cast<uint64_t>(DeckProtocol::Binary))
+                m_protocol.store(static_cast<DeckProtocol>(r.value), std::memory_order_relaxed);
+            break;
+        case CaptureRecordKind::Overflow:
+            onOverflow();
+            break;
+        }
+    }
+    endBatch();
+
+    rs.capturedSec = std::chrono::duration<double>(t - start).count();
+    rs.elapsedSec = std::chrono::duration<double>(Clock::now() - start).count();
+    setLink(SerialLinkState::Stopped);
+    return rs;
+}
+
+void SerialController::setFilters(const FilterChainConfig& cfg) {
+    std::lock_guard<std::mutex> lk(m_filtersMx);
+    m_nextFilters = cfg;
+    m_filtersDirty.store(true, std::memory_order_release);
+}
+
+void SerialController::accept(const DeckState& st, bool binary, uint8_t seq) {
+    m_batch.push_back(BatchFrame{ st, binary, seq, {} });
+}
+
+void SerialController::flushBatch() {
+    const size_t n = m_batch.size();
+    if (n == 0) return;
+
+    // L'ultimo frame è arrivato con la read; i precedenti un periodo prima l'uno
+    // dell'altro: in binario dal numero di sequenza (frame persi compresi), in testo
+    // dal periodo nominale
+    m_batch[n - 1].back = {};
+    for (size_t k = n - 1; k-- > 0;) {
+        const BatchFrame& next = m_batch[k + 1];
+        const auto seqStep = std::max(1, static_cast<int>(static_cast<uint8_t>(next.seq - m_batch[k].seq)));
+        m_batch[k].back = next.back + (next.binary && m_batch[k].binary
+            ? std::chrono::steady_clock::duration(kSamplePeriodBinary * seqStep)
+            : std::chrono::steady_clock::duration(kSamplePeriodText));
+    }
+
+    // Mai prima dell'ultimo frame già elaborato (read ravvicinate, clock del device
+    // più lento del nominale): in quel caso i frame si distribuiscono tra quello e la read
+    const bool squeeze = m_hasSampleAt && m_readAt - m_batch[0].back <= m_lastSampleAt;
+    const auto from = m_lastSampleAt;
+    const auto span = std::max(m_readAt - from, std::chrono::steady_clock::duration::zero());
+    for (size_t k = 0; k < n; ++k) {
+        const auto at = squeeze
+            ? from + span * static_cast<int64_t>(k + 1) / static_cast<int64_t>(n)
+            : m_readAt - m_batch[k].back;
+        m_lastSampleAt = at;
+        m_hasSampleAt = true;
+        process(m_batch[k].st, at);
+    }
+    m_batch.clear();
+}
+
+void SerialController::process(DeckState st, std::chrono::steady_clock::time_point at) {
+    st.readAt = m_readAt;
+    st.parsedAt = std::chrono::steady_clock::now();
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    ++m_batchFrames;
+
+    // Filtri dei fader su ogni campione, prima del coalescing
+    if (m_filtersDirty.exchange(false, std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lk(m_filtersMx);
+        m_filters.configure(m_nextFilters);
+    }
+    const bool binary = m_protocol.load(std::memory_order_relaxed) == DeckProtocol::Binary;
+    const auto raw = st.sliders;
+    m_filters.apply(st, binary ? kSampleDtBinary : kSampleDtText);
+    if (m_history) m_history->push(at, raw, st.sliders);   // istante del campione, come i fronti
+
+    // Bottoni: debounce, poi ogni fronte accettato va in coda e il campione
+    // viene pubblicato subito
+    m_debouncer.setWindow(std::chrono::microseconds(m_debounceUs.load(std::memory_order_relaxed)));
+    if (const auto changed = m_debouncer.apply(st, at)) {
+        if (m_edges) {
+            for (size_t i = 0; i < DeckState::kButtons; ++i)
+                if ((changed >> i) & 1) m_edges->push(ButtonEdge{ static_cast<uint16_t>(i), st.buttons[i], at });
+        }
+        m_hasPending = false;
+        publish(st);
+        return;
+    }
+
+    // Solo fader: tieni l'ultimo, verrà pubblicato a fine batch
+    if (m_hasPending) m_coalesced.fetch_add(1, std::memory_order_relaxed);
+    m_pending = st;
+    m_hasPending = true;
+}
+
+void SerialController::onOverflow() {
+    // In binario un device testuale non produce mai 0x00: il framer va in overflow
+    if (m_protocol.load(std::memory_order_relaxed) == DeckProtocol::Binary) switchProtocol(DeckProtocol::Auto);
+}
+
+void SerialController::onBatchEnd() {
+    m_inBatch = false;
+    flushBatch();
+    if (m_hasPending) {
+        m_hasPending = false;
+        publish(m_pending);
+    }
+    if (m_batchFrames > m_backlogPeak.load(std::memory_order_relaxed))
+        m_backlogPeak.store(m_batchFrames, std::memory_order_relaxed);
+    m_batchFrames = 0;
+}
+
+void SerialController::publish(const DeckState& st) {
+    // Tutte le soglie sono nella catena di filtri: ogni cambio d'uscita va pubblicato
+    if (m_store.updateIfChanged(st, /*sliderThreshold*/ 1)) {
+        const auto s = m_store.get();
+        if (m_onUpdate) m_onUpdate(s);
+#ifdef DEBUG
+        // Log minimale ogni cambiamento (solo Debug: a 1 kHz la console diventa il collo di bottiglia)
+        std::string sld;
+        for (size_t i = 0; i < DeckState::kSliders; ++i) {
+            if (i) sld += ", ";
+            sld += std::to_string(s.sliders[i]);
+        }
+        fmt::print("BTN mask={}  SLD=[{}]\n", s.buttonsMask(), sld);
+#endif
+    }
+}
+
+void SerialController::switchProtocol(DeckProtocol p) {
+    m_protocol.store(p, std::memory_order_relaxed);
+    if (m_reader) m_reader->setDelimiter(p == DeckProtocol::Binary ? '\0' : '\n');
+    m_badStreak = 0;
+    m_hasSeq = false;
+    fmt::print("Seriale {}: protocollo {}\n", m_port, DeckProtocolName(p));
+}
+
+// -----------------------------------------------------------------------------
+// Supervisione del collegamento: tutto sullo strand del reader
+// -----------------------------------------------------------------------------
+void SerialController::resetLink() {
+    // Ogni nuova connessione riparte dal rilevamento automatico del formato
+    m_protocol = DeckProtocol::Auto;
+    if (m_reader) m_reader->setDelimiter('\n');
+    m_badStreak = 0;
+    m_hasSeq = false;
+    m_hasPending = false;
+    m_inBatch = false;
+    m_batch.clear();
+    m_hasSampleAt = false;
+    m_batchFrames = 0;
+    m_debouncer.reset(m_store.get().buttons);   // nessun fronte finto al ricollegamento
+    m_filters.reset();   // il nuovo collegamento riparte dal primo campione
+}
+
+void SerialController::tryOpen() {
+    resetLink();
+    m_lastOverflows = m_reader->overflows();
+
+    asio::error_code ec;
+    if (!m_reader->open(ec)) {
+        if (m_stopping) return;
+        // Un solo messaggio per serie di tentativi: con il device staccato non riempie la console
+        if (m_retryAttempt == 0) fmt::print("Errore apertura {}: {} (nuovo tentativo in background)\n", m_port, ec.message());
+        scheduleRetry();
+        return;
+    }
+
+    if (m_everConnected) {
+        m_reconnects.fetch_add(1, std::memory_order_relaxed);
+        fmt::print("Seriale {}: ricollegata dopo {} tentativi\n", m_port, m_retryAttempt);
+    }
+    m_everConnected = true;
+    m_retryAttempt = 0;
+    if (m_capture) m_capture->recordOpen(static_cast<uint8_t>(DeckProtocol::Auto));
+    setLink(SerialLinkState::Connected);
+}
+
+void SerialController::onLinkError(const asio::error_code& ec) {
+    if (m_stopping) return;
+    fmt::print("Seriale {}: collegamento perso ({}), riconnessione...\n", m_port, ec.message());
+    m_hasPending = false;   // batch interrotto: il campione parziale non è affidabile
+    m_inBatch = false;
+    m_retryAttempt = 0;
+    scheduleRetry();
+}
+
+void SerialController::scheduleRetry() {
+    if (m_stopping) return;
+    setLink(SerialLinkState::Reconnecting);
+
+    const int shift = std::min(m_retryAttempt, 6);
+    const int64_t cap = std::min(kRetryInitialMs << shift, kRetryMaxMs);
+    const int64_t delayMs = std::uniform_int_distribution<int64_t>(cap / 2, cap)(m_rng);
+    ++m_retryAttempt;
+
+    beginOp();
+    m_retryTimer->expires_after(std::chrono::milliseconds(delayMs));
+    m_retryTimer->async_wait([this](const asio::error_code& ec) {
+        if (!ec && !m_stopping) tryOpen();
+        endOp();
+        });
+}
+
+void SerialController::setLink(SerialLinkState s) {
+    if (m_link.exchange(s, std::memory_order_acq_rel) == s) return;
+    if (m_onLink) m_onLink(s);
+}
+
+void SerialController::beginOp() {
+    std::lock_guard<std::mutex> lk(m_opsMx);
+    ++m_ops;
+}
+
+void SerialController::endOp() {
+    std::lock_guard<std::mutex> lk(m_opsMx);
+    if (--m_ops == 0) m_opsCv.notify_all();
 }
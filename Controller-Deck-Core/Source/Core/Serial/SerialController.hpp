@@ -1,25 +1,235 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <memory>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <vector>
 #include <fmt/core.h>
 #include "Core/DeckState.hpp"
 #include "Core/MessageParser.hpp"
+#include "Core/DeckFrame.hpp"
+#include "Core/ButtonEdgeQueue.hpp"
+#include "Core/Metrics/SampleHistory.hpp"
 #include "Core/Serial/Serial.hpp"  // il tuo SerialReader
+#include "Core/Serial/FaderFilterChain.hpp"
+#include "Core/Serial/ButtonDebouncer.hpp"
+#include "Core/Serial/SerialCapture.hpp"
 
-// Incapsula SerialReader + parser + storage
+// Formato parlato dal device: rilevato automaticamente alla connessione
+enum class DeckProtocol { Auto, Text, Binary };
+
+const char* DeckProtocolName(DeckProtocol p);
+
+// Stato reale del collegamento (non la sola esistenza del controller)
+enum class SerialLinkState { Stopped, Connecting, Connected, Reconnecting };
+
+const char* SerialLinkStateName(SerialLinkState s);
+
+// Contatori diagnostici (snapshot)
+struct SerialStats {
+    DeckProtocol protocol = DeckProtocol::Auto;
+    SerialLinkState link = SerialLinkState::Stopped;
+    uint64_t reconnects = 0;    // riaperture riuscite dopo un errore di IO
+    uint64_t frames = 0;        // frame validi (testo o binari)
+    uint64_t parseErrors = 0;   // linee testuali malformate
+    uint64_t crcErrors = 0;     // frame binari scartati (COBS/lunghezza/CRC)
+    uint64_t seqGaps = 0;       // frame binari persi (salti del numero di sequenza)
+    uint64_t coalesced = 0;     // campioni fader superati da uno più recente nello stesso batch
+    uint64_t backlogPeak = 0;   // massimo numero di frame arrivati in una sola lettura
+    uint64_t edgeDrops = 0;     // fronti dei bottoni persi a coda piena
+};
+
+// Esito di SerialController::replay
+struct ReplayStats {
+    uint64_t reads = 0;          // read riprodotte
+    uint64_t frames = 0;         // frame consegnati alla pipeline (validi o no)
+    double   capturedSec = 0.0;  // durata della cattura
+    double   elapsedSec = 0.0;   // durata del replay
+    bool     completed = false;  // false se interrotto da cancel
+};
+
+// Incapsula SerialReader + parser + filtri + storage.
+// La catena di filtri dei fader (FaderFilterChain) gira qui, su OGNI frame parsato
+// e prima del coalescing: lo store contiene già lo stato filtrato, identico a
+// parità di stream in ingresso qualunque sia la frequenza con cui i consumatori
+// lo leggono. Non ci sono altre soglie a valle: ogni cambio d'uscita è pubblicato.
+// I bottoni passano dal debounce (ButtonDebouncer) e ogni fronte accettato finisce,
+// con il suo istante, nella ButtonEdgeQueue del chiamante: il consumatore vede
+// ogni press/release anche se lo store ne conserva solo l'ultimo stato.
+// Modalità "drain": quando una lettura contiene più frame (host rimasto indietro),
+// i fader collassano sull'ultimo campione del batch, mentre ogni frame che
+// cambia i bottoni viene pubblicato subito. I frame di una read passano dal
+// debounce a fine read, ognuno con il proprio istante ricostruito a ritroso
+// dalla read: un doppio tap arrivato in una sola read resta un doppio tap.
+// Cattura e replay: con setCapture ogni read e ogni frame consegnato dal framer
+// finiscono su file (SerialCapture); replay() li fa ripercorrere alla stessa
+// pipeline (parser, filtri, debounce, store, fronti) a tempo reale, N volte più
+// veloce o senza attese, per riprodurre un problema visto sul campo.
+// Supervisione: su errore di IO (device scollegato, apertura fallita) la porta
+// viene ritentata con backoff esponenziale con jitter, sempre sul thread di IO:
+// start()/stop() non attendono mai l'apertura della porta.
 class SerialController {
 public:
-    SerialController(const std::string& port, unsigned int baud);
+    // Osservatore opzionale: chiamato sul thread di IO dopo ogni aggiornamento dello store
+    using UpdateCallback = std::function<void(const DeckState&)>;
+    // Osservatore opzionale dei cambi di stato del collegamento: thread di IO,
+    // tranne Stopped che arriva dal thread che chiama stop()
+    using LinkCallback = std::function<void(SerialLinkState)>;
+
+    // io: io_context condiviso (SerialIoPool) su cui gira la lettura.
+    // store: destinazione degli stati parsati, di proprietà del chiamante
+    // (deve sopravvivere al controller). Questo controller ne è l'unico scrittore.
+    SerialController(asio::io_context& io, const std::string& port, unsigned int baud, DeckStateStore& store);
     ~SerialController();
 
+    // Non bloccante: l'apertura (e gli eventuali tentativi) girano sul thread di IO
     void start();
     void stop();
 
     DeckStateStore& store() { return m_store; }
 
+    // Da impostare prima di start()
+    void setOnUpdate(UpdateCallback cb) { m_onUpdate = std::move(cb); }
+    void setOnLink(LinkCallback cb) { m_onLink = std::move(cb); }
+    // Coda dei fronti dei bottoni (opzionale, di proprietà del chiamante):
+    // questo controller ne è l'unico produttore
+    void setEdgeQueue(ButtonEdgeQueue* q) { m_edges = q; }
+    // Storico dei campioni dei fader (opzionale, di proprietà del chiamante):
+    // ogni frame vi registra valore grezzo e filtrato, prima del coalescing
+    void setHistory(SampleHistory* h) { m_history = h; }
+
+    SerialLinkState linkState() const { return m_link.load(std::memory_order_acquire); }
+
+    // Catena di filtri dei fader. Thread-safe: il thread di IO la adotta dal
+    // frame successivo (un cambio di modo dello smoothing fa ripartire solo quel fader).
+    void setFilters(const FilterChainConfig& cfg);
+
+    // Contatori per stadio della catena. Thread-safe.
+    std::vector<FilterStageStats> filterStats() const { return m_filters.stats(); }
+
+    // Finestra di debounce dei bottoni (0 = nessun filtro). Thread-safe.
+    void setDebounce(std::chrono::microseconds w) { m_debounceUs.store(w.count(), std::memory_order_relaxed); }
+
+    // Avvia (w aperto) o ferma (nullptr) la cattura della seriale. Thread-safe: a
+    // controller avviato il cambio avviene sullo strand del reader, e la cattura
+    // precedente viene rilasciata lì (il file si chiude con l'ultimo riferimento).
+    void setCapture(std::shared_ptr<SerialCaptureWriter> w);
+
+    // Riproduce una cattura dal thread chiamante, SOLO con il controller fermo
+    // (start() non chiamato): lo store, la coda dei fronti e le callback ricevono
+    // quello che avrebbe prodotto la porta. speed: 1 = tempo reale, N = N volte
+    // più veloce, 0 = senza attese. I tempi dei campioni (debounce, storico)
+    // restano quelli della cattura, qualunque sia speed. cancel (opzionale) la interrompe.
+    ReplayStats replay(SerialCaptureReader& cap, double speed, const std::atomic<bool>* cancel = nullptr);
+
+    // Thread-safe: letto dai thread REST
+    SerialStats stats() const;
+
 private:
+    // Tutto ciò che segue gira sul thread di IO del reader (o su quello di replay)
+    void onReaderFrame(std::string_view frame);   // callback del reader: tempo della read + cattura
+    void onReaderBatchEnd();
+    void onFrame(std::string_view frame);
+    void handleText(std::string_view line, bool detecting);
+    void handleBinary(std::string_view frame);
+    void accept(const DeckState& st, bool binary, uint8_t seq = 0);   // frame valido dal parser: nel batch
+    void flushBatch();                                  // istante di ogni frame del batch, poi process
+    void process(DeckState st, std::chrono::steady_clock::time_point at);   // filtri, debounce, store
+    void publish(const DeckState& st);  // aggiorna lo store
+    void onBatchEnd();
+    void onOverflow();                  // il framer ha scartato una linea
+    void switchProtocol(DeckProtocol p);
+    void resetLink();                   // nuovo collegamento: rilevamento e filtri da capo
+
+    // Supervisione del collegamento (strand del reader)
+    void tryOpen();
+    void onLinkError(const asio::error_code& ec);
+    void scheduleRetry();
+    void setLink(SerialLinkState s);
+    void beginOp();   // handler postata/timer armato: stop() la attende
+    void endOp();
+
+    // Dopo N frame invalidi consecutivi si torna al rilevamento automatico
+    static constexpr int kMaxBadStreak = 16;
+
+    // Periodo nominale di un campione per i filtri (velocità One-Euro): fisso per
+    // protocollo invece che misurato, così lo stesso stream dà sempre la stessa uscita
+    static constexpr float kSampleDtText = 0.010f;     // DeeJ: una linea ogni ~10 ms
+    static constexpr float kSampleDtBinary = 0.001f;   // ~1 kHz
+    // Stessi periodi per ricostruire l'istante dei frame arrivati nella stessa read
+    static constexpr std::chrono::microseconds kSamplePeriodText{ 10000 };
+    static constexpr std::chrono::microseconds kSamplePeriodBinary{ 1000 };
+
+    // Backoff dei tentativi: 100 ms, 200 ms, ... fino a 5 s, ognuno scelto a
+    // caso in [d/2, d] così più deck staccati insieme non ritentano in fase
+    static constexpr int64_t kRetryInitialMs = 100;
+    static constexpr int64_t kRetryMaxMs = 5000;
+
+    asio::io_context& m_io;
     std::string m_port;
     unsigned int m_baud;
-    DeckStateStore m_store;
+    DeckStateStore& m_store;
     std::unique_ptr<SerialReader> m_reader;
+    std::unique_ptr<asio::steady_timer> m_retryTimer;   // sullo strand del reader
+    UpdateCallback m_onUpdate;
+    LinkCallback m_onLink;
+    ButtonEdgeQueue* m_edges = nullptr;
+    SampleHistory* m_history = nullptr;
+    std::shared_ptr<SerialCaptureWriter> m_capture;   // thread di IO (strand)
+
+    std::atomic<SerialLinkState> m_link{ SerialLinkState::Stopped };
+    std::atomic<bool> m_stopping{ false };
+    std::atomic<uint64_t> m_reconnects{ 0 };
+    int  m_retryAttempt = 0;        // tentativi falliti consecutivi (strand)
+    bool m_everConnected = false;   // strand
+    std::minstd_rand m_rng;         // jitter (strand)
+
+    // handler in volo (tentativo postato o timer armato): stop() attende 0
+    std::mutex m_opsMx;
+    std::condition_variable m_opsCv;
+    int m_ops = 0;
+
+    std::atomic<DeckProtocol> m_protocol{ DeckProtocol::Auto };
+    std::atomic<uint64_t> m_frames{ 0 };
+    std::atomic<uint64_t> m_parseErrors{ 0 };
+    std::atomic<uint64_t> m_crcErrors{ 0 };
+    std::atomic<uint64_t> m_seqGaps{ 0 };
+    std::atomic<uint64_t> m_coalesced{ 0 };
+    std::atomic<uint64_t> m_backlogPeak{ 0 };
+
+    int     m_badStreak = 0;
+    bool    m_hasSeq = false;
+    uint8_t m_lastSeq = 0;
+    uint64_t m_lastOverflows = 0;
+
+    // filtri dei fader (thread di IO); la nuova catena passa da m_nextFilters
+    FaderFilterChain  m_filters;
+    std::mutex        m_filtersMx;
+    FilterChainConfig m_nextFilters{};
+    std::atomic<bool> m_filtersDirty{ false };
+
+    // debounce dei bottoni (thread di IO); finestra impostabile da qualsiasi thread
+    ButtonDebouncer      m_debouncer;
+    std::atomic<int64_t> m_debounceUs{ 0 };
+
+    // stato del batch corrente
+    struct BatchFrame {
+        DeckState st;
+        bool      binary = false;
+        uint8_t   seq = 0;
+        std::chrono::steady_clock::duration back{};   // distanza dalla read
+    };
+    std::chrono::steady_clock::time_point m_readAt{};   // fine della read che lo ha portato
+    bool      m_inBatch = false;
+    std::vector<BatchFrame> m_batch;                    // frame validi della read, in ordine
+    std::chrono::steady_clock::time_point m_lastSampleAt{};   // istante dell'ultimo frame elaborato
+    bool      m_hasSampleAt = false;
+    DeckState m_pending{};
+    bool      m_hasPending = false;
+    uint64_t  m_batchFrames = 0;
 };
@@ -0,0 +1,25 @@
+#include "Core/Serial/SerialIoPool.hpp"
+#include <fmt/core.h>
+
+SerialIoPool::SerialIoPool(size_t threads) {
+    if (threads == 0) threads = 1;
+    m_work.emplace(asio::make_work_guard(m_io));
+    m_threads.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        m_threads.emplace_back([this] {
+            for (;;) {
+                try { m_io.run(); break; }
+                catch (const std::exception& e) { fmt::print("[SerialIo] eccezione in handler: {}\n", e.what()); }
+            }
+            });
+    }
+}
+
+SerialIoPool::~SerialIoPool() { stop(); }
+
+void SerialIoPool::stop() {
+    m_work.reset();
+    m_io.stop();
+    for (auto& t : m_threads) if (t.joinable()) t.join();
+    m_threads.clear();
+}
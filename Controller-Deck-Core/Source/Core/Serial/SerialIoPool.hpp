@@ -0,0 +1,31 @@
+#pragma once
+#include <asio.hpp>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// io_context condiviso da tutte le porte seriali.
+// Un singolo thread regge comodamente decine di device (ogni porta ha al più
+// una read in volo e il lavoro per frame è di pochi µs); più thread servono
+// solo se i callback diventano pesanti. Le handler di una stessa porta non
+// girano mai in parallelo: ogni SerialReader concatena una read alla volta.
+class SerialIoPool {
+public:
+    explicit SerialIoPool(size_t threads = 1);
+    ~SerialIoPool();
+
+    SerialIoPool(const SerialIoPool&) = delete;
+    SerialIoPool& operator=(const SerialIoPool&) = delete;
+
+    asio::io_context& context() { return m_io; }
+    size_t threads() const { return m_threads.size(); }
+
+    // Ferma i thread: da chiamare solo dopo aver chiuso tutti i reader
+    void stop();
+
+private:
+    asio::io_context m_io;
+    std::optional<asio::executor_work_guard<asio::io_context::executor_type>> m_work;
+    std::vector<std::thread> m_threads;
+};
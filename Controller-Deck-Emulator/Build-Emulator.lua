@@ -0,0 +1,48 @@
+project "Controller-Deck-Emulator"
+    kind "ConsoleApp"              -- deck virtuale su pseudo-terminale (solo Linux)
+    language "C++"
+    cppdialect "C++20"
+    staticruntime "off"
+
+    exceptionhandling "On"
+    defines { "FMT_USE_EXCEPTIONS=1", "ASIO_STANDALONE" }
+
+    targetdir ("../Binaries/" .. OutputDir .. "/%{prj.name}")
+    objdir    ("../Binaries/Intermediates/" .. OutputDir .. "/%{prj.name}")
+
+    files {
+        "Source/**.h",
+        "Source/**.hpp",
+        "Source/**.cpp"
+    }
+
+    includedirs {
+        "Source",
+        "../Controller-Deck-Core/Source"   -- include Core
+    }
+
+    links {
+        "Controller-Deck-Core",
+        "fmt",
+        "pthread"
+    }
+
+    filter "configurations:Debug"
+        defines { "DEBUG" }
+        runtime "Debug"
+        symbols "On"
+    filter {}
+
+    filter "configurations:Release"
+        defines { "RELEASE" }
+        runtime "Release"
+        optimize "Full"
+        symbols "On"
+    filter {}
+
+    filter "configurations:Dist"
+        defines { "DIST" }
+        runtime "Release"
+        optimize "Full"
+        symbols "Off"
+    filter {}
@@ -0,0 +1,93 @@
+#include "FrameGenerator.hpp"
+#include "Core/DeckFrame.hpp"
+#include <fmt/format.h>
+
+bool ParseEmuPattern(std::string_view s, EmuPattern& out) {
+    if (s == "ramp")      { out = EmuPattern::Ramp;      return true; }
+    if (s == "noise")     { out = EmuPattern::Noise;     return true; }
+    if (s == "buttons")   { out = EmuPattern::Buttons;   return true; }
+    if (s == "malformed") { out = EmuPattern::Malformed; return true; }
+    if (s == "garbage")   { out = EmuPattern::Garbage;   return true; }
+    if (s == "mix")       { out = EmuPattern::Mix;       return true; }
+    return false;
+}
+
+bool ParseEmuFormat(std::string_view s, EmuFormat& out) {
+    if (s == "text")   { out = EmuFormat::Text;   return true; }
+    if (s == "binary") { out = EmuFormat::Binary; return true; }
+    return false;
+}
+
+FrameGenerator::FrameGenerator(EmuPattern pattern, EmuFormat format, uint32_t seed)
+    : m_pattern(pattern), m_format(format), m_rng(seed) {
+}
+
+FrameGenerator::Kind FrameGenerator::next(uint64_t i, std::string& out) {
+    out.clear();
+
+    double pMalformed = 0.0, pGarbage = 0.0;
+    if (m_pattern == EmuPattern::Malformed) pMalformed = 0.10;
+    if (m_pattern == EmuPattern::Garbage)   pGarbage = 0.05;
+    if (m_pattern == EmuPattern::Mix)     { pMalformed = 0.02; pGarbage = 0.01; }
+
+    if (pGarbage > 0 && chance(pGarbage)) { appendGarbage(out); return Kind::Garbage; }
+    if (pMalformed > 0 && chance(pMalformed)) { appendMalformed(i, out); return Kind::Malformed; }
+    appendValid(i, out);
+    return Kind::Valid;
+}
+
+void FrameGenerator::appendValid(uint64_t i, std::string& out) {
+    DeckState s{};
+
+    constexpr size_t kTagSlider = DeckState::kSliders - 1;
+    for (size_t k = 0; k < kTagSlider; ++k) {
+        if (m_pattern == EmuPattern::Noise) {
+            s.sliders[k] = 512 + static_cast<int>(m_rng() % 17) - 8;
+        }
+        else {
+            // rampa triangolare 0..1023..0, sfasata per canale
+            const int p = static_cast<int>((i * 2 + k * 200) % 2046);
+            s.sliders[k] = p <= 1023 ? p : 2046 - p;
+        }
+    }
+    s.sliders[kTagSlider] = tagFor(i);
+
+    if constexpr (DeckState::kButtons > 0) {
+        if (m_pattern == EmuPattern::Buttons || m_pattern == EmuPattern::Mix) {
+            // raffiche: ogni 50 frame un doppio tap da un frame ciascuno su un bottone
+            const uint64_t ph = i % 50;
+            if (ph == 0 || ph == 2) s.buttons[(i / 50) % DeckState::kButtons] = true;
+        }
+    }
+
+    if (m_format == EmuFormat::Text) {
+        for (int v : s.sliders) fmt::format_to(std::back_inserter(out), "{}|", v);
+        fmt::format_to(std::back_inserter(out), "{}\r\n", s.buttonsMask());
+    }
+    else {
+        uint8_t buf[kDeckFrameMaxEncoded];
+        const size_t n = EncodeDeckFrame(s, static_cast<uint8_t>(i), buf);
+        out.append(reinterpret_cast<const char*>(buf), n);
+    }
+}
+
+void FrameGenerator::appendMalformed(uint64_t i, std::string& out) {
+    if (m_format == EmuFormat::Text) {
+        static const char* kBad[] = { "12|x|3|4|5|0\r\n", "1|2|3\r\n", "1|2|3|4|5|6|7|8\r\n", "||||\r\n", "512|512|512|512|-\r\n" };
+        out += kBad[i % (sizeof(kBad) / sizeof(kBad[0]))];
+    }
+    else {
+        // frame valido con un bit ribaltato: deve fallire il CRC
+        appendValid(i, out);
+        const size_t pos = 1 + m_rng() % (out.size() - 2);
+        char flipped = static_cast<char>(out[pos] ^ (1 << (m_rng() % 8)));
+        if (flipped == 0) flipped = static_cast<char>(out[pos] ^ 0x80);
+        out[pos] = flipped;
+    }
+}
+
+void FrameGenerator::appendGarbage(std::string& out) {
+    // rumore di linea: byte casuali, possono contenere anche delimitatori
+    const size_t n = 3 + m_rng() % 10;
+    for (size_t k = 0; k < n; ++k) out.push_back(static_cast<char>(m_rng() & 0xFF));
+}
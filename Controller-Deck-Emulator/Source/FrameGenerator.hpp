@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+
+// Forme d'onda / scenari generati dall'emulatore
+enum class EmuPattern { Ramp, Noise, Buttons, Malformed, Garbage, Mix };
+enum class EmuFormat { Text, Binary };
+
+bool ParseEmuPattern(std::string_view s, EmuPattern& out);
+bool ParseEmuFormat(std::string_view s, EmuFormat& out);
+
+// Genera i byte del frame i-esimo.
+// L'ultimo slider trasporta sempre un tag ((i % 256) * 4) per misurare la latenza
+// emulatore -> DeckStateStore; gli altri canali seguono il pattern scelto.
+class FrameGenerator {
+public:
+    enum class Kind { Valid, Malformed, Garbage };
+
+    FrameGenerator(EmuPattern pattern, EmuFormat format, uint32_t seed = 1);
+
+    // Sovrascrive out con i byte da inviare per il frame i
+    Kind next(uint64_t i, std::string& out);
+
+    static int tagFor(uint64_t i) { return static_cast<int>(i % 256) * 4; }
+    static size_t tagIndex(int tagSlider) { return static_cast<size_t>(tagSlider / 4) % 256; }
+
+    // Il frame i apre una raffica sui bottoni (pattern buttons/mix): ogni 50 frame
+    // un press di un frame, un frame di rilascio e un secondo press di un frame (rimbalzo)
+    static bool startsBurst(EmuPattern p, uint64_t i) {
+        return (p == EmuPattern::Buttons || p == EmuPattern::Mix) && i % 50 == 0;
+    }
+
+private:
+    bool chance(double p) { return m_uni(m_rng) < p; }
+    void appendValid(uint64_t i, std::string& out);
+    void appendMalformed(uint64_t i, std::string& out);
+    void appendGarbage(std::string& out);
+
+    EmuPattern m_pattern;
+    EmuFormat  m_format;
+    std::mt19937 m_rng;
+    std::uniform_real_distribution<double> m_uni{ 0.0, 1.0 };
+};
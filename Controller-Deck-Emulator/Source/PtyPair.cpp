@@ -0,0 +1,59 @@
+#include "PtyPair.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+PtyPair::~PtyPair() { close(); }
+
+bool PtyPair::open(std::string& err) {
+    close();
+
+    m_master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if (m_master < 0) { err = std::string("posix_openpt: ") + std::strerror(errno); return false; }
+    if (::grantpt(m_master) != 0 || ::unlockpt(m_master) != 0) {
+        err = std::string("grantpt/unlockpt: ") + std::strerror(errno);
+        close();
+        return false;
+    }
+
+    const char* name = ::ptsname(m_master);
+    if (!name) { err = "ptsname failed"; close(); return false; }
+    m_slavePath = name;
+
+    // Senza almeno un descrittore aperto sullo slave, le write sul master
+    // falliscono con EIO finché il reader non apre la porta.
+    m_slaveKeepAlive = ::open(name, O_RDWR | O_NOCTTY);
+    if (m_slaveKeepAlive < 0) { err = std::string("open slave: ") + std::strerror(errno); close(); return false; }
+
+    // Slave in modalità raw: nessuna traduzione CR/LF né echo verso il master
+    termios tio{};
+    if (::tcgetattr(m_slaveKeepAlive, &tio) == 0) {
+        ::cfmakeraw(&tio);
+        ::tcsetattr(m_slaveKeepAlive, TCSANOW, &tio);
+    }
+    return true;
+}
+
+void PtyPair::close() {
+    if (m_slaveKeepAlive >= 0) { ::close(m_slaveKeepAlive); m_slaveKeepAlive = -1; }
+    if (m_master >= 0) { ::close(m_master); m_master = -1; }
+    m_slavePath.clear();
+}
+
+bool PtyPair::writeAll(const void* data, size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while (n > 0) {
+        const ssize_t w = ::write(m_master, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
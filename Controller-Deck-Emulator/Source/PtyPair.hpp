@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+
+// Coppia di pseudo-terminali: il lato master lo scrive l'emulatore,
+// il lato slave (es. /dev/pts/7) si apre come una normale porta seriale.
+class PtyPair {
+public:
+    PtyPair() = default;
+    ~PtyPair();
+
+    PtyPair(const PtyPair&) = delete;
+    PtyPair& operator=(const PtyPair&) = delete;
+
+    bool open(std::string& err);
+    void close();
+
+    int masterFd() const { return m_master; }
+    const std::string& slavePath() const { return m_slavePath; }
+
+    // Scrive tutto il buffer sul master (bloccante). false su errore.
+    bool writeAll(const void* data, size_t n);
+
+private:
+    int m_master = -1;
+    int m_slaveKeepAlive = -1;   // tiene aperto lo slave finché il reader non si collega
+    std::string m_slavePath;
+};
@@ -0,0 +1,358 @@
+#include "PtyPair.hpp"
+#include "FrameGenerator.hpp"
+#include "Core/Serial/SerialController.hpp"
+#include "Core/Serial/SerialIoPool.hpp"
+
+#include <fmt/core.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+// Deck virtuale su pseudo-terminale Linux.
+// Scrive frame sul lato master a rate configurabile; SerialController si collega
+// al lato slave esattamente come farebbe con una porta COM reale. A fine run
+// stampa frame/s sostenuti, errori di parsing e percentili di latenza
+// emulatore -> DeckStateStore. Con --devices N emula N deck in parallelo, tutti
+// letti da un solo thread di IO (SerialIoPool), come fa l'app.
+//
+// Uso:
+//   Controller-Deck-Emulator [--rate HZ] [--seconds N] [--pattern P] [--format F] [--devices N] [--debounce MS] [--drop-every S] [--capture FILE] [--external]
+//   Controller-Deck-Emulator --replay FILE [--speed X] [--debounce MS]
+//     --rate      frame al secondo per device (0 = più veloce possibile)  [1000]
+//     --seconds   durata del run                                   [10]
+//     --pattern   ramp | noise | buttons | malformed | garbage | mix   [ramp]
+//     --format    text | binary                                    [text]
+//     --devices   numero di deck emulati                           [1]
+//     --debounce  finestra di debounce dei bottoni in ms (0 = off)  [5]
+//     --drop-every  ogni S secondi "stacca" i deck: chiude il pty e ne apre uno
+//                 nuovo dietro lo stesso link (/tmp/controller-deck-emu-*), per
+//                 provare la riconnessione automatica                  [0 = mai]
+//     --external  non avvia il controller interno: stampa il path dello slave
+//                 e continua a scrivere (per collegare l'app o altri tool)
+//     --capture   registra ciò che riceve il controller interno (SerialCapture);
+//                 con più device FILE.0, FILE.1, ...
+//     --replay    riproduce una cattura nella pipeline del controller, senza pty,
+//                 e stampa frame/s e l'impronta degli aggiornamenti dello store:
+//                 la stessa del run che l'ha catturata
+//     --speed     velocità del replay: 1 = tempo reale, 0 = senza attese  [1]
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        double rate = 1000.0;
+        double seconds = 10.0;
+        EmuPattern pattern = EmuPattern::Ramp;
+        EmuFormat format = EmuFormat::Text;
+        int devices = 1;
+        int debounceMs = 5;
+        double dropEvery = 0.0;
+        bool external = false;
+        std::string capture;
+        std::string replay;
+        double speed = 1.0;
+    };
+
+    bool ParseArgs(int argc, char** argv, Options& o) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string a = argv[i];
+            auto value = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+
+            if (a == "--external") { o.external = true; continue; }
+
+            const char* v = value();
+            if (!v) { fmt::print("Valore mancante per {}\n", a); return false; }
+            if (a == "--rate") o.rate = std::atof(v);
+            else if (a == "--seconds") o.seconds = std::atof(v);
+            else if (a == "--pattern") { if (!ParseEmuPattern(v, o.pattern)) { fmt::print("Pattern sconosciuto: {}\n", v); return false; } }
+            else if (a == "--devices") o.devices = std::atoi(v);
+            else if (a == "--debounce") o.debounceMs = std::atoi(v);
+            else if (a == "--drop-every") o.dropEvery = std::atof(v);
+            else if (a == "--capture") o.capture = v;
+            else if (a == "--replay") o.replay = v;
+            else if (a == "--speed") o.speed = std::atof(v);
+            else if (a == "--format") { if (!ParseEmuFormat(v, o.format)) { fmt::print("Formato sconosciuto: {}\n", v); return false; } }
+            else { fmt::print("Opzione sconosciuta: {}\n", a); return false; }
+        }
+        return o.rate >= 0 && o.seconds > 0 && o.devices >= 1 && o.devices <= 256 && o.debounceMs >= 0 && o.dropEvery >= 0 && o.speed >= 0;
+    }
+
+    // Punta link su target in modo atomico (symlink temporaneo + rename)
+    bool PointLink(const std::string& link, const std::string& target) {
+        const std::string tmp = link + ".tmp";
+        ::unlink(tmp.c_str());
+        if (::symlink(target.c_str(), tmp.c_str()) != 0) return false;
+        return ::rename(tmp.c_str(), link.c_str()) == 0;
+    }
+
+    int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    // Catena di default, ma il tag deve arrivare intatto: ultimo slider senza filtri
+    FilterChainConfig EmuFilters() {
+        FilterChainConfig fc{};
+        fc.smoothing.back().deadband_counts = 0;
+        fc.smoothing.back().alpha = 1.0f;
+        for (auto& stage : fc.stages) stage.counts.back() = 0;
+        return fc;
+    }
+
+    // Impronta FNV-1a della sequenza di stati pubblicati: uguale dal vivo e nel replay
+    constexpr uint64_t kFingerprintSeed = 1469598103934665603ull;
+
+    uint64_t Fold(uint64_t h, const DeckState& s) {
+        auto mix = [&h](uint64_t v) {
+            for (int i = 0; i < 8; ++i) { h ^= (v >> (8 * i)) & 0xFF; h *= 1099511628211ull; }
+        };
+        for (int v : s.sliders) mix(static_cast<uint64_t>(v));
+        mix(s.buttonsMask());
+        return h;
+    }
+
+    double Percentile(std::vector<int64_t>& v, double p) {
+        if (v.empty()) return 0.0;
+        const size_t k = std::min(v.size() - 1, static_cast<size_t>(p * static_cast<double>(v.size())));
+        std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(k), v.end());
+        return static_cast<double>(v[k]) / 1000.0;
+    }
+}
+
+// Un deck emulato: pty + (se interno) store e controller collegati allo slave
+struct EmuDevice {
+    PtyPair pty;
+    std::string link;   // path stabile verso lo slave corrente (sopravvive ai drop)
+    DeckStateStore store;
+    ButtonEdgeQueue edges;
+    SampleHistory history;
+    std::unique_ptr<SerialController> ctl;
+    int lastTag = -1;
+    uint64_t presses = 0, releases = 0;   // fronti consumati dalla coda
+    uint64_t updates = 0, fingerprint = kFingerprintSeed;   // stati pubblicati nello store
+    std::shared_ptr<SerialCaptureWriter> capture;
+
+    void drainEdges() {
+        edges.drain([this](const ButtonEdge& e) { ++(e.pressed ? presses : releases); });
+    }
+};
+
+// --replay: la cattura attraversa parser, filtri, debounce, store e coda dei fronti
+// come dal vivo, sul thread corrente
+static int RunReplay(const Options& opt) {
+    SerialCaptureReader cap;
+    std::string err;
+    if (!cap.open(opt.replay, err)) { fmt::print("Cattura {} non leggibile: {}\n", opt.replay, err); return 2; }
+
+    asio::io_context io;   // richiesto dal controller, mai avviato: il replay non apre porte
+    EmuDevice dev;
+    dev.ctl = std::make_unique<SerialController>(io, "replay", 0, dev.store);
+    dev.ctl->setFilters(EmuFilters());
+    dev.ctl->setDebounce(std::chrono::milliseconds(opt.debounceMs));
+    dev.ctl->setEdgeQueue(&dev.edges);
+    dev.ctl->setHistory(&dev.history);
+    dev.ctl->setOnUpdate([&dev](const DeckState& s) {
+        ++dev.updates;
+        dev.fingerprint = Fold(dev.fingerprint, s);
+        dev.drainEdges();   // stesso thread del produttore: la coda non si riempie a velocità massima
+        });
+
+    const ReplayStats rs = dev.ctl->replay(cap, opt.speed);
+    dev.drainEdges();
+    const SerialStats st = dev.ctl->stats();
+
+    fmt::print("Replay {}: {} frame da {} read, {:.2f} s di cattura in {:.3f} s -> {:.0f} frame/s ({:.1f}x)\n",
+        opt.replay, rs.frames, rs.reads, rs.capturedSec, rs.elapsedSec,
+        rs.elapsedSec > 0 ? static_cast<double>(rs.frames) / rs.elapsedSec : 0.0,
+        rs.elapsedSec > 0 ? rs.capturedSec / rs.elapsedSec : 0.0);
+    fmt::print("Ricevuti: {} frame validi (protocollo {})  |  parse={} crc={} seq_gaps={} coalesced={} backlog_peak={}\n",
+        st.frames, DeckProtocolName(st.protocol), st.parseErrors, st.crcErrors, st.seqGaps, st.coalesced, st.backlogPeak);
+    fmt::print("Bottoni: {} press, {} release  |  aggiornamenti store: {}, impronta {:016x}\n",
+        dev.presses, dev.releases, dev.updates, dev.fingerprint);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!ParseArgs(argc, argv, opt)) return 1;
+    if (!opt.replay.empty()) return RunReplay(opt);
+
+    std::vector<std::unique_ptr<EmuDevice>> devs;
+    for (int d = 0; d < opt.devices; ++d) {
+        auto dev = std::make_unique<EmuDevice>();
+        std::string err;
+        if (!dev->pty.open(err)) { fmt::print("PTY non disponibile: {}\n", err); return 2; }
+        dev->link = fmt::format("/tmp/controller-deck-emu-{}-{}", ::getpid(), d);
+        if (!PointLink(dev->link, dev->pty.slavePath())) { fmt::print("Link {} non creato\n", dev->link); return 2; }
+        fmt::print("Deck emulato su {} ({})\n", dev->link, dev->pty.slavePath());
+        devs.push_back(std::move(dev));
+    }
+
+    // Tempi di invio per tag (ultimo slider), letti dal thread di IO dei controller
+    std::array<std::atomic<int64_t>, 256> sentAt{};
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<size_t>(std::max(1.0, opt.rate) * opt.seconds) * devs.size() + 1024);
+
+    // Un solo thread di IO per tutti i device: le callback non corrono tra loro
+    std::unique_ptr<SerialIoPool> io;
+    if (!opt.external) {
+        io = std::make_unique<SerialIoPool>(1);
+        for (auto& dev : devs) {
+            EmuDevice* d = dev.get();
+            d->ctl = std::make_unique<SerialController>(io->context(), d->link, 115200, d->store);
+            d->ctl->setFilters(EmuFilters());
+            d->ctl->setDebounce(std::chrono::milliseconds(opt.debounceMs));
+            d->ctl->setEdgeQueue(&d->edges);
+            d->ctl->setHistory(&d->history);
+            if (!opt.capture.empty()) {
+                const std::string path = devs.size() == 1 ? opt.capture : fmt::format("{}.{}", opt.capture, &dev - &devs[0]);
+                d->capture = std::make_shared<SerialCaptureWriter>();
+                std::string err;
+                if (!d->capture->open(path, err, true)) { fmt::print("Cattura {} non creata: {}\n", path, err); return 2; }
+                d->ctl->setCapture(d->capture);
+            }
+            d->ctl->setOnUpdate([&sentAt, &latencies, d](const DeckState& s) {
+                ++d->updates;
+                d->fingerprint = Fold(d->fingerprint, s);
+                if (s.sliders.back() == d->lastTag) return; // aggiornamento dovuto ai soli bottoni
+                d->lastTag = s.sliders.back();
+                const int64_t t0 = sentAt[FrameGenerator::tagIndex(s.sliders.back())].load(std::memory_order_acquire);
+                const int64_t dt = NowNs() - t0;
+                if (t0 != 0 && dt >= 0 && dt < 200'000'000 && latencies.size() < latencies.capacity())
+                    latencies.push_back(dt);
+                });
+            d->ctl->start();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100)); // i reader aprono gli slave
+    }
+
+    FrameGenerator gen(opt.pattern, opt.format);
+    std::string frame;
+    uint64_t sent = 0, malformed = 0, garbage = 0, bytes = 0, bursts = 0;
+
+    const auto period = opt.rate > 0 ? std::chrono::duration<double>(1.0 / opt.rate) : std::chrono::duration<double>(0);
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.seconds));
+    auto next = start;
+    auto nextDrop = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.dropEvery));
+    uint64_t drops = 0;
+    bool failed = false;
+
+    while (!failed && Clock::now() < end) {
+        // Scollega e ricollega: il reader vede un errore di IO, poi ritrova la porta dietro al link
+        if (opt.dropEvery > 0 && Clock::now() >= nextDrop) {
+            nextDrop += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.dropEvery));
+            for (auto& dev : devs) {
+                std::string err;
+                if (!dev->pty.open(err) || !PointLink(dev->link, dev->pty.slavePath())) { fmt::print("Riapertura PTY fallita: {}\n", err); failed = true; break; }
+            }
+            ++drops;
+        }
+
+        const auto kind = gen.next(sent, frame);
+        if (FrameGenerator::startsBurst(opt.pattern, sent)) ++bursts;
+        if (kind == FrameGenerator::Kind::Valid)
+            sentAt[FrameGenerator::tagIndex(FrameGenerator::tagFor(sent))].store(NowNs(), std::memory_order_release);
+        else if (kind == FrameGenerator::Kind::Malformed) ++malformed;
+        else ++garbage;
+
+        // stesso frame a tutti i device, uno dopo l'altro
+        for (auto& dev : devs) {
+            if (!dev->pty.writeAll(frame.data(), frame.size())) { fmt::print("Scrittura PTY fallita\n"); failed = true; break; }
+            bytes += frame.size();
+        }
+        ++sent;
+        for (auto& dev : devs) dev->drainEdges();   // consumatore lento: un giro per frame inviato
+
+        if (opt.rate > 0) {
+            next += std::chrono::duration_cast<Clock::duration>(period);
+            std::this_thread::sleep_until(next);
+        }
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+    fmt::print("Inviati: {} frame x {} device ({} malformati, {} rumore) in {:.2f} s -> {:.0f} frame/s per device, {:.0f} byte/s totali\n",
+        sent, devs.size(), malformed, garbage, elapsed, static_cast<double>(sent) / elapsed, static_cast<double>(bytes) / elapsed);
+
+    auto removeLinks = [&] { for (auto& dev : devs) ::unlink(dev->link.c_str()); };
+    if (!io) { removeLinks(); return 0; }
+
+    // lascia drenare il buffer dei pty, poi ferma i reader PRIMA di chiudere i master
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    SerialStats st;
+    std::vector<FilterStageStats> filters;
+    uint64_t histWritten = 0, histSamples = 0, histPoints = 0;
+    double histUs = 0.0;
+    for (auto& dev : devs) {
+        dev->ctl->stop();
+        // contatori per stadio, sommati su tutti i device (il tag escluso)
+        const auto fs = dev->ctl->filterStats();
+        if (filters.empty()) filters.resize(fs.size());
+        for (size_t p = 0; p < fs.size() && p < filters.size(); ++p) {
+            filters[p].kind = fs[p].kind;
+            for (size_t k = 0; k + 1 < DeckState::kSliders; ++k) {
+                filters[p].in[0] += fs[p].in[k];
+                filters[p].out[0] += fs[p].out[k];
+                filters[p].suppressed[0] += fs[p].suppressed[k];
+            }
+        }
+        const SerialStats s = dev->ctl->stats();
+        st.protocol = s.protocol;
+        st.frames += s.frames;
+        st.parseErrors += s.parseErrors;
+        st.crcErrors += s.crcErrors;
+        st.seqGaps += s.seqGaps;
+        st.coalesced += s.coalesced;
+        st.backlogPeak = std::max(st.backlogPeak, s.backlogPeak);
+        st.reconnects += s.reconnects;
+        st.edgeDrops += s.edgeDrops;
+        dev->drainEdges();
+        if (dev->capture) {
+            dev->ctl->setCapture(nullptr);
+            dev->capture->close();
+            fmt::print("Cattura {}: {} frame, {} byte\n", dev->capture->path(), dev->capture->frames(), dev->capture->bytes());
+        }
+
+        // storico: tutta la corsa del primo slider decimata a 500 punti, come /state/history
+        HistorySeries hs;
+        const auto q0 = Clock::now();
+        dev->history.query(0, SampleHistory::Source::Filtered, 0, dev->history.nowMs(), 500, hs);
+        histUs = std::max(histUs, std::chrono::duration<double, std::micro>(Clock::now() - q0).count());
+        histWritten += dev->history.written();
+        histSamples += hs.samples;
+        histPoints += hs.t.size();
+    }
+    io->stop();
+    removeLinks();
+
+    fmt::print("Ricevuti: {} frame validi -> {:.0f} frame/s sostenuti su {} thread di IO (protocollo {})\n",
+        st.frames, static_cast<double>(st.frames) / elapsed, 1, DeckProtocolName(st.protocol));
+    fmt::print("Errori: parse={} crc={} seq_gaps={}  |  coalesced={} backlog_peak={}\n",
+        st.parseErrors, st.crcErrors, st.seqGaps, st.coalesced, st.backlogPeak);
+    for (const auto& f : filters)
+        fmt::print("Filtro {:<10} in={} out={} soppressi={}\n", FilterStageName(f.kind), f.in[0], f.out[0], f.suppressed[0]);
+    if (opt.pattern == EmuPattern::Buttons || opt.pattern == EmuPattern::Mix) {
+        uint64_t presses = 0, releases = 0;
+        for (auto& dev : devs) { presses += dev->presses; releases += dev->releases; }
+        // ogni raffica è un press con un rimbalzo: 1 press con il debounce, 2 senza
+        fmt::print("Bottoni (debounce {} ms): {} raffiche x {} device -> {} press, {} release dalla coda (persi {})\n",
+            opt.debounceMs, bursts, devs.size(), presses, releases, st.edgeDrops);
+    }
+    fmt::print("Aggiornamenti store (device 0): {}, impronta {:016x}\n", devs[0]->updates, devs[0]->fingerprint);
+    fmt::print("Storico: {} campioni registrati, query slider 0 -> {} punti da {} campioni (max {:.1f} us per query)\n",
+        histWritten, histPoints, histSamples, histUs);
+    if (opt.dropEvery > 0) fmt::print("Scollegamenti: {} per device -> riconnessioni: {}\n", drops, st.reconnects);
+    fmt::print("Latenza emulatore -> store ({} campioni): p50={:.1f} us  p90={:.1f} us  p99={:.1f} us  p99.9={:.1f} us  max={:.1f} us\n",
+        latencies.size(),
+        Percentile(latencies, 0.50), Percentile(latencies, 0.90), Percentile(latencies, 0.99),
+        Percentile(latencies, 0.999), Percentile(latencies, 1.0));
+    return 0;
+}